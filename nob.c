@@ -190,6 +190,39 @@ defer:
     return result;
 }
 
+static const char *main_sources[] = {
+    "./src/main.c",
+    "./src/sim.c",
+    "./src/crops.c",
+    "./src/timers.c",
+    "./src/tmx.c",
+    "./src/mapblob.c",
+    "./src/collision.c",
+    "./src/tilemask.c",
+    "./src/sprites.c",
+    "./src/tilechunks.c",
+    "./src/camera.c",
+    "./src/ecs.c",
+    "./src/anim.c",
+    "./src/animals.c",
+    "./src/jobs.c",
+    "./src/moisture.c",
+    "./src/save.c",
+    "./src/replay.c",
+    "./src/farmbot.c",
+    "./src/pages.c",
+    "./src/terrain.c",
+    "./src/autotile.c",
+    "./src/profiler.c",
+};
+
+void cmd_append_main_sources(Nob_Cmd *cmd)
+{
+    for (size_t i = 0; i < NOB_ARRAY_LEN(main_sources); ++i) {
+        nob_cmd_append(cmd, main_sources[i]);
+    }
+}
+
 bool build_main(Config config)
 {
     bool result = true;
@@ -224,9 +257,8 @@ bool build_main(Config config)
                         nob_cmd_append(&cmd, "-I./raylib/raylib-4.5.0/src/");
                         nob_cmd_append(&cmd, "-DHOTRELOAD");
                         nob_cmd_append(&cmd, "-o", "./build/main");
-                        nob_cmd_append(&cmd,
-                            "./src/main.c",
-                            "./src/hotreload_linux.c");
+                        cmd_append_main_sources(&cmd);
+                        nob_cmd_append(&cmd, "./src/hotreload_linux.c");
                         nob_cmd_append(&cmd,
                             "-Wl,-rpath=./build/",
                             "-Wl,-rpath=./",
@@ -247,7 +279,7 @@ bool build_main(Config config)
                     if (config.microphone) nob_cmd_append(&cmd, "-DFEATURE_MICROPHONE");
                     nob_cmd_append(&cmd, "-I./raylib/raylib-4.5.0/src/");
                     nob_cmd_append(&cmd, "-o", "./build/main");
-                    nob_cmd_append(&cmd, "./src/main.c");
+                    cmd_append_main_sources(&cmd);
                     nob_cmd_append(&cmd,
                         nob_temp_sprintf("-L./build/raylib/%s", NOB_ARRAY_GET(target_names, config.target)),
                         "-l:libraylib.a");
@@ -268,7 +300,7 @@ bool build_main(Config config)
                 if (config.microphone) nob_cmd_append(&cmd, "-DFEATURE_MICROPHONE");
                 nob_cmd_append(&cmd, "-I./raylib/raylib-4.5.0/src/");
                 nob_cmd_append(&cmd, "-o", "./build/main");
-                nob_cmd_append(&cmd, "./src/main.c");
+                cmd_append_main_sources(&cmd);
                 nob_cmd_append(&cmd,
                     nob_temp_sprintf("./build/raylib/%s/libraylib.a", NOB_ARRAY_GET(target_names, config.target)));
 
@@ -300,7 +332,8 @@ bool build_main(Config config)
                     if (config.microphone) nob_cmd_append(&cmd, "-DFEATURE_MICROPHONE");
                     nob_cmd_append(&cmd, "-I./raylib/raylib-4.5.0/src/");
                     nob_cmd_append(&cmd, "-o", "./build/main");
-                    nob_cmd_append(&cmd, "./src/main.c", "./build/main.res");
+                    cmd_append_main_sources(&cmd);
+                    nob_cmd_append(&cmd, "./build/main.res");
                     nob_cmd_append(&cmd,
                         nob_temp_sprintf("-L./build/raylib/%s", NOB_ARRAY_GET(target_names, config.target)),
                         "-l:libraylib.a");
@@ -320,11 +353,9 @@ bool build_main(Config config)
                     if (config.microphone) nob_cmd_append(&cmd, "/DFEATURE_MICROPHONE");
                     nob_cmd_append(&cmd, "/I", "./raylib/raylib-4.5.0/src/");
                     nob_cmd_append(&cmd, "/Fobuild\\", "/Febuild\\main.exe");
-                    nob_cmd_append(&cmd,
-                        "./src/main.c",
-                        // TODO: building resource file is not implemented for TARGET_WIN64_MSVC
-                        //"./build/main.res"
-                        );
+                    cmd_append_main_sources(&cmd);
+                    // TODO: building resource file is not implemented for TARGET_WIN64_MSVC
+                    //nob_cmd_append(&cmd, "./build/main.res");
                     nob_cmd_append(&cmd,
                         "/link",
                         nob_temp_sprintf("/LIBPATH:build/raylib/%s", NOB_ARRAY_GET(target_names, config.target)),
@@ -552,6 +583,189 @@ bool build_dist(Config config)
     return true;
 }
 
+static const char *bench_sources[] = {
+    "./src/bench.c",
+    "./src/crops.c",
+    "./src/timers.c",
+    "./src/collision.c",
+    "./src/ecs.c",
+    "./src/anim.c",
+    "./src/animals.c",
+    "./src/jobs.c",
+    "./src/moisture.c",
+    "./src/mapblob.c",
+    "./src/tmx.c",
+    "./src/terrain.c",
+    "./src/autotile.c",
+    "./src/pages.c",
+    "./src/profiler.c",
+    "./src/sim.c",
+    "./src/tilemask.c",
+    "./src/save.c",
+    "./src/farmbot.c",
+};
+
+static const char *mapc_sources[] = {
+    "./src/mapc.c",
+    "./src/tmx.c",
+    "./src/mapblob.c",
+};
+
+static const char *maps[] = {
+    "./resources/tilesets/map.tmx",
+    "./resources/tilesets/map2.tmx",
+};
+
+// Everything a baked map depends on besides its own .tmx.
+static const char *map_deps[] = {
+    "./resources/tilesets/biome.tsx",
+    "./resources/tilesets/dirt.tsx",
+    "./resources/tilesets/grass.tsx",
+    "./resources/tilesets/hills.tsx",
+    "./resources/tilesets/house.tsx",
+    "./resources/tilesets/paths.tsx",
+    "./resources/tilesets/water.tsx",
+    "./src/mapblob.h",
+    "./src/mapblob.c",
+    "./src/tmx.c",
+};
+
+static const char *atlasc_sources[] = {
+    "./src/atlasc.c",
+};
+
+#define ATLAS_PAGE_PREFIX "resources/atlas/atlas"
+#define ATLAS_HEADER "./src/atlas_gen.h"
+
+// Everything that gets packed into the texture atlas, as NAME=path. NAME becomes ATLAS_NAME in
+// atlas_gen.h.
+static const char *atlas_sheets[] = {
+    "PLAYER=resources/sprout-lands-sprites/Characters/basic-character-spritesheet.png",
+    "TOOLS=resources/sprout-lands-sprites/Characters/Tools.png",
+    "CHICKEN=resources/sprout-lands-sprites/Characters/free-chicken-sprites.png",
+    "COW=resources/sprout-lands-sprites/Characters/free-cow-sprites.png",
+    "PLANTS=resources/sprout-lands-sprites/Objects/Basic_Plants.png",
+    "ITEMS=resources/sprout-lands-sprites/Objects/Basic_tools_and_materials.png",
+    "BIOME=resources/sprout-lands-sprites/Objects/Basic_Grass_Biom_things.png",
+    "PATHS=resources/sprout-lands-sprites/Objects/Paths.png",
+    "GRASS=resources/sprout-lands-sprites/Tilesets/Grass.png",
+    "HILLS=resources/sprout-lands-sprites/Tilesets/Hills.png",
+    "DIRT=resources/sprout-lands-sprites/Tilesets/Tilled_Dirt.png",
+    "WATER=resources/sprout-lands-sprites/Tilesets/Water.png",
+    "HOUSE=resources/sprout-lands-sprites/Tilesets/Wooden House.png",
+};
+
+// Tools like the benchmarks and the map baker always run on the machine that builds them, so they
+// ignore build.conf and go with whatever the host is. `optimize` also builds for the host CPU,
+// otherwise the SIMD paths in the benchmarks never get picked.
+bool build_host_tool(const char *output_path, const char **sources, size_t sources_count, bool optimize)
+{
+    bool result = true;
+    Nob_Cmd cmd = {0};
+    Config config = {0};
+
+    if (!nob_mkdir_if_not_exists("build")) nob_return_defer(false);
+    if (!compute_default_config(&config)) nob_return_defer(false);
+
+    switch (config.target) {
+        case TARGET_LINUX:
+        case TARGET_MACOS: {
+            cmd.count = 0;
+                nob_cmd_append(&cmd, config.target == TARGET_MACOS ? "clang" : "cc");
+                nob_cmd_append(&cmd, "-Wall", "-Wextra", "-ggdb");
+                if (optimize) nob_cmd_append(&cmd, "-O2", "-march=native");
+                nob_cmd_append(&cmd, "-I./raylib/raylib-4.5.0/src/");
+                nob_cmd_append(&cmd, "-o", output_path);
+                for (size_t i = 0; i < sources_count; ++i) {
+                    nob_cmd_append(&cmd, sources[i]);
+                }
+                nob_cmd_append(&cmd, "-lm", "-lpthread", "-lexpat");
+            if (!nob_cmd_run_sync(cmd)) nob_return_defer(false);
+        } break;
+
+        case TARGET_WIN64_MINGW:
+        case TARGET_WIN64_MSVC: {
+            nob_log(NOB_ERROR, "TODO: building %s is not supported on %s yet", output_path, NOB_ARRAY_GET(target_names, config.target));
+            nob_return_defer(false);
+        } break;
+
+        default: NOB_ASSERT(0 && "unreachable");
+    }
+
+defer:
+    nob_cmd_free(cmd);
+    return result;
+}
+
+// Runs on every build, the game loads the blobs over the .tmx whenever they're there, so one that
+// missed an edit to the map or a tileset would quietly win. Only builds the baker when something
+// actually needs baking.
+bool bake_maps(void)
+{
+    bool result = true;
+    Nob_Cmd cmd = {0};
+    Nob_File_Paths inputs = {0};
+    bool baker_built = false;
+
+    for (size_t i = 0; i < NOB_ARRAY_LEN(maps); ++i) {
+        const char *input_path = maps[i];
+        const char *output_path = nob_temp_sprintf("%.*s.bin", (int)(strlen(input_path) - strlen(".tmx")), input_path);
+
+        inputs.count = 0;
+        nob_da_append(&inputs, input_path);
+        nob_da_append_many(&inputs, map_deps, NOB_ARRAY_LEN(map_deps));
+
+        const int needs_rebuild = nob_needs_rebuild(output_path, inputs.items, inputs.count);
+        if (needs_rebuild < 0) nob_return_defer(false);
+        if (needs_rebuild) {
+            if (!baker_built) {
+                if (!build_host_tool("./build/mapc", mapc_sources, NOB_ARRAY_LEN(mapc_sources), false)) nob_return_defer(false);
+                baker_built = true;
+            }
+            cmd.count = 0;
+            nob_cmd_append(&cmd, "./build/mapc", input_path, output_path);
+            if (!nob_cmd_run_sync(cmd)) nob_return_defer(false);
+        } else {
+            nob_log(NOB_INFO, "%s is up to date", output_path);
+        }
+    }
+
+defer:
+    nob_cmd_free(cmd);
+    nob_da_free(inputs);
+    return result;
+}
+
+bool bake_atlas(void)
+{
+    bool result = true;
+    Nob_Cmd cmd = {0};
+    Nob_File_Paths inputs = {0};
+
+    if (!build_host_tool("./build/atlasc", atlasc_sources, NOB_ARRAY_LEN(atlasc_sources), false)) nob_return_defer(false);
+    if (!nob_mkdir_if_not_exists("./resources/atlas")) nob_return_defer(false);
+
+    for (size_t i = 0; i < NOB_ARRAY_LEN(atlas_sheets); ++i) {
+        nob_da_append(&inputs, strchr(atlas_sheets[i], '=') + 1);
+    }
+    nob_da_append(&inputs, "./src/atlasc.c");
+    // The list of sheets lives in here.
+    nob_da_append(&inputs, "./nob.c");
+
+    if (nob_needs_rebuild(ATLAS_HEADER, inputs.items, inputs.count)) {
+        nob_cmd_append(&cmd, "./build/atlasc", ATLAS_PAGE_PREFIX, ATLAS_HEADER);
+        nob_da_append_many(&cmd, atlas_sheets, NOB_ARRAY_LEN(atlas_sheets));
+        if (!nob_cmd_run_sync(cmd)) nob_return_defer(false);
+    } else {
+        nob_log(NOB_INFO, "%s is up to date", ATLAS_HEADER);
+    }
+
+defer:
+    nob_cmd_free(cmd);
+    nob_da_free(inputs);
+    return result;
+}
+
 void log_available_subcommands(const char *program, Nob_Log_Level level)
 {
     nob_log(level, "Usage: %s [subcommand]", program);
@@ -559,7 +773,10 @@ void log_available_subcommands(const char *program, Nob_Log_Level level)
     nob_log(level, "    build (default)");
     nob_log(level, "    config");
     nob_log(level, "    dist");
+    nob_log(level, "    bench [name]");
     nob_log(level, "    svg");
+    nob_log(level, "    map");
+    nob_log(level, "    atlas");
     nob_log(level, "    help");
 }
 
@@ -594,6 +811,7 @@ int main(int argc, char **argv)
         log_config(config);
         nob_log(NOB_INFO, "------------------------------");
         if (!build_raylib(config)) return 1;
+        if (!bake_maps()) return 1;
         if (!build_main(config)) return 1;
         if (config.target == TARGET_WIN64_MINGW || config.target == TARGET_WIN64_MSVC) {
             if (!nob_copy_file("main-logged.bat", "build/main-logged.bat")) return 1;
@@ -615,6 +833,16 @@ int main(int argc, char **argv)
         log_config(config);
         nob_log(NOB_INFO, "------------------------------");
         if (!build_dist(config)) return 1;
+    } else if (strcmp(subcommand, "bench") == 0) {
+        if (!build_host_tool("./build/bench", bench_sources, NOB_ARRAY_LEN(bench_sources), true)) return 1;
+        Nob_Cmd cmd = {0};
+        nob_cmd_append(&cmd, "./build/bench");
+        if (argc > 0) nob_cmd_append(&cmd, nob_shift_args(&argc, &argv));
+        if (!nob_cmd_run_sync(cmd)) return 1;
+    } else if (strcmp(subcommand, "map") == 0) {
+        if (!bake_maps()) return 1;
+    } else if (strcmp(subcommand, "atlas") == 0) {
+        if (!bake_atlas()) return 1;
     } else if (strcmp(subcommand, "svg") == 0) {
         Nob_Procs procs = {0};
 
@@ -3,20 +3,48 @@
  <image source="../sprout-lands-sprites/Tilesets/Tilled_Dirt.png" width="176" height="112"/>
  <tile id="1" probability="0.25"/>
  <tile id="11" probability="0.5"/>
- <tile id="12" probability="0.75"/>
+ <tile id="12" probability="0.75">
+  <properties>
+   <property name="farmable" type="bool" value="true"/>
+  </properties>
+ </tile>
  <tile id="13" probability="0.5"/>
  <tile id="23" probability="0.5"/>
- <tile id="55" probability="0.02"/>
- <tile id="56" probability="0.02"/>
- <tile id="57" probability="0.02"/>
+ <tile id="55" probability="0.02">
+  <properties>
+   <property name="farmable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="56" probability="0.02">
+  <properties>
+   <property name="farmable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="57" probability="0.02">
+  <properties>
+   <property name="farmable" type="bool" value="true"/>
+  </properties>
+ </tile>
  <tile id="60" probability="0.25"/>
  <tile id="61" probability="0.25"/>
  <tile id="62" probability="0.25"/>
  <tile id="63" probability="0.25"/>
  <tile id="64" probability="0.25"/>
- <tile id="66" probability="0.02"/>
- <tile id="67" probability="0.02"/>
- <tile id="68" probability="0.02"/>
+ <tile id="66" probability="0.02">
+  <properties>
+   <property name="farmable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="67" probability="0.02">
+  <properties>
+   <property name="farmable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="68" probability="0.02">
+  <properties>
+   <property name="farmable" type="bool" value="true"/>
+  </properties>
+ </tile>
  <tile id="71" probability="0.25"/>
  <tile id="72" probability="0.25"/>
  <tile id="74" probability="0.25"/>
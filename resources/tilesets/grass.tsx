@@ -1,19 +1,71 @@
 <?xml version="1.0" encoding="UTF-8"?>
 <tileset version="1.10" tiledversion="1.10.2" name="grass" tilewidth="16" tileheight="16" tilecount="77" columns="11">
  <image source="../sprout-lands-sprites/Tilesets/Grass.png" width="176" height="112"/>
- <tile id="12" probability="0.75"/>
- <tile id="55" probability="0.02"/>
- <tile id="56" probability="0.01"/>
- <tile id="57" probability="0.01"/>
- <tile id="58" probability="0.005"/>
- <tile id="59" probability="0.005"/>
- <tile id="60" probability="0.005"/>
- <tile id="66" probability="0.02"/>
- <tile id="67" probability="0.01"/>
- <tile id="68" probability="0.01"/>
- <tile id="69" probability="0.005"/>
- <tile id="70" probability="0.005"/>
- <tile id="71" probability="0.005"/>
+ <tile id="12" probability="0.75">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="55" probability="0.02">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="56" probability="0.01">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="57" probability="0.01">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="58" probability="0.005">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="59" probability="0.005">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="60" probability="0.005">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="66" probability="0.02">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="67" probability="0.01">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="68" probability="0.01">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="69" probability="0.005">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="70" probability="0.005">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="71" probability="0.005">
+  <properties>
+   <property name="tillable" type="bool" value="true"/>
+  </properties>
+ </tile>
  <wangsets>
   <wangset name="Unnamed Set" type="mixed" tile="-1">
    <wangcolor name="" color="#ff0000" tile="-1" probability="1"/>
@@ -1,4 +1,28 @@
 <?xml version="1.0" encoding="UTF-8"?>
 <tileset version="1.10" tiledversion="1.10.2" name="water" tilewidth="16" tileheight="16" tilecount="4" columns="4">
  <image source="../sprout-lands-sprites/Tilesets/Water.png" width="64" height="16"/>
+ <tile id="0">
+  <properties>
+   <property name="solid" type="bool" value="true"/>
+   <property name="water" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="1">
+  <properties>
+   <property name="solid" type="bool" value="true"/>
+   <property name="water" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="2">
+  <properties>
+   <property name="solid" type="bool" value="true"/>
+   <property name="water" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="3">
+  <properties>
+   <property name="solid" type="bool" value="true"/>
+   <property name="water" type="bool" value="true"/>
+  </properties>
+ </tile>
 </tileset>
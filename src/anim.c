@@ -0,0 +1,189 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nob.h"
+#define ATLAS_GEN_NAMES
+#include "anim.h"
+
+// Longest line of the clips file we bother with.
+#define ANIM_LINE_CAPACITY 256
+
+static bool anim_parse_sheet(const char *name, AtlasSheet *sheet) {
+    for (int i = 0; i < ATLAS_SHEET_COUNT; i++) {
+        if (strcmp(atlas_sheet_names[i], name) == 0) {
+            *sheet = (AtlasSheet)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// A clip is done once the next one starts or the file ends, it better have frames by then.
+static bool anim_finish_clip(const AnimLibrary *lib, const char *path, unsigned long line) {
+    if (lib->clips.count == 0) return true;
+
+    const AnimClip *clip = &lib->clips.items[lib->clips.count - 1];
+    if (clip->frame_count == 0) {
+        fprintf(stderr, "%s:%lu: ERROR: clip %s has no frames\n", path, line, clip->name);
+        return false;
+    }
+    return true;
+}
+
+bool anim_library_load(AnimLibrary *lib, const char *path, int ticks_per_second) {
+    memset(lib, 0, sizeof(*lib));
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    bool ok = true;
+    char buffer[ANIM_LINE_CAPACITY];
+    unsigned long line = 0;
+    while (ok && fgets(buffer, sizeof(buffer), f) != NULL) {
+        line++;
+
+        const char *keyword = strtok(buffer, " \t\r\n");
+        if (keyword == NULL || keyword[0] == '#') continue;
+
+        if (strcmp(keyword, "clip") == 0) {
+            const char *name = strtok(NULL, " \t\r\n");
+            const char *sheet = strtok(NULL, " \t\r\n");
+            const char *mode = strtok(NULL, " \t\r\n");
+            if (name == NULL || sheet == NULL || mode == NULL) {
+                fprintf(stderr, "%s:%lu: ERROR: expected `clip <name> <SHEET> loop|once`\n", path, line);
+                ok = false;
+                break;
+            }
+            if (strlen(name) >= ANIM_CLIP_NAME_CAPACITY) {
+                fprintf(stderr, "%s:%lu: ERROR: clip name %s is too long\n", path, line, name);
+                ok = false;
+                break;
+            }
+            if (anim_find_clip(lib, name) != ANIM_CLIP_NONE) {
+                fprintf(stderr, "%s:%lu: ERROR: clip %s is defined twice\n", path, line, name);
+                ok = false;
+                break;
+            }
+            if (!anim_finish_clip(lib, path, line)) {
+                ok = false;
+                break;
+            }
+
+            AnimClip clip = {
+                .first_frame = (uint32_t)lib->frames.count,
+                .first_tick = (uint32_t)lib->ticks.count,
+            };
+            strcpy(clip.name, name);
+            if (!anim_parse_sheet(sheet, &clip.sheet)) {
+                fprintf(stderr, "%s:%lu: ERROR: no atlas sheet called %s\n", path, line, sheet);
+                ok = false;
+                break;
+            }
+            if (strcmp(mode, "loop") == 0) {
+                clip.loop = true;
+            } else if (strcmp(mode, "once") != 0) {
+                fprintf(stderr, "%s:%lu: ERROR: expected loop or once, got %s\n", path, line, mode);
+                ok = false;
+                break;
+            }
+            assert(lib->clips.count < ANIM_CLIP_NONE);
+            nob_da_append(&lib->clips, clip);
+        } else if (strcmp(keyword, "frame") == 0) {
+            if (lib->clips.count == 0) {
+                fprintf(stderr, "%s:%lu: ERROR: frame outside of a clip\n", path, line);
+                ok = false;
+                break;
+            }
+
+            float rect[4];
+            long millis = 0;
+            bool parsed = true;
+            for (int i = 0; i < 4 && parsed; i++) {
+                const char *field = strtok(NULL, " \t\r\n");
+                char *end = NULL;
+                rect[i] = field == NULL ? 0.0f : strtof(field, &end);
+                parsed = field != NULL && *end == '\0';
+            }
+            const char *field = strtok(NULL, " \t\r\n");
+            if (parsed) {
+                char *end = NULL;
+                millis = field == NULL ? 0 : strtol(field, &end, 10);
+                parsed = field != NULL && *end == '\0' && millis > 0;
+            }
+            if (!parsed) {
+                fprintf(stderr, "%s:%lu: ERROR: expected `frame <x> <y> <width> <height> <millis>`\n", path, line);
+                ok = false;
+                break;
+            }
+
+            const uint32_t frame = (uint32_t)lib->frames.count;
+            nob_da_append(&lib->frames, ((Rectangle) { rect[0], rect[1], rect[2], rect[3] }));
+
+            long ticks = (millis * ticks_per_second + 500) / 1000;
+            if (ticks < 1) ticks = 1;
+            for (long t = 0; t < ticks; t++) nob_da_append(&lib->ticks, frame);
+
+            AnimClip *clip = &lib->clips.items[lib->clips.count - 1];
+            clip->frame_count++;
+            clip->length += (uint32_t)ticks;
+        } else {
+            fprintf(stderr, "%s:%lu: ERROR: unknown keyword %s\n", path, line, keyword);
+            ok = false;
+        }
+    }
+
+    if (ok) ok = anim_finish_clip(lib, path, line);
+    fclose(f);
+
+    if (!ok) anim_library_free(lib);
+    return ok;
+}
+
+void anim_library_free(AnimLibrary *lib) {
+    nob_da_free(lib->clips);
+    nob_da_free(lib->frames);
+    nob_da_free(lib->ticks);
+    memset(lib, 0, sizeof(*lib));
+}
+
+uint16_t anim_find_clip(const AnimLibrary *lib, const char *name) {
+    for (size_t i = 0; i < lib->clips.count; i++) {
+        if (strcmp(lib->clips.items[i].name, name) == 0) return (uint16_t)i;
+    }
+    return ANIM_CLIP_NONE;
+}
+
+// Cursors -----------------------------------------------------------------------------------------
+
+void anim_play(AnimCursor *cursor, uint16_t clip) {
+    if (cursor->clip != clip) anim_restart(cursor, clip);
+}
+
+void anim_restart(AnimCursor *cursor, uint16_t clip) {
+    cursor->clip = clip;
+    cursor->time = 0;
+}
+
+void anim_advance(const AnimLibrary *lib, AnimCursor *cursor, uint32_t ticks) {
+    if (cursor->clip == ANIM_CLIP_NONE) return;
+
+    const AnimClip *clip = anim_clip(lib, *cursor);
+    if (clip->loop) {
+        cursor->time = (cursor->time + ticks) % clip->length;
+    } else {
+        cursor->time = cursor->time + ticks < clip->length ? cursor->time + ticks : clip->length;
+    }
+}
+
+bool anim_finished(const AnimLibrary *lib, AnimCursor cursor) {
+    if (cursor.clip == ANIM_CLIP_NONE) return true;
+
+    const AnimClip *clip = anim_clip(lib, cursor);
+    return !clip->loop && cursor.time >= clip->length;
+}
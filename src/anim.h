@@ -0,0 +1,77 @@
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <raylib.h>
+
+#include "atlas_gen.h"
+
+// Sprite animation clips loaded from a text file instead of being worked out from the clock in
+// the draw code. The file is a list of clips, each followed by its frames:
+//
+//     # comment
+//     clip <name> <SHEET> loop|once
+//     frame <x> <y> <width> <height> <millis>
+//
+// where SHEET is one of the AtlasSheet names (PLAYER, CHICKEN, ...) and the frame rect is in pixels
+// of that sheet. On load every clip gets a table with the frame to show on each tick of it, so
+// sampling a clip is a single lookup no matter how many frames it has.
+//
+// Clips are shared, whatever plays one only holds an AnimCursor into it.
+
+#define ANIM_CLIPS_PATH "resources/animations.txt"
+#define ANIM_CLIP_NAME_CAPACITY 32
+#define ANIM_CLIP_NONE UINT16_MAX
+
+typedef struct AnimClip {
+    char name[ANIM_CLIP_NAME_CAPACITY];
+    AtlasSheet sheet;
+    bool loop;
+    // Frames of the clip are `frames[first_frame .. first_frame + frame_count]` of the library.
+    uint32_t first_frame, frame_count;
+    // Ticks it takes to play once, and where its tick -> frame table starts in `ticks`.
+    uint32_t length;
+    uint32_t first_tick;
+} AnimClip;
+
+typedef struct AnimLibrary {
+    struct { AnimClip *items; size_t count, capacity; } clips;
+    struct { Rectangle *items; size_t count, capacity; } frames;
+    // For every tick of every clip, the index of the frame it shows.
+    struct { uint32_t *items; size_t count, capacity; } ticks;
+} AnimLibrary;
+
+typedef struct AnimCursor {
+    uint16_t clip;
+    // Ticks into the clip. Wraps around for looping clips, sticks at `length` for the others.
+    uint32_t time;
+} AnimCursor;
+
+// Durations in the file get rounded to whole ticks at `ticks_per_second`, but never below one.
+bool anim_library_load(AnimLibrary *lib, const char *path, int ticks_per_second);
+void anim_library_free(AnimLibrary *lib);
+
+// ANIM_CLIP_NONE if there's no clip called that.
+uint16_t anim_find_clip(const AnimLibrary *lib, const char *name);
+
+// Switches to `clip` from its first frame, unless it's already playing.
+void anim_play(AnimCursor *cursor, uint16_t clip);
+// Switches to `clip` from its first frame, even if it's already playing.
+void anim_restart(AnimCursor *cursor, uint16_t clip);
+void anim_advance(const AnimLibrary *lib, AnimCursor *cursor, uint32_t ticks);
+bool anim_finished(const AnimLibrary *lib, AnimCursor cursor);
+
+static inline const AnimClip *anim_clip(const AnimLibrary *lib, AnimCursor cursor) {
+    return &lib->clips.items[cursor.clip];
+}
+
+// The frame rect the cursor is on.
+static inline Rectangle anim_sample(const AnimLibrary *lib, AnimCursor cursor) {
+    const AnimClip *clip = anim_clip(lib, cursor);
+    const uint32_t time = cursor.time < clip->length ? cursor.time : clip->length - 1;
+    return lib->frames.items[lib->ticks.items[clip->first_tick + time]];
+}
+
+#endif // ANIM_H_
@@ -0,0 +1,293 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nob.h"
+#include "animals.h"
+
+typedef struct AnimalKindInfo {
+    const char *idle_clip, *walk_clip;
+    // How big it gets drawn in the world.
+    float draw_size;
+    float speed;
+    uint32_t wander_interval;
+} AnimalKindInfo;
+
+// Intervals are in ticks, at 144 ticks per second.
+static const AnimalKindInfo animal_kinds[ANIMAL_KIND_COUNT] = {
+    [ANIMAL_CHICKEN] = {
+        .idle_clip = "chicken_idle",
+        .walk_clip = "chicken_walk",
+        .draw_size = 64.0f,
+        .speed = 50.0f,
+        .wander_interval = 288,
+    },
+    [ANIMAL_COW] = {
+        .idle_clip = "cow_idle",
+        .walk_clip = "cow_walk",
+        .draw_size = 96.0f,
+        .speed = 30.0f,
+        .wander_interval = 576,
+    },
+};
+
+static uint32_t animals_xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static uint16_t animals_find_clip(const AnimLibrary *clips, const char *name) {
+    const uint16_t clip = anim_find_clip(clips, name);
+    if (clip == ANIM_CLIP_NONE) fprintf(stderr, "ERROR: animation clip %s is missing\n", name);
+    assert(clip != ANIM_CLIP_NONE);
+    return clip;
+}
+
+void animals_init(Animals *animals, TimerWheel *timers, const AnimLibrary *clips, Rectangle bounds, uint32_t seed) {
+    memset(animals, 0, sizeof(*animals));
+    component_store_init(&animals->transforms, sizeof(TransformComponent));
+    component_store_init(&animals->colliders, sizeof(ColliderComponent));
+    component_store_init(&animals->sprites, sizeof(SpriteComponent));
+    component_store_init(&animals->animations, sizeof(AnimationComponent));
+    component_store_init(&animals->wanderers, sizeof(WanderComponent));
+    animals->bounds = bounds;
+    animals->timers = timers;
+    animals->clips = clips;
+    for (int kind = 0; kind < ANIMAL_KIND_COUNT; kind++) {
+        animals->kind_clips[kind][0] = animals_find_clip(clips, animal_kinds[kind].idle_clip);
+        animals->kind_clips[kind][1] = animals_find_clip(clips, animal_kinds[kind].walk_clip);
+    }
+    // xorshift gets stuck on 0.
+    animals->rng = seed != 0 ? seed : 1;
+}
+
+void animals_free(Animals *animals) {
+    for (size_t i = 0; i < animals->wanderers.count; i++) {
+        timer_cancel(animals->timers, ((WanderComponent *)animals->wanderers.data)[i].timer);
+    }
+    entity_pool_free(&animals->entities);
+    component_store_free(&animals->transforms);
+    component_store_free(&animals->colliders);
+    component_store_free(&animals->sprites);
+    component_store_free(&animals->animations);
+    component_store_free(&animals->wanderers);
+    nob_da_free(animals->movers);
+    memset(animals, 0, sizeof(*animals));
+}
+
+// AI ----------------------------------------------------------------------------------------------
+
+// One of the eight directions at the animal's speed, or standing still.
+static void animal_pick_heading(Animals *animals, Entity entity) {
+    WanderComponent *wander = component_get(&animals->wanderers, entity);
+    TransformComponent *transform = component_get(&animals->transforms, entity);
+    if (wander == NULL || transform == NULL) return;
+
+    const int choice = animals_xorshift32(&wander->rng) % 9;
+    if (choice == 8) {
+        transform->velocity = (Vector2) { 0 };
+        return;
+    }
+
+    const float angle = choice * (PI / 4.0f);
+    transform->velocity = (Vector2) { cosf(angle) * wander->speed, sinf(angle) * wander->speed };
+}
+
+static void on_animal_wander(void *ctx, uint32_t entity, uint64_t now) {
+    Animals *animals = ctx;
+    WanderComponent *wander = component_get(&animals->wanderers, entity);
+    if (wander == NULL) return;
+
+    animal_pick_heading(animals, entity);
+    wander->timer = timer_schedule(animals->timers, now + wander->interval, on_animal_wander, animals, entity);
+}
+
+// Entities ----------------------------------------------------------------------------------------
+
+Vector2 animal_collider_size(AnimalKind kind) {
+    const float size = animal_kinds[kind].draw_size;
+    return (Vector2) { size, size };
+}
+
+Entity animal_spawn(Animals *animals, AnimalKind kind, Vector2 position) {
+    assert(kind >= 0 && kind < ANIMAL_KIND_COUNT);
+    const AnimalKindInfo *info = &animal_kinds[kind];
+    const Entity entity = entity_create(&animals->entities);
+
+    TransformComponent *transform = component_add(&animals->transforms, entity);
+    transform->position = position;
+
+    ColliderComponent *collider = component_add(&animals->colliders, entity);
+    collider->size = animal_collider_size(kind);
+
+    AnimationComponent *animation = component_add(&animals->animations, entity);
+    animation->idle_clip = animals->kind_clips[kind][0];
+    animation->walk_clip = animals->kind_clips[kind][1];
+    anim_restart(&animation->cursor, animation->idle_clip);
+    // Start somewhere in the clip so a herd spawned on the same tick doesn't flap in lockstep.
+    anim_advance(animals->clips, &animation->cursor, animals_xorshift32(&animals->rng));
+
+    SpriteComponent *sprite = component_add(&animals->sprites, entity);
+    sprite->sheet = anim_clip(animals->clips, animation->cursor)->sheet;
+    sprite->src = anim_sample(animals->clips, animation->cursor);
+    sprite->size = (Vector2) { info->draw_size, info->draw_size };
+
+    WanderComponent *wander = component_add(&animals->wanderers, entity);
+    wander->speed = info->speed;
+    wander->interval = info->wander_interval;
+    // Never 0 out of a xorshift that isn't stuck on it.
+    wander->rng = animals_xorshift32(&animals->rng);
+    // Spread the first turn out too, or the whole herd turns on the same tick forever.
+    const uint64_t first_turn = animals->timers->now + 1 + animals_xorshift32(&animals->rng) % info->wander_interval;
+    wander->timer = timer_schedule(animals->timers, first_turn, on_animal_wander, animals, entity);
+
+    return entity;
+}
+
+void animal_despawn(Animals *animals, Entity entity) {
+    if (!entity_is_alive(&animals->entities, entity)) return;
+
+    const WanderComponent *wander = component_get(&animals->wanderers, entity);
+    if (wander != NULL) timer_cancel(animals->timers, wander->timer);
+
+    component_remove(&animals->transforms, entity);
+    component_remove(&animals->colliders, entity);
+    component_remove(&animals->sprites, entity);
+    component_remove(&animals->animations, entity);
+    component_remove(&animals->wanderers, entity);
+    entity_destroy(&animals->entities, entity);
+}
+
+AnimalKind animal_kind(const Animals *animals, Entity entity) {
+    const AnimationComponent *animation = component_get(&animals->animations, entity);
+    assert(animation != NULL);
+    for (int kind = 0; kind < ANIMAL_KIND_COUNT; kind++) {
+        if (animals->kind_clips[kind][0] == animation->idle_clip) return (AnimalKind)kind;
+    }
+    assert(false && "animal plays clips of no kind");
+    return ANIMAL_CHICKEN;
+}
+
+void animal_schedule_wander(Animals *animals, Entity entity, uint64_t due) {
+    WanderComponent *wander = component_get(&animals->wanderers, entity);
+    if (wander == NULL) return;
+
+    timer_cancel(animals->timers, wander->timer);
+    wander->timer = timer_schedule(animals->timers, due, on_animal_wander, animals, entity);
+}
+
+// Systems -----------------------------------------------------------------------------------------
+
+// Pushes `rect` back inside the bounds, returns whether it had to.
+static bool animals_clamp_to_bounds(const Animals *animals, Rectangle *rect) {
+    const Rectangle b = animals->bounds;
+    const float x = fminf(fmaxf(rect->x, b.x), b.x + b.width - rect->width);
+    const float y = fminf(fmaxf(rect->y, b.y), b.y + b.height - rect->height);
+    const bool clamped = x != rect->x || y != rect->y;
+    rect->x = x;
+    rect->y = y;
+    return clamped;
+}
+
+// How many animals a single job moves or animates. Enough that the collision sweeps of one job
+// dwarf the cost of handing it out.
+#define ANIMALS_JOB_GRAIN 512
+
+typedef struct AnimalsJob {
+    Animals *animals;
+    const CollisionWorld *collision;
+    float dt;
+} AnimalsJob;
+
+// Moves the colliders in [begin, end). Every animal only touches its own mover and transform, so
+// any number of these run at once.
+static void animals_move_job(void *ctx, size_t begin, size_t end) {
+    const AnimalsJob *job = ctx;
+    Animals *animals = job->animals;
+    const ColliderComponent *colliders = animals->colliders.data;
+    const Entity *entities = animals->colliders.entities;
+    CollisionMover *movers = animals->movers.items;
+
+    for (size_t i = begin; i < end; i++) {
+        const TransformComponent *transform = component_get_hint(&animals->transforms, entities[i], i);
+        movers[i] = (CollisionMover) {
+            .rect = { transform->position.x, transform->position.y, colliders[i].size.x, colliders[i].size.y },
+            .delta = { transform->velocity.x * job->dt, transform->velocity.y * job->dt },
+        };
+    }
+
+    collision_world_move(job->collision, movers + begin, end - begin);
+
+    for (size_t i = begin; i < end; i++) {
+        CollisionMover *mover = &movers[i];
+        // The bounds count as walking into something too, the turning pass only checks `blocked_x`.
+        if (animals_clamp_to_bounds(animals, &mover->rect)) mover->blocked_x = true;
+
+        TransformComponent *transform = component_get_hint(&animals->transforms, entities[i], i);
+        transform->position = (Vector2) { mover->rect.x, mover->rect.y };
+    }
+}
+
+static void animals_move(Animals *animals, const CollisionWorld *collision, JobSystem *jobs, float dt) {
+    const size_t count = animals->colliders.count;
+    const Entity *entities = animals->colliders.entities;
+
+    if (animals->movers.capacity < count) {
+        animals->movers.capacity = count;
+        animals->movers.items = realloc(animals->movers.items, count * sizeof(*animals->movers.items));
+        assert(animals->movers.items != NULL && "Buy more RAM lol");
+    }
+    animals->movers.count = count;
+
+    // Everything with a collider goes through the collision world, a batch per job.
+    AnimalsJob job = { .animals = animals, .collision = collision, .dt = dt };
+    job_parallel_for(jobs, count, ANIMALS_JOB_GRAIN, animals_move_job, &job);
+
+    // Walked into something, don't wait for the wander timer to turn around.
+    for (size_t i = 0; i < count; i++) {
+        const CollisionMover *mover = &animals->movers.items[i];
+        if (mover->blocked_x || mover->blocked_y) animal_pick_heading(animals, entities[i]);
+    }
+
+    // Whatever has no collider just goes where it's headed.
+    TransformComponent *transforms = animals->transforms.data;
+    for (size_t i = 0; i < animals->transforms.count; i++) {
+        if (component_get_hint(&animals->colliders, animals->transforms.entities[i], i) != NULL) continue;
+        transforms[i].position.x += transforms[i].velocity.x * dt;
+        transforms[i].position.y += transforms[i].velocity.y * dt;
+    }
+}
+
+static void animals_animate_job(void *ctx, size_t begin, size_t end) {
+    const AnimalsJob *job = ctx;
+    Animals *animals = job->animals;
+    const AnimLibrary *clips = animals->clips;
+    AnimationComponent *animations = animals->animations.data;
+    const Entity *entities = animals->animations.entities;
+
+    for (size_t i = begin; i < end; i++) {
+        AnimationComponent *animation = &animations[i];
+        SpriteComponent *sprite = component_get_hint(&animals->sprites, entities[i], i);
+        const TransformComponent *transform = component_get_hint(&animals->transforms, entities[i], i);
+
+        const bool moving = transform != NULL && (transform->velocity.x != 0.0f || transform->velocity.y != 0.0f);
+        anim_play(&animation->cursor, moving ? animation->walk_clip : animation->idle_clip);
+        anim_advance(clips, &animation->cursor, 1);
+
+        if (sprite == NULL) continue;
+        sprite->sheet = anim_clip(clips, animation->cursor)->sheet;
+        sprite->src = anim_sample(clips, animation->cursor);
+    }
+}
+
+void animals_update(Animals *animals, const CollisionWorld *collision, JobSystem *jobs, float dt) {
+    animals_move(animals, collision, jobs, dt);
+
+    AnimalsJob job = { .animals = animals };
+    job_parallel_for(jobs, animals->animations.count, ANIMALS_JOB_GRAIN, animals_animate_job, &job);
+}
@@ -0,0 +1,102 @@
+#ifndef ANIMALS_H_
+#define ANIMALS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <raylib.h>
+
+#include "anim.h"
+#include "atlas_gen.h"
+#include "collision.h"
+#include "ecs.h"
+#include "jobs.h"
+#include "timers.h"
+
+// Everything on the farm that walks around by itself. Every animal is an entity with a transform,
+// a collider, a sprite, an animation and a wander AI component (see ecs.h), and the systems in
+// animals_update() each walk one dense component array front to back, so a few thousand chickens
+// cost a few thousand array entries and not a few thousand pointer chases. Those arrays are also
+// what gets cut into chunks for the job system.
+
+typedef enum {
+    ANIMAL_CHICKEN = 0,
+    ANIMAL_COW,
+    ANIMAL_KIND_COUNT,
+} AnimalKind;
+
+typedef struct TransformComponent {
+    // Top left corner, in world units.
+    Vector2 position;
+    // World units per second.
+    Vector2 velocity;
+} TransformComponent;
+
+typedef struct ColliderComponent {
+    Vector2 size;
+} ColliderComponent;
+
+typedef struct SpriteComponent {
+    // The frame to draw, kept up to date by the animation system.
+    AtlasSheet sheet;
+    Rectangle src;
+    // In world units.
+    Vector2 size;
+} SpriteComponent;
+
+typedef struct AnimationComponent {
+    AnimCursor cursor;
+    uint16_t idle_clip, walk_clip;
+} AnimationComponent;
+
+typedef struct WanderComponent {
+    float speed;
+    // Picks a new heading when this fires, or right away after walking into something.
+    uint32_t interval;
+    TimerId timer;
+    // Its own xorshift state for the headings. Timers due on the same tick fire in whatever order
+    // the wheel has them in, which a loaded save doesn't keep, so they can't share one.
+    uint32_t rng;
+} WanderComponent;
+
+typedef struct Animals {
+    EntityPool entities;
+    ComponentStore transforms;
+    ComponentStore colliders;
+    ComponentStore sprites;
+    ComponentStore animations;
+    ComponentStore wanderers;
+
+    // Animals stay inside of this, its edges block them like any collision rect does.
+    Rectangle bounds;
+    TimerWheel *timers;
+    const AnimLibrary *clips;
+    // Idle and walk clip of every kind.
+    uint16_t kind_clips[ANIMAL_KIND_COUNT][2];
+    // State of the xorshift spawning draws from, it seeds the one of every animal. Part of the world
+    // so it's deterministic too.
+    uint32_t rng;
+
+    // Scratch for the movement system, one mover per collider.
+    struct { CollisionMover *items; size_t count, capacity; } movers;
+} Animals;
+
+// The wander timers point back at `animals`, so it must not move after this. Every kind needs its
+// clips in `clips`.
+void animals_init(Animals *animals, TimerWheel *timers, const AnimLibrary *clips, Rectangle bounds, uint32_t seed);
+void animals_free(Animals *animals);
+
+// Size of the collider an animal of that kind gets, for finding a free spot to spawn it on.
+Vector2 animal_collider_size(AnimalKind kind);
+Entity animal_spawn(Animals *animals, AnimalKind kind, Vector2 position);
+void animal_despawn(Animals *animals, Entity entity);
+// Worked out from the clips it plays, every kind has its own.
+AnimalKind animal_kind(const Animals *animals, Entity entity);
+// Moves the next wander turn of the animal to tick `due`, for restoring a saved one.
+void animal_schedule_wander(Animals *animals, Entity entity, uint64_t due);
+
+// Runs every system for one tick of `dt` seconds: movement against `collision`, then animation.
+// The wander AI runs off the timers in between. Both systems are split into jobs on `jobs` (NULL
+// for all on the caller), the outcome is the same for any thread count.
+void animals_update(Animals *animals, const CollisionWorld *collision, JobSystem *jobs, float dt);
+
+#endif // ANIMALS_H_
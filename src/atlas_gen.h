@@ -0,0 +1,68 @@
+// Generated by `./nob atlas` from the sprite sheets listed in nob.c, do not edit.
+#ifndef ATLAS_GEN_H_
+#define ATLAS_GEN_H_
+
+#define ATLAS_PAGE_COUNT 1
+#define ATLAS_PAGE_SIZE 1024
+
+typedef enum {
+    ATLAS_WHITE,
+    ATLAS_PLAYER,
+    ATLAS_TOOLS,
+    ATLAS_CHICKEN,
+    ATLAS_COW,
+    ATLAS_PLANTS,
+    ATLAS_ITEMS,
+    ATLAS_BIOME,
+    ATLAS_PATHS,
+    ATLAS_GRASS,
+    ATLAS_HILLS,
+    ATLAS_DIRT,
+    ATLAS_WATER,
+    ATLAS_HOUSE,
+    ATLAS_SHEET_COUNT,
+} AtlasSheet;
+
+#endif // ATLAS_GEN_H_
+
+#ifdef ATLAS_GEN_IMPLEMENTATION
+static const char *atlas_page_paths[ATLAS_PAGE_COUNT] = {
+    "resources/atlas/atlas0.png",
+};
+
+static const AtlasRegion atlas_regions[ATLAS_SHEET_COUNT] = {
+    [ATLAS_WHITE] = { 0, { 1000, 1, 1, 1 }, NULL },
+    [ATLAS_PLAYER] = { 0, { 0, 0, 192, 192 }, "resources/sprout-lands-sprites/Characters/basic-character-spritesheet.png" },
+    [ATLAS_TOOLS] = { 0, { 724, 0, 96, 96 }, "resources/sprout-lands-sprites/Characters/Tools.png" },
+    [ATLAS_CHICKEN] = { 0, { 290, 113, 64, 32 }, "resources/sprout-lands-sprites/Characters/free-chicken-sprites.png" },
+    [ATLAS_COW] = { 0, { 724, 97, 96, 64 }, "resources/sprout-lands-sprites/Characters/free-cow-sprites.png" },
+    [ATLAS_PLANTS] = { 0, { 193, 113, 96, 32 }, "resources/sprout-lands-sprites/Objects/Basic_Plants.png" },
+    [ATLAS_ITEMS] = { 0, { 355, 113, 48, 32 }, "resources/sprout-lands-sprites/Objects/Basic_tools_and_materials.png" },
+    [ATLAS_BIOME] = { 0, { 821, 0, 144, 80 }, "resources/sprout-lands-sprites/Objects/Basic_Grass_Biom_things.png" },
+    [ATLAS_PATHS] = { 0, { 934, 81, 64, 64 }, "resources/sprout-lands-sprites/Objects/Paths.png" },
+    [ATLAS_GRASS] = { 0, { 193, 0, 176, 112 }, "resources/sprout-lands-sprites/Tilesets/Grass.png" },
+    [ATLAS_HILLS] = { 0, { 370, 0, 176, 112 }, "resources/sprout-lands-sprites/Tilesets/Hills.png" },
+    [ATLAS_DIRT] = { 0, { 547, 0, 176, 112 }, "resources/sprout-lands-sprites/Tilesets/Tilled_Dirt.png" },
+    [ATLAS_WATER] = { 0, { 404, 113, 64, 16 }, "resources/sprout-lands-sprites/Tilesets/Water.png" },
+    [ATLAS_HOUSE] = { 0, { 821, 81, 112, 80 }, "resources/sprout-lands-sprites/Tilesets/Wooden House.png" },
+};
+#endif // ATLAS_GEN_IMPLEMENTATION
+
+#ifdef ATLAS_GEN_NAMES
+static const char *atlas_sheet_names[ATLAS_SHEET_COUNT] = {
+    [ATLAS_WHITE] = "WHITE",
+    [ATLAS_PLAYER] = "PLAYER",
+    [ATLAS_TOOLS] = "TOOLS",
+    [ATLAS_CHICKEN] = "CHICKEN",
+    [ATLAS_COW] = "COW",
+    [ATLAS_PLANTS] = "PLANTS",
+    [ATLAS_ITEMS] = "ITEMS",
+    [ATLAS_BIOME] = "BIOME",
+    [ATLAS_PATHS] = "PATHS",
+    [ATLAS_GRASS] = "GRASS",
+    [ATLAS_HILLS] = "HILLS",
+    [ATLAS_DIRT] = "DIRT",
+    [ATLAS_WATER] = "WATER",
+    [ATLAS_HOUSE] = "HOUSE",
+};
+#endif // ATLAS_GEN_NAMES
@@ -0,0 +1,196 @@
+// Packs the sprite sheets into texture atlas pages and writes the table of where everything ended
+// up as a C header. Run through `./nob atlas`.
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "external/stb_image.h"
+#include "external/stb_image_write.h"
+#include "external/stb_rect_pack.h"
+
+#define ATLAS_PAGE_SIZE 1024
+// Empty pixels around every sheet, so sampling right at the edge of a sprite can't pick up its
+// neighbour.
+#define ATLAS_PADDING 1
+// The solid white block shapes are drawn with. Only its middle pixel is used.
+#define ATLAS_WHITE_SIZE 3
+
+typedef struct Sheet {
+    const char *name;
+    const char *path;
+    int width, height;
+    unsigned char *pixels;
+    int page, x, y;
+} Sheet;
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s <page-prefix> <output.h> <NAME=sheet.png>...\n", program);
+}
+
+static bool write_header(const char *path, const char *page_prefix, int page_count, const Sheet *sheets, int sheet_count) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not write %s\n", path);
+        return false;
+    }
+
+    fprintf(f, "// Generated by `./nob atlas` from the sprite sheets listed in nob.c, do not edit.\n");
+    fprintf(f, "#ifndef ATLAS_GEN_H_\n");
+    fprintf(f, "#define ATLAS_GEN_H_\n\n");
+    fprintf(f, "#define ATLAS_PAGE_COUNT %d\n", page_count);
+    fprintf(f, "#define ATLAS_PAGE_SIZE %d\n\n", ATLAS_PAGE_SIZE);
+    fprintf(f, "typedef enum {\n");
+    for (int i = 0; i < sheet_count; i++) {
+        fprintf(f, "    ATLAS_%s,\n", sheets[i].name);
+    }
+    fprintf(f, "    ATLAS_SHEET_COUNT,\n");
+    fprintf(f, "} AtlasSheet;\n\n");
+    fprintf(f, "#endif // ATLAS_GEN_H_\n\n");
+
+    fprintf(f, "#ifdef ATLAS_GEN_IMPLEMENTATION\n");
+    fprintf(f, "static const char *atlas_page_paths[ATLAS_PAGE_COUNT] = {\n");
+    for (int p = 0; p < page_count; p++) {
+        fprintf(f, "    \"%s%d.png\",\n", page_prefix, p);
+    }
+    fprintf(f, "};\n\n");
+    fprintf(f, "static const AtlasRegion atlas_regions[ATLAS_SHEET_COUNT] = {\n");
+    for (int i = 0; i < sheet_count; i++) {
+        const Sheet *s = &sheets[i];
+        if (s->path == NULL) {
+            fprintf(f, "    [ATLAS_%s] = { %d, { %d, %d, 1, 1 }, NULL },\n",
+                s->name, s->page, s->x + ATLAS_WHITE_SIZE / 2, s->y + ATLAS_WHITE_SIZE / 2);
+        } else {
+            fprintf(f, "    [ATLAS_%s] = { %d, { %d, %d, %d, %d }, \"%s\" },\n",
+                s->name, s->page, s->x, s->y, s->width, s->height, s->path);
+        }
+    }
+    fprintf(f, "};\n");
+    fprintf(f, "#endif // ATLAS_GEN_IMPLEMENTATION\n\n");
+
+    fprintf(f, "#ifdef ATLAS_GEN_NAMES\n");
+    fprintf(f, "static const char *atlas_sheet_names[ATLAS_SHEET_COUNT] = {\n");
+    for (int i = 0; i < sheet_count; i++) {
+        fprintf(f, "    [ATLAS_%s] = \"%s\",\n", sheets[i].name, sheets[i].name);
+    }
+    fprintf(f, "};\n");
+    fprintf(f, "#endif // ATLAS_GEN_NAMES\n");
+
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *page_prefix = argv[1];
+    const char *header_path = argv[2];
+
+    // The white block goes first so it always lives on page 0.
+    const int sheet_count = argc - 3 + 1;
+    Sheet *sheets = calloc(sheet_count, sizeof(Sheet));
+    stbrp_rect *rects = calloc(sheet_count, sizeof(stbrp_rect));
+    if (sheets == NULL || rects == NULL) {
+        fprintf(stderr, "ERROR: Buy more RAM lol\n");
+        return 1;
+    }
+
+    sheets[0] = (Sheet) { .name = "WHITE", .width = ATLAS_WHITE_SIZE, .height = ATLAS_WHITE_SIZE };
+    for (int i = 1; i < sheet_count; i++) {
+        char *arg = argv[i + 2];
+        char *eq = strchr(arg, '=');
+        if (eq == NULL) {
+            usage(argv[0]);
+            return 1;
+        }
+        *eq = '\0';
+
+        Sheet *sheet = &sheets[i];
+        sheet->name = arg;
+        sheet->path = eq + 1;
+        sheet->pixels = stbi_load(sheet->path, &sheet->width, &sheet->height, NULL, 4);
+        if (sheet->pixels == NULL) {
+            fprintf(stderr, "ERROR: could not load %s: %s\n", sheet->path, stbi_failure_reason());
+            return 1;
+        }
+        if (sheet->width + ATLAS_PADDING > ATLAS_PAGE_SIZE || sheet->height + ATLAS_PADDING > ATLAS_PAGE_SIZE) {
+            fprintf(stderr, "ERROR: %s is bigger than an atlas page\n", sheet->path);
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < sheet_count; i++) {
+        rects[i] = (stbrp_rect) {
+            .id = i,
+            .w = sheets[i].width + ATLAS_PADDING,
+            .h = sheets[i].height + ATLAS_PADDING,
+        };
+    }
+
+    // Fill a page, then pack whatever didn't fit into the next one.
+    stbrp_node nodes[ATLAS_PAGE_SIZE];
+    int page_count = 0;
+    int remaining = sheet_count;
+    while (remaining > 0) {
+        stbrp_context ctx;
+        stbrp_init_target(&ctx, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, nodes, ATLAS_PAGE_SIZE);
+        stbrp_pack_rects(&ctx, rects, remaining);
+
+        unsigned char *page = calloc(ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE, 4);
+        if (page == NULL) {
+            fprintf(stderr, "ERROR: Buy more RAM lol\n");
+            return 1;
+        }
+
+        int left = 0;
+        for (int r = 0; r < remaining; r++) {
+            if (!rects[r].was_packed) {
+                rects[left++] = rects[r];
+                continue;
+            }
+
+            Sheet *sheet = &sheets[rects[r].id];
+            sheet->page = page_count;
+            sheet->x = rects[r].x;
+            sheet->y = rects[r].y;
+            for (int y = 0; y < sheet->height; y++) {
+                unsigned char *dst = page + ((size_t)(sheet->y + y) * ATLAS_PAGE_SIZE + sheet->x) * 4;
+                if (sheet->pixels == NULL) {
+                    memset(dst, 0xFF, (size_t)sheet->width * 4);
+                } else {
+                    memcpy(dst, sheet->pixels + (size_t)y * sheet->width * 4, (size_t)sheet->width * 4);
+                }
+            }
+        }
+        if (left == remaining) {
+            fprintf(stderr, "ERROR: nothing fits on an empty atlas page\n");
+            return 1;
+        }
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s%d.png", page_prefix, page_count);
+        if (!stbi_write_png(path, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 4, page, ATLAS_PAGE_SIZE * 4)) {
+            fprintf(stderr, "ERROR: could not write %s\n", path);
+            return 1;
+        }
+        free(page);
+
+        printf("%s: %d sheets\n", path, remaining - left);
+        page_count++;
+        remaining = left;
+    }
+
+    if (!write_header(header_path, page_prefix, page_count, sheets, sheet_count)) return 1;
+    printf("%s: %d sheets on %d pages\n", header_path, sheet_count, page_count);
+
+    for (int i = 0; i < sheet_count; i++) stbi_image_free(sheets[i].pixels);
+    free(sheets);
+    free(rects);
+    return 0;
+}
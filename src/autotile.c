@@ -0,0 +1,83 @@
+#include <assert.h>
+#include <stdbool.h>
+
+#include "autotile.h"
+
+const int8_t autotile_offsets[8][2] = {
+    {  0, -1 }, {  1, -1 }, {  1,  0 }, {  1,  1 },
+    {  0,  1 }, { -1,  1 }, { -1,  0 }, { -1, -1 },
+};
+
+// The edge rows of the tilesets, read off `Bitmask references 1.png`. Every tile is 3x3 characters,
+// '#' where the terrain goes on past that side or corner of it and '.' where it stops. Tiles with
+// nothing in the middle are left empty in the tilesets.
+static const char *autotile_layout[AUTOTILE_ROWS * 3] = {
+    "... ... ... ... ... ... ... ... ... ##. ...",
+    ".## ### ##. .#. .## ### ### ##. ### ### ...",
+    ".## ### ##. .#. .#. ##. .## .#. .#. .## ...",
+
+    ".## ### ##. .#. .## ### ### ##. ### .## ...",
+    ".## ### ##. .#. .## ### ### ##. ### ### ...",
+    ".## ### ##. .#. .#. ##. .## .#. .#. ##. ...",
+
+    ".## ### ##. .#. .#. ##. .## .#. .#. .#. .#.",
+    ".## ### ##. .#. .## ### ### ##. ### ### ###",
+    "... ... ... ... .## ### ### ##. ### .## ##.",
+
+    "... ... ... ... .#. ##. .## .#. .#. .## ##.",
+    ".## ### ##. .#. .## ### ### ##. ### ### ###",
+    "... ... ... ... ... ... ... ... ... .#. .#.",
+
+    "... ... ... ... .#. ##. .## .#. .#. ... ...",
+    "... ... ... ... .## ### ### ##. ### ... ...",
+    "... ... ... ... .#. ##. .## .#. .#. ... ...",
+};
+
+// Drops the corners that don't matter, the ones without both of their sides.
+static uint8_t autotile_reduce(uint8_t mask) {
+    const uint8_t corners[4][3] = {
+        { AUTOTILE_NE, AUTOTILE_N, AUTOTILE_E },
+        { AUTOTILE_SE, AUTOTILE_S, AUTOTILE_E },
+        { AUTOTILE_SW, AUTOTILE_S, AUTOTILE_W },
+        { AUTOTILE_NW, AUTOTILE_N, AUTOTILE_W },
+    };
+    for (int i = 0; i < 4; i++) {
+        const uint8_t sides = corners[i][1] | corners[i][2];
+        if ((mask & sides) != sides) mask &= ~corners[i][0];
+    }
+    return mask;
+}
+
+void autotile_init(Autotile *autotile) {
+    // Mask of every tile of the layout, -1 for the empty ones.
+    int layout[AUTOTILE_ROWS * AUTOTILE_COLUMNS];
+    for (int row = 0; row < AUTOTILE_ROWS; row++) {
+        for (int col = 0; col < AUTOTILE_COLUMNS; col++) {
+            const int tile = col + row * AUTOTILE_COLUMNS;
+            if (autotile_layout[row * 3 + 1][col * 4 + 1] != '#') {
+                layout[tile] = -1;
+                continue;
+            }
+
+            uint8_t mask = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                const char c = autotile_layout[row * 3 + 1 + autotile_offsets[bit][1]][col * 4 + 1 + autotile_offsets[bit][0]];
+                if (c == '#') mask |= 1 << bit;
+            }
+            assert(mask == autotile_reduce(mask) && "layout tile with a corner that can't matter");
+            layout[tile] = mask;
+        }
+    }
+
+    for (int mask = 0; mask < 256; mask++) {
+        const int reduced = autotile_reduce(mask);
+        bool found = false;
+        for (int tile = 0; tile < AUTOTILE_ROWS * AUTOTILE_COLUMNS && !found; tile++) {
+            if (layout[tile] != reduced) continue;
+            autotile->tiles[mask] = tile;
+            found = true;
+        }
+        assert(found && "layout is missing a tile");
+    }
+    assert(autotile->tiles[0xFF] == AUTOTILE_WHOLE);
+}
@@ -0,0 +1,46 @@
+#ifndef AUTOTILE_H_
+#define AUTOTILE_H_
+
+#include <stdint.h>
+
+// Edges and corners for terrain laid out like `Bitmask references 1.png` in the sprout lands pack,
+// which is how the grass, hills and dirt tilesets have their first AUTOTILE_ROWS rows. Every cell
+// gets the tile that matches which of its 8 neighbours are the same terrain, packed into a mask of
+// AutotileNeighbour bits.
+//
+// A corner only matters when both sides next to it are the same terrain too, so the 256 masks come
+// down to 47 different tiles. Working that out takes a table of all 256, built once, after which
+// picking a tile is a single lookup and changing a cell only needs its 3x3 neighbourhood redone.
+
+typedef enum {
+    AUTOTILE_N  = 1 << 0,
+    AUTOTILE_NE = 1 << 1,
+    AUTOTILE_E  = 1 << 2,
+    AUTOTILE_SE = 1 << 3,
+    AUTOTILE_S  = 1 << 4,
+    AUTOTILE_SW = 1 << 5,
+    AUTOTILE_W  = 1 << 6,
+    AUTOTILE_NW = 1 << 7,
+} AutotileNeighbour;
+
+#define AUTOTILE_COLUMNS 11
+#define AUTOTILE_ROWS 5
+// Tile of a cell with nothing but the same terrain around it, in the middle of the 3x3 block in the
+// top left corner.
+#define AUTOTILE_WHOLE (AUTOTILE_COLUMNS + 1)
+
+typedef struct Autotile {
+    // Tile id in the tileset for every mask.
+    uint8_t tiles[256];
+} Autotile;
+
+void autotile_init(Autotile *autotile);
+
+// Where the neighbour of every AutotileNeighbour bit is, as {dx, dy} in bit order.
+extern const int8_t autotile_offsets[8][2];
+
+static inline uint8_t autotile_pick(const Autotile *autotile, uint8_t mask) {
+    return autotile->tiles[mask];
+}
+
+#endif // AUTOTILE_H_
@@ -0,0 +1,805 @@
+// Micro benchmarks for the simulation subsystems. Built and run by `./nob bench [name]`.
+#include <assert.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NOB_IMPLEMENTATION
+#include "nob.h"
+#include "animals.h"
+#include "collision.h"
+#include "crops.h"
+#include "farmbot.h"
+#include "jobs.h"
+#include "mapblob.h"
+#include "moisture.h"
+#include "pages.h"
+#include "save.h"
+#include "sim.h"
+#include "terrain.h"
+#include "timers.h"
+
+#define BENCH_MIN_SECONDS 0.25
+
+static double bench_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Crops -------------------------------------------------------------------------------------------
+
+static double bench_crops_kernel(CropStore *store, void (*kernel)(CropStore *, uint32_t)) {
+    long iterations = 0;
+    uint32_t now = 10 * CROP_TICKS_PER_STAGE;
+    const double started_at = bench_seconds();
+    double elapsed = 0.0;
+    do {
+        kernel(store, now);
+        now++;
+        iterations++;
+        elapsed = bench_seconds() - started_at;
+    } while (elapsed < BENCH_MIN_SECONDS);
+    return (double)store->count * iterations / elapsed;
+}
+
+typedef struct BenchCropGrowth {
+    CropStore store;
+    TimerWheel timers;
+} BenchCropGrowth;
+
+// Same as the world does it, one timer per stage transition.
+static void bench_crops_on_grow(void *ctx, uint32_t id, uint64_t now) {
+    BenchCropGrowth *growth = ctx;
+    if (crop_grow(&growth->store, id)) {
+        timer_schedule(&growth->timers, now + CROP_TICKS_PER_STAGE, bench_crops_on_grow, growth, id);
+    }
+}
+
+static void bench_crops(void) {
+    printf("crops: growth stage kernel (%s)\n", crops_kernel_name());
+
+    const int counts[] = { 10000, 100000, 1000000 };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        static BenchCropGrowth growth;
+        growth.store = crop_store_create(counts[c]);
+        timer_wheel_init(&growth.timers, 0);
+        CropStore store = growth.store;
+
+        // Every other cell planted, at ticks spread over all the stages.
+        srand(69);
+        for (int i = 0; i < store.count; i += 2) {
+            const uint32_t planted_at = 1 + rand() % (10 * CROP_TICKS_PER_STAGE);
+            crop_plant(&store, i, planted_at);
+            timer_schedule(&growth.timers, planted_at + CROP_TICKS_PER_STAGE, bench_crops_on_grow, &growth, i);
+        }
+
+        // The timers and the SIMD kernel both have to agree with the scalar kernel before their
+        // numbers mean anything. Crops planted in the future haven't grown yet either way.
+        const uint32_t now = 8 * CROP_TICKS_PER_STAGE;
+        uint8_t *expected = malloc(store.count);
+        timer_wheel_advance(&growth.timers, now);
+        memcpy(expected, store.stage, store.count);
+        crops_eval_stages_scalar(&store, now);
+        if (memcmp(expected, store.stage, store.count) != 0) {
+            fprintf(stderr, "crops: timers disagree with scalar kernel\n");
+            exit(1);
+        }
+        crops_eval_stages(&store, now);
+        if (memcmp(expected, store.stage, store.count) != 0) {
+            fprintf(stderr, "crops: %s kernel disagrees with scalar kernel\n", crops_kernel_name());
+            exit(1);
+        }
+        free(expected);
+
+        const double simd = bench_crops_kernel(&store, crops_eval_stages);
+        const double scalar = bench_crops_kernel(&store, crops_eval_stages_scalar);
+        printf("    %8d cells: %8.1f Mcells/sec %-6s %8.1f Mcells/sec scalar (%.1fx)\n",
+            store.count, simd / 1e6, crops_kernel_name(), scalar / 1e6, simd / scalar);
+
+        crop_store_destroy(&store);
+        timer_wheel_free(&growth.timers);
+    }
+}
+
+// Timers ------------------------------------------------------------------------------------------
+
+// A minute at 144 ticks per second.
+#define BENCH_TIMERS_SPREAD 8640
+
+typedef struct BenchTimers {
+    TimerWheel wheel;
+    // When each timer is supposed to fire, and how many did not.
+    uint64_t *due;
+    long late;
+    long fired;
+} BenchTimers;
+
+static uint64_t bench_timer_delay(void) {
+    return 1 + rand() % BENCH_TIMERS_SPREAD;
+}
+
+// Every timer schedules itself again when it fires, so the number of live timers stays put.
+static void bench_timers_on_fire(void *ctx, uint32_t id, uint64_t now) {
+    BenchTimers *timers = ctx;
+    if (timers->due[id] != now) timers->late++;
+    timers->fired++;
+    timers->due[id] = now + bench_timer_delay();
+    timer_schedule(&timers->wheel, timers->due[id], bench_timers_on_fire, timers, id);
+}
+
+static void bench_timers(void) {
+    printf("timers: timer wheel vs polling every timer each tick, due times spread over %d ticks\n", BENCH_TIMERS_SPREAD);
+
+    const int counts[] = { 1000, 10000, 100000, 1000000 };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        const int count = counts[c];
+
+        srand(1337);
+        static BenchTimers timers;
+        memset(&timers, 0, sizeof(timers));
+        timer_wheel_init(&timers.wheel, 0);
+        timers.due = malloc(count * sizeof(uint64_t));
+        uint64_t *poll_due = malloc(count * sizeof(uint64_t));
+        if (timers.due == NULL || poll_due == NULL) {
+            fprintf(stderr, "timers: Buy more RAM lol\n");
+            exit(1);
+        }
+        for (int i = 0; i < count; i++) {
+            timers.due[i] = bench_timer_delay();
+            timer_schedule(&timers.wheel, timers.due[i], bench_timers_on_fire, &timers, i);
+        }
+        memcpy(poll_due, timers.due, count * sizeof(uint64_t));
+
+        // Run well past the spread so every level of the wheel gets to cascade a couple of times.
+        uint64_t wheel_ticks = 0;
+        double started_at = bench_seconds();
+        double wheel_elapsed = 0.0;
+        do {
+            wheel_ticks += 1024;
+            timer_wheel_advance(&timers.wheel, wheel_ticks);
+            wheel_elapsed = bench_seconds() - started_at;
+        } while (wheel_elapsed < BENCH_MIN_SECONDS || wheel_ticks < 4 * BENCH_TIMERS_SPREAD);
+
+        if (timers.late != 0 || timers.wheel.pending != (size_t)count) {
+            fprintf(stderr, "timers: %ld of %ld timers fired at the wrong tick, %zu of %d pending\n",
+                timers.late, timers.fired, timers.wheel.pending, count);
+            exit(1);
+        }
+
+        // What we had before: every timer looked at on every tick.
+        uint64_t poll_ticks = 0;
+        started_at = bench_seconds();
+        double poll_elapsed = 0.0;
+        do {
+            for (int t = 0; t < 16; t++) {
+                poll_ticks++;
+                for (int i = 0; i < count; i++) {
+                    if (poll_due[i] <= poll_ticks) {
+                        poll_due[i] = poll_ticks + bench_timer_delay();
+                    }
+                }
+            }
+            poll_elapsed = bench_seconds() - started_at;
+        } while (poll_elapsed < BENCH_MIN_SECONDS);
+
+        const double wheel = wheel_ticks / wheel_elapsed;
+        const double poll = poll_ticks / poll_elapsed;
+        printf("    %8d timers: %10.0f ticks/sec wheel (%5.1f fired/tick) %10.0f ticks/sec polling (%.1fx)\n",
+            count, wheel, (double)timers.fired / wheel_ticks, poll, wheel / poll);
+
+        timer_wheel_free(&timers.wheel);
+        free(timers.due);
+        free(poll_due);
+    }
+}
+
+// Collision ---------------------------------------------------------------------------------------
+
+#define BENCH_COLLISION_GRID 512
+#define BENCH_COLLISION_BUCKET 48.0f
+#define BENCH_COLLISION_QUERIES 4096
+
+static float bench_randf(float lo, float hi) {
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+static Rectangle bench_random_rect(float world_size, float min_size, float max_size) {
+    return (Rectangle) {
+        bench_randf(0.0f, world_size),
+        bench_randf(0.0f, world_size),
+        bench_randf(min_size, max_size),
+        bench_randf(min_size, max_size),
+    };
+}
+
+static void bench_collision(void) {
+    printf("collision: uniform grid (%dx%d buckets of %.0fpx) vs linear scan\n",
+        BENCH_COLLISION_GRID, BENCH_COLLISION_GRID, BENCH_COLLISION_BUCKET);
+
+    const float world_size = BENCH_COLLISION_GRID * BENCH_COLLISION_BUCKET;
+    static Rectangle queries[BENCH_COLLISION_QUERIES];
+
+    const int counts[] = { 100, 1000, 10000, 100000 };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        srand(420);
+
+        CollisionWorld cw;
+        collision_world_init(&cw, BENCH_COLLISION_GRID, BENCH_COLLISION_GRID, BENCH_COLLISION_BUCKET);
+        for (int i = 0; i < counts[c]; i++) {
+            collision_world_add(&cw, bench_random_rect(world_size, 16.0f, 144.0f));
+        }
+        collision_world_build(&cw);
+
+        // Player sized movers.
+        for (int i = 0; i < BENCH_COLLISION_QUERIES; i++) {
+            queries[i] = bench_random_rect(world_size, 64.0f, 64.0f);
+        }
+
+        long grid_queries = 0, grid_hits = 0;
+        double started_at = bench_seconds();
+        double grid_elapsed = 0.0;
+        do {
+            for (int i = 0; i < BENCH_COLLISION_QUERIES; i++) {
+                grid_hits += collision_world_overlaps(&cw, queries[i]);
+            }
+            grid_queries += BENCH_COLLISION_QUERIES;
+            grid_elapsed = bench_seconds() - started_at;
+        } while (grid_elapsed < BENCH_MIN_SECONDS);
+
+        long linear_queries = 0, linear_hits = 0;
+        started_at = bench_seconds();
+        double linear_elapsed = 0.0;
+        do {
+            for (int i = 0; i < BENCH_COLLISION_QUERIES; i++) {
+                bool hit = false;
+                for (size_t k = 0; k < cw.rects.count && !hit; k++) {
+                    hit = collision_rects_overlap(queries[i], cw.rects.items[k]);
+                }
+                linear_hits += hit;
+            }
+            linear_queries += BENCH_COLLISION_QUERIES;
+            linear_elapsed = bench_seconds() - started_at;
+        } while (linear_elapsed < BENCH_MIN_SECONDS);
+
+        // Both loops ran whole passes over the same queries, so the hit rates have to match.
+        if (grid_hits * linear_queries != linear_hits * grid_queries) {
+            fprintf(stderr, "collision: grid and linear scan disagree\n");
+            exit(1);
+        }
+
+        const double grid = grid_queries / grid_elapsed;
+        const double linear = linear_queries / linear_elapsed;
+        printf("    %8d obstacles: %8.2f Mqueries/sec grid %8.2f Mqueries/sec linear (%.1fx)\n",
+            counts[c], grid / 1e6, linear / 1e6, grid / linear);
+
+        collision_world_free(&cw);
+    }
+}
+
+// Animals -----------------------------------------------------------------------------------------
+
+#define BENCH_ANIMALS_TICKS 64
+
+// Every component an entity has has to point back at it, and nothing may have wandered off the map.
+static bool bench_animals_check(const Animals *animals) {
+    const ComponentStore *stores[] = {
+        &animals->transforms, &animals->colliders, &animals->sprites, &animals->animations, &animals->wanderers,
+    };
+    for (size_t s = 0; s < sizeof(stores) / sizeof(stores[0]); s++) {
+        if (stores[s]->count != animals->entities.alive) return false;
+        for (size_t i = 0; i < stores[s]->count; i++) {
+            const Entity entity = stores[s]->entities[i];
+            if (!entity_is_alive(&animals->entities, entity)) return false;
+            if (component_get(stores[s], entity) != (char *)stores[s]->data + i * stores[s]->size) return false;
+        }
+    }
+
+    const TransformComponent *transforms = animals->transforms.data;
+    for (size_t i = 0; i < animals->transforms.count; i++) {
+        const Vector2 p = transforms[i].position;
+        if (p.x < animals->bounds.x || p.y < animals->bounds.y) return false;
+        if (p.x > animals->bounds.x + animals->bounds.width || p.y > animals->bounds.y + animals->bounds.height) return false;
+    }
+    return true;
+}
+
+static void bench_animals(void) {
+    printf("animals: movement and animation systems over dense component arrays\n");
+
+    const float world_size = BENCH_COLLISION_GRID * BENCH_COLLISION_BUCKET;
+    const int counts[] = { 1000, 10000, 100000 };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        srand(80085);
+
+        CollisionWorld cw;
+        collision_world_init(&cw, BENCH_COLLISION_GRID, BENCH_COLLISION_GRID, BENCH_COLLISION_BUCKET);
+        for (int i = 0; i < 10000; i++) {
+            collision_world_add(&cw, bench_random_rect(world_size, 16.0f, 144.0f));
+        }
+        collision_world_build(&cw);
+
+        static TimerWheel timers;
+        static AnimLibrary clips;
+        static Animals animals;
+        if (!anim_library_load(&clips, ANIM_CLIPS_PATH, 144)) exit(1);
+        timer_wheel_init(&timers, 0);
+        animals_init(&animals, &timers, &clips, (Rectangle) { 0, 0, world_size, world_size }, 1234);
+
+        // Spawn, then churn through despawning and respawning a third of them so the dense arrays
+        // are shuffled the way they would be after a while of play.
+        Entity *spawned = malloc(counts[c] * sizeof(Entity));
+        for (int i = 0; i < counts[c]; i++) {
+            const AnimalKind kind = i % 2 == 0 ? ANIMAL_CHICKEN : ANIMAL_COW;
+            spawned[i] = animal_spawn(&animals, kind, (Vector2) { bench_randf(0.0f, world_size - 96.0f), bench_randf(0.0f, world_size - 96.0f) });
+        }
+        for (int i = 0; i < counts[c]; i += 3) {
+            animal_despawn(&animals, spawned[i]);
+            spawned[i] = animal_spawn(&animals, ANIMAL_CHICKEN, (Vector2) { bench_randf(0.0f, world_size - 96.0f), bench_randf(0.0f, world_size - 96.0f) });
+        }
+
+        uint64_t now = 0;
+        long updated = 0;
+        const double started_at = bench_seconds();
+        double elapsed = 0.0;
+        do {
+            for (int t = 0; t < BENCH_ANIMALS_TICKS; t++) {
+                now++;
+                timer_wheel_advance(&timers, now);
+                animals_update(&animals, &cw, NULL, 1.0f / 144.0f);
+                updated += (long)animals.entities.alive;
+            }
+            elapsed = bench_seconds() - started_at;
+        } while (elapsed < BENCH_MIN_SECONDS);
+
+        if (!bench_animals_check(&animals)) {
+            fprintf(stderr, "animals: component stores are inconsistent\n");
+            exit(1);
+        }
+
+        printf("    %8d animals: %8.2f Mentities/sec (%.0f ticks/sec)\n",
+            counts[c], updated / elapsed / 1e6, now / elapsed);
+
+        free(spawned);
+        animals_free(&animals);
+        anim_library_free(&clips);
+        timer_wheel_free(&timers);
+        collision_world_free(&cw);
+    }
+}
+
+// Threads -----------------------------------------------------------------------------------------
+
+// A 1024x1024 tile farm at the size the game draws tiles, with a crowd of animals on it.
+#define BENCH_THREADS_GRID 1024
+#define BENCH_THREADS_OBSTACLES 40000
+#define BENCH_THREADS_ANIMALS 100000
+// One second of simulation at 144Hz.
+#define BENCH_THREADS_TICKS 144
+
+// FNV-1a over the bits of every transform, so runs on different thread counts have to agree
+// exactly and not just roughly.
+static uint64_t bench_threads_hash(const Animals *animals) {
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char *bytes = animals->transforms.data;
+    const size_t size = animals->transforms.count * animals->transforms.size;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static void bench_threads(void) {
+    const float world_size = BENCH_THREADS_GRID * BENCH_COLLISION_BUCKET;
+    const int cpu_count = jobs_cpu_count();
+    const int max_threads = cpu_count > 4 ? cpu_count : 4;
+    printf("threads: %d animals on a %dx%d tile farm, %d ticks, 1 to %d threads (%d cores)\n",
+        BENCH_THREADS_ANIMALS, BENCH_THREADS_GRID, BENCH_THREADS_GRID, BENCH_THREADS_TICKS, max_threads, cpu_count);
+
+    static CollisionWorld cw;
+    srand(80085);
+    collision_world_init(&cw, BENCH_THREADS_GRID, BENCH_THREADS_GRID, BENCH_COLLISION_BUCKET);
+    for (int i = 0; i < BENCH_THREADS_OBSTACLES; i++) {
+        collision_world_add(&cw, bench_random_rect(world_size, 16.0f, 144.0f));
+    }
+    collision_world_build(&cw);
+
+    static AnimLibrary clips;
+    if (!anim_library_load(&clips, ANIM_CLIPS_PATH, 144)) exit(1);
+
+    double serial_elapsed = 0.0;
+    uint64_t serial_hash = 0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+        static JobSystem jobs;
+        static TimerWheel timers;
+        static Animals animals;
+        job_system_init(&jobs, threads);
+        timer_wheel_init(&timers, 0);
+        animals_init(&animals, &timers, &clips, (Rectangle) { 0, 0, world_size, world_size }, 1234);
+
+        // Same herd on every run, the thread count is the only thing that changes.
+        srand(1337);
+        for (int i = 0; i < BENCH_THREADS_ANIMALS; i++) {
+            const AnimalKind kind = i % 2 == 0 ? ANIMAL_CHICKEN : ANIMAL_COW;
+            animal_spawn(&animals, kind, (Vector2) { bench_randf(0.0f, world_size - 96.0f), bench_randf(0.0f, world_size - 96.0f) });
+        }
+
+        const double started_at = bench_seconds();
+        for (uint64_t now = 1; now <= BENCH_THREADS_TICKS; now++) {
+            timer_wheel_advance(&timers, now);
+            animals_update(&animals, &cw, &jobs, 1.0f / 144.0f);
+        }
+        const double elapsed = bench_seconds() - started_at;
+
+        const uint64_t hash = bench_threads_hash(&animals);
+        if (threads == 1) {
+            serial_elapsed = elapsed;
+            serial_hash = hash;
+        } else if (hash != serial_hash) {
+            fprintf(stderr, "threads: %d threads ended up somewhere else than 1 thread did\n", threads);
+            exit(1);
+        }
+
+        const double ticks_per_second = BENCH_THREADS_TICKS / elapsed;
+        printf("    %2d threads: %8.0f ticks/sec, %5.2fx speedup, %s 144Hz\n",
+            threads, ticks_per_second, serial_elapsed / elapsed, ticks_per_second >= 144.0 ? "holds" : "misses");
+
+        animals_free(&animals);
+        timer_wheel_free(&timers);
+        job_system_free(&jobs);
+    }
+
+    anim_library_free(&clips);
+    collision_world_free(&cw);
+}
+
+// Moisture ----------------------------------------------------------------------------------------
+
+// Steps the kernel and the scalar reference are compared over before timing.
+#define BENCH_MOISTURE_CHECK_STEPS 16
+
+static double bench_moisture_run(MoistureField *field, JobSystem *jobs, bool scalar) {
+    long steps = 0;
+    const double started_at = bench_seconds();
+    double elapsed = 0.0;
+    do {
+        if (scalar) {
+            moisture_step_scalar(field);
+        } else {
+            moisture_step(field, jobs);
+        }
+        steps++;
+        elapsed = bench_seconds() - started_at;
+    } while (elapsed < BENCH_MIN_SECONDS);
+    return (double)field->cols * field->rows * steps / elapsed;
+}
+
+static void bench_moisture(void) {
+    const int cpu_count = jobs_cpu_count();
+    printf("moisture: diffusion stencil, scalar vs %s kernel vs %s on %d threads\n",
+        moisture_kernel_name(), moisture_kernel_name(), cpu_count);
+
+    static JobSystem jobs;
+    job_system_init(&jobs, cpu_count);
+
+    const int sizes[] = { 256, 1024, 4096 };
+    for (size_t c = 0; c < sizeof(sizes) / sizeof(sizes[0]); c++) {
+        const int size = sizes[c];
+        const size_t cell_count = (size_t)size * size;
+
+        // A few thousand watered cells, and a faster diffusion than the game's so the check
+        // actually has something spreading around.
+        MoistureField reference, field;
+        moisture_field_init(&reference, size, size, 0.2f, 0.001f);
+        moisture_field_init(&field, size, size, 0.2f, 0.001f);
+        srand(80085);
+        for (size_t i = 0; i < cell_count / 64; i++) {
+            const int id = rand() % (int)cell_count;
+            moisture_add(&reference, id, 1.0f);
+            moisture_add(&field, id, 1.0f);
+        }
+
+        for (int i = 0; i < BENCH_MOISTURE_CHECK_STEPS; i++) {
+            moisture_step_scalar(&reference);
+            moisture_step(&field, &jobs);
+        }
+        for (size_t i = 0; i < cell_count; i++) {
+            const float diff = reference.cells[i] - field.cells[i];
+            if (diff > 1e-5f || diff < -1e-5f) {
+                fprintf(stderr, "moisture: kernel and scalar disagree on cell %zu: %f vs %f\n",
+                    i, field.cells[i], reference.cells[i]);
+                exit(1);
+            }
+        }
+
+        const double scalar = bench_moisture_run(&reference, NULL, true);
+        const double kernel = bench_moisture_run(&field, NULL, false);
+        const double threaded = bench_moisture_run(&field, &jobs, false);
+        printf("    %4dx%-4d cells: scalar %8.1f Mcells/sec, kernel %8.1f Mcells/sec (%.1fx), threaded %8.1f Mcells/sec (%.1fx)\n",
+            size, size, scalar / 1e6, kernel / 1e6, kernel / scalar, threaded / 1e6, threaded / scalar);
+
+        moisture_field_free(&reference);
+        moisture_field_free(&field);
+    }
+
+    job_system_free(&jobs);
+}
+
+// Terrain -----------------------------------------------------------------------------------------
+
+#define BENCH_TERRAIN_CELLS PAGE_CELLS
+// Half a chunk, for checking that a chunk comes out the same in pieces.
+#define BENCH_TERRAIN_HALF (BENCH_TERRAIN_CELLS / 2)
+// What a chunk is allowed to take, so streaming can keep up.
+#define BENCH_TERRAIN_BUDGET_MS 1.0
+
+// Random edits around the corner of the map, so plenty of them run into it.
+#define BENCH_TERRAIN_EDITS 4096
+#define BENCH_TERRAIN_EDIT_REACH 48
+
+typedef struct BenchTerrainChunk {
+    uint16_t gids[TERRAIN_KIND_COUNT][BENCH_TERRAIN_CELLS * BENCH_TERRAIN_CELLS];
+} BenchTerrainChunk;
+
+static void bench_terrain_generate(const Terrain *terrain, BenchTerrainChunk *chunk, int x, int y) {
+    uint16_t *const layers[TERRAIN_KIND_COUNT] = { chunk->gids[0], chunk->gids[1], chunk->gids[2], chunk->gids[3] };
+    terrain_generate(terrain, x * BENCH_TERRAIN_CELLS, y * BENCH_TERRAIN_CELLS, BENCH_TERRAIN_CELLS, BENCH_TERRAIN_CELLS, layers);
+}
+
+static bool bench_terrain_has(const Terrain *terrain, WorldPages *pages, TerrainKind kind, int x, int y) {
+    if (terrain_is_on_map(terrain, x, y)) return terrain_map_has(terrain, kind, x, y);
+    const Page *page = pages_get(pages, page_of_cell(x), page_of_cell(y));
+    return page->gids[kind][(x - page->x * PAGE_CELLS) + (y - page->y * PAGE_CELLS) * PAGE_CELLS] != 0;
+}
+
+// pages_set_terrain() only redoes the 3x3 around an edit. Every cell it could have touched has to
+// end up with the tile a full recompute from its neighbours would give it.
+static void bench_terrain_edits(const Terrain *terrain, const TmxMap *map) {
+    static WorldPages pages;
+    pages_init(&pages, map, WORLD_SEED);
+
+    static int edited[BENCH_TERRAIN_EDITS][2];
+    int edit_count = 0;
+    srand(420);
+    while (edit_count < BENCH_TERRAIN_EDITS) {
+        const int x = rand() % (2 * BENCH_TERRAIN_EDIT_REACH) - BENCH_TERRAIN_EDIT_REACH;
+        const int y = rand() % (2 * BENCH_TERRAIN_EDIT_REACH) - BENCH_TERRAIN_EDIT_REACH;
+        const TerrainKind kind = rand() % TERRAIN_KIND_COUNT;
+        if (terrain->tiles[kind].firstgid == 0) continue;
+        if (!pages_set_terrain(&pages, x, y, kind, rand() % 2 == 0)) continue;
+        edited[edit_count][0] = x;
+        edited[edit_count][1] = y;
+        edit_count++;
+    }
+
+    long checked = 0;
+    for (int e = 0; e < edit_count; e++) {
+        for (int cy = edited[e][1] - 1; cy <= edited[e][1] + 1; cy++) {
+            for (int cx = edited[e][0] - 1; cx <= edited[e][0] + 1; cx++) {
+                if (terrain_is_on_map(terrain, cx, cy)) continue;
+                const Page *page = pages_get(&pages, page_of_cell(cx), page_of_cell(cy));
+                const int i = (cx - page->x * PAGE_CELLS) + (cy - page->y * PAGE_CELLS) * PAGE_CELLS;
+                for (int kind = 0; kind < TERRAIN_KIND_COUNT; kind++) {
+                    if (!bench_terrain_has(terrain, &pages, kind, cx, cy)) continue;
+                    uint8_t mask = 0;
+                    for (int bit = 0; bit < 8; bit++) {
+                        if (bench_terrain_has(terrain, &pages, kind, cx + autotile_offsets[bit][0], cy + autotile_offsets[bit][1])) mask |= 1 << bit;
+                    }
+                    if (page->gids[kind][i] != terrain_tile(terrain, kind, cx, cy, mask)) {
+                        fprintf(stderr, "terrain: cell (%d, %d) has the wrong tile after an edit\n", cx, cy);
+                        exit(1);
+                    }
+                    checked++;
+                }
+            }
+        }
+    }
+    printf("    %d edits, %ld tiles match a full recompute\n", edit_count, checked);
+
+    pages_free(&pages);
+}
+
+static void bench_terrain(void) {
+    printf("terrain: %dx%d chunk generation\n", BENCH_TERRAIN_CELLS, BENCH_TERRAIN_CELLS);
+
+    MapBlob blob;
+    TmxMap map;
+    if (!map_blob_open(MAP_BLOB_PATH, &blob, &map)) {
+        fprintf(stderr, "terrain: could not open %s, run `./nob map`\n", MAP_BLOB_PATH);
+        exit(1);
+    }
+    Terrain terrain;
+    terrain_init(&terrain, &map, WORLD_SEED);
+
+    static BenchTerrainChunk chunk, other, pieces;
+
+    // A chunk has to come out the same after others were generated, and when it's generated a
+    // quarter at a time.
+    bench_terrain_generate(&terrain, &chunk, 3, -2);
+    bench_terrain_generate(&terrain, &other, -7, 11);
+    bench_terrain_generate(&terrain, &other, 3, -2);
+    for (int q = 0; q < 4; q++) {
+        static uint16_t quarter[TERRAIN_KIND_COUNT][BENCH_TERRAIN_HALF * BENCH_TERRAIN_HALF];
+        uint16_t *const layers[TERRAIN_KIND_COUNT] = { quarter[0], quarter[1], quarter[2], quarter[3] };
+        const int qx = q % 2 * BENCH_TERRAIN_HALF;
+        const int qy = q / 2 * BENCH_TERRAIN_HALF;
+        terrain_generate(&terrain, 3 * BENCH_TERRAIN_CELLS + qx, -2 * BENCH_TERRAIN_CELLS + qy, BENCH_TERRAIN_HALF, BENCH_TERRAIN_HALF, layers);
+        for (int kind = 0; kind < TERRAIN_KIND_COUNT; kind++) {
+            for (int row = 0; row < BENCH_TERRAIN_HALF; row++) {
+                memcpy(&pieces.gids[kind][qx + (qy + row) * BENCH_TERRAIN_CELLS],
+                    &quarter[kind][row * BENCH_TERRAIN_HALF], BENCH_TERRAIN_HALF * sizeof(uint16_t));
+            }
+        }
+    }
+    if (memcmp(&chunk, &other, sizeof(chunk)) != 0 || memcmp(&chunk, &pieces, sizeof(chunk)) != 0) {
+        fprintf(stderr, "terrain: generation is not deterministic\n");
+        exit(1);
+    }
+    bench_terrain_edits(&terrain, &map);
+
+    // Chunks all over the place, the way a player walking around would get them.
+    long chunks = 0;
+    long kinds[TERRAIN_KIND_COUNT] = { 0 };
+    const double started_at = bench_seconds();
+    double elapsed = 0.0;
+    do {
+        const int x = (int)(chunks % 37) - 18;
+        const int y = (int)(chunks / 37 % 29) - 14;
+        bench_terrain_generate(&terrain, &chunk, x, y);
+        for (int i = 0; i < BENCH_TERRAIN_CELLS * BENCH_TERRAIN_CELLS; i++) {
+            int top = TERRAIN_KIND_COUNT - 1;
+            while (top > 0 && chunk.gids[top][i] == 0) top--;
+            kinds[top]++;
+        }
+        chunks++;
+        elapsed = bench_seconds() - started_at;
+    } while (elapsed < BENCH_MIN_SECONDS);
+
+    const double ms = elapsed * 1e3 / chunks;
+    const long cells = chunks * BENCH_TERRAIN_CELLS * BENCH_TERRAIN_CELLS;
+    printf("    %8.3f ms/chunk (budget %.1f ms), %.0f%% water, %.0f%% grass, %.0f%% hills, %.0f%% dirt\n",
+        ms, BENCH_TERRAIN_BUDGET_MS,
+        100.0 * kinds[TERRAIN_WATER] / cells, 100.0 * kinds[TERRAIN_GRASS] / cells,
+        100.0 * kinds[TERRAIN_HILLS] / cells, 100.0 * kinds[TERRAIN_DIRT] / cells);
+    if (ms > BENCH_TERRAIN_BUDGET_MS) printf("    over budget!\n");
+
+    map_blob_close(&blob, &map);
+}
+
+// Saves -------------------------------------------------------------------------------------------
+
+// Long enough for the bot to plant, water and harvest a few rounds, and for the crops to grow.
+#define BENCH_SAVES_TICKS (SIM_TICKS_PER_SECOND * 60)
+#define BENCH_SAVES_ANIMALS 2000
+#define BENCH_SAVES_PATH "./build/bench.save"
+
+// The bench doesn't link raylib, these are the only parts of it the simulation logs through.
+void TraceLog(int level, const char *text, ...) {
+    if (level < LOG_WARNING) return;
+    va_list args;
+    va_start(args, text);
+    vfprintf(stderr, text, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+const char *TextFormat(const char *text, ...) {
+    static char buffer[1024];
+    va_list args;
+    va_start(args, text);
+    vsnprintf(buffer, sizeof(buffer), text, args);
+    va_end(args);
+    return buffer;
+}
+
+static void bench_saves(void) {
+    printf("saves: %d ticks on from a save against %d ticks on without one, %d more animals\n",
+        BENCH_SAVES_TICKS, BENCH_SAVES_TICKS, BENCH_SAVES_ANIMALS);
+
+    MapBlob blob;
+    TmxMap map;
+    if (!map_blob_open(MAP_BLOB_PATH, &blob, &map)) {
+        fprintf(stderr, "saves: could not open %s, run `./nob map`\n", MAP_BLOB_PATH);
+        exit(1);
+    }
+    static AnimLibrary clips;
+    if (!anim_library_load(&clips, ANIM_CLIPS_PATH, SIM_TICKS_PER_SECOND)) exit(1);
+    static JobSystem jobs;
+    job_system_init(&jobs, jobs_cpu_count());
+
+    // Play a while so there's a bit of everything to save: crops on every stage, wet soil, the
+    // player mid walk and animals mid turn.
+    static World world;
+    static FarmBot bot;
+    world_init(&world, &map, &clips, &jobs);
+    world_spawn_animals(&world, ANIMAL_CHICKEN, BENCH_SAVES_ANIMALS / 2);
+    world_spawn_animals(&world, ANIMAL_COW, BENCH_SAVES_ANIMALS / 2);
+    farm_bot_init(&bot, &world);
+    for (int i = 0; i < BENCH_SAVES_TICKS; i++) world_update(&world, farm_bot_input(&bot, &world));
+
+    remove(BENCH_SAVES_PATH);
+    static SaveWriter saver;
+    SaveStats stats;
+    save_writer_init(&saver, BENCH_SAVES_PATH);
+    if (!save_write(&saver, &world, &stats)) exit(1);
+    save_writer_free(&saver);
+    const uint64_t saved_hash = world_hash(&world);
+
+    // The bot keeps state of its own, so the loaded world gets the same input played back rather
+    // than a bot of its own.
+    Input *inputs = malloc(BENCH_SAVES_TICKS * sizeof(*inputs));
+    assert(inputs != NULL && "Buy more RAM lol");
+    for (int i = 0; i < BENCH_SAVES_TICKS; i++) {
+        inputs[i] = farm_bot_input(&bot, &world);
+        world_update(&world, inputs[i]);
+    }
+
+    static World loaded;
+    world_init(&loaded, &map, &clips, &jobs);
+    const double started_at = bench_seconds();
+    save_writer_init(&saver, BENCH_SAVES_PATH);
+    if (!save_load(&saver, &loaded)) exit(1);
+    const double elapsed = bench_seconds() - started_at;
+    save_writer_free(&saver);
+    // Some of what goes missing evens out again later on, like an animation that gets restarted,
+    // so it has to match right away too.
+    if (world_hash(&loaded) != saved_hash) {
+        fprintf(stderr, "saves: the loaded world is not the one that got saved\n");
+        exit(1);
+    }
+    for (int i = 0; i < BENCH_SAVES_TICKS; i++) world_update(&loaded, inputs[i]);
+
+    if (world_hash(&loaded) != world_hash(&world)) {
+        fprintf(stderr, "saves: the loaded world ended up somewhere else than the one that kept going\n");
+        exit(1);
+    }
+    printf("    %zu bytes saved in %.3f ms, loaded in %.3f ms, both end up the same\n",
+        stats.bytes, (stats.snapshot_seconds + stats.write_seconds) * 1e3, elapsed * 1e3);
+
+    free(inputs);
+    farm_bot_free(&bot);
+    remove(BENCH_SAVES_PATH);
+    job_system_free(&jobs);
+    anim_library_free(&clips);
+    map_blob_close(&blob, &map);
+}
+
+// Main --------------------------------------------------------------------------------------------
+
+typedef struct Bench {
+    const char *name;
+    void (*run)(void);
+} Bench;
+
+static const Bench benches[] = {
+    { "crops", bench_crops },
+    { "timers", bench_timers },
+    { "collision", bench_collision },
+    { "animals", bench_animals },
+    { "threads", bench_threads },
+    { "moisture", bench_moisture },
+    { "terrain", bench_terrain },
+    { "saves", bench_saves },
+};
+
+int main(int argc, char **argv) {
+    const char *only = argc > 1 ? argv[1] : NULL;
+
+    bool found = false;
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        if (only != NULL && strcmp(only, benches[i].name) != 0) continue;
+        benches[i].run();
+        found = true;
+    }
+
+    if (!found) {
+        fprintf(stderr, "Unknown benchmark %s\n", only);
+        return 1;
+    }
+
+    return 0;
+}
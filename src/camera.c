@@ -0,0 +1,42 @@
+#include <math.h>
+
+#include "camera.h"
+
+// Where the left (or top) edge of the screen goes along one axis.
+static float follow_camera_edge(float target, float screen, float world, bool unbounded) {
+    if (unbounded) return target - screen * 0.5f;
+
+    // The whole map fits, center it instead of following.
+    if (world <= screen) return (world - screen) * 0.5f;
+
+    float edge = target - screen * 0.5f;
+    if (edge < 0.0f) edge = 0.0f;
+    if (edge > world - screen) edge = world - screen;
+    return edge;
+}
+
+static int follow_camera_clamp(int x, int lo, int hi) {
+    return x < lo ? lo : x > hi ? hi : x;
+}
+
+void follow_camera_update(FollowCamera *cam, Vector2 target, float screen_width, float screen_height,
+    float world_width, float world_height, float cell_size) {
+    // Snap to whole pixels, otherwise the pixel art shimmers while walking.
+    const float left = floorf(follow_camera_edge(target.x, screen_width, world_width, cam->unbounded));
+    const float top = floorf(follow_camera_edge(target.y, screen_height, world_height, cam->unbounded));
+
+    cam->camera = (Camera2D) {
+        .offset = { 0.0f, 0.0f },
+        .target = { left, top },
+        .rotation = 0.0f,
+        .zoom = 1.0f,
+    };
+    cam->visible = (Rectangle) { left, top, screen_width, screen_height };
+
+    const int cols = (int)ceilf(world_width / cell_size);
+    const int rows = (int)ceilf(world_height / cell_size);
+    cam->cell_x0 = follow_camera_clamp((int)floorf(left / cell_size), 0, cols);
+    cam->cell_y0 = follow_camera_clamp((int)floorf(top / cell_size), 0, rows);
+    cam->cell_x1 = follow_camera_clamp((int)ceilf((left + screen_width) / cell_size), 0, cols);
+    cam->cell_y1 = follow_camera_clamp((int)ceilf((top + screen_height) / cell_size), 0, rows);
+}
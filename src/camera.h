@@ -0,0 +1,35 @@
+#ifndef CAMERA_H_
+#define CAMERA_H_
+
+#include <stdbool.h>
+#include <raylib.h>
+
+// Camera2D that keeps the player in the middle of the screen without ever showing past the edge of
+// the map (unless there's something to see past it, see `unbounded`), plus what it can see this
+// frame. Everything drawn in world space should be culled against `visible` (or the cell range) so
+// drawing scales with the screen, not with the world.
+
+typedef struct FollowCamera {
+    // Follow the player past the edge of the map too.
+    bool unbounded;
+    Camera2D camera;
+    // The part of the world on screen, in world coordinates.
+    Rectangle visible;
+    // Cells on screen, [cell_x0, cell_x1) x [cell_y0, cell_y1), clamped to the map.
+    int cell_x0, cell_y0, cell_x1, cell_y1;
+} FollowCamera;
+
+// `world_width` and `world_height` are the size of the map in world coordinates, `cell_size` the
+// size of a cell in world coordinates.
+void follow_camera_update(FollowCamera *cam, Vector2 target, float screen_width, float screen_height,
+    float world_width, float world_height, float cell_size);
+
+static inline bool follow_camera_sees(const FollowCamera *cam, Rectangle rect) {
+    return CheckCollisionRecs(cam->visible, rect);
+}
+
+static inline bool follow_camera_sees_cell(const FollowCamera *cam, int x, int y) {
+    return x >= cam->cell_x0 && x < cam->cell_x1 && y >= cam->cell_y0 && y < cam->cell_y1;
+}
+
+#endif // CAMERA_H_
@@ -0,0 +1,217 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nob.h"
+#include "collision.h"
+
+static int collision_clamp(int x, int lo, int hi) {
+    return x < lo ? lo : x > hi ? hi : x;
+}
+
+// Bucket range overlapped by `rect`, clamped to the grid so things hanging off the edge of the map
+// still land in the border buckets.
+static void collision_bucket_range(const CollisionWorld *cw, Rectangle rect, int *c0, int *r0, int *c1, int *r1) {
+    *c0 = collision_clamp((int)floorf(rect.x / cw->bucket_size), 0, cw->cols - 1);
+    *r0 = collision_clamp((int)floorf(rect.y / cw->bucket_size), 0, cw->rows - 1);
+    // Overlap is strict, a rect ending exactly on a bucket edge does not reach into the next one.
+    *c1 = collision_clamp((int)ceilf((rect.x + rect.width) / cw->bucket_size) - 1, *c0, cw->cols - 1);
+    *r1 = collision_clamp((int)ceilf((rect.y + rect.height) / cw->bucket_size) - 1, *r0, cw->rows - 1);
+}
+
+void collision_world_init(CollisionWorld *cw, int cols, int rows, float bucket_size) {
+    assert(cols > 0 && rows > 0 && bucket_size > 0.0f);
+    memset(cw, 0, sizeof(*cw));
+    cw->bucket_size = bucket_size;
+    cw->cols = cols;
+    cw->rows = rows;
+}
+
+void collision_world_free(CollisionWorld *cw) {
+    nob_da_free(cw->rects);
+    free(cw->bucket_start);
+    free(cw->bucket_items);
+    free(cw->stamps);
+    memset(cw, 0, sizeof(*cw));
+}
+
+void collision_world_add(CollisionWorld *cw, Rectangle rect) {
+    nob_da_append(&cw->rects, rect);
+}
+
+void collision_world_build(CollisionWorld *cw) {
+    const int bucket_count = cw->cols * cw->rows;
+
+    free(cw->bucket_start);
+    free(cw->bucket_items);
+    free(cw->stamps);
+
+    // Counting sort into the buckets: count, prefix sum, then scatter.
+    cw->bucket_start = calloc(bucket_count + 1, sizeof(int));
+    assert(cw->bucket_start != NULL && "Buy more RAM lol");
+
+    for (size_t i = 0; i < cw->rects.count; i++) {
+        int c0, r0, c1, r1;
+        collision_bucket_range(cw, cw->rects.items[i], &c0, &r0, &c1, &r1);
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                cw->bucket_start[r * cw->cols + c + 1]++;
+            }
+        }
+    }
+
+    for (int b = 0; b < bucket_count; b++) {
+        cw->bucket_start[b + 1] += cw->bucket_start[b];
+    }
+
+    int *cursor = malloc(bucket_count * sizeof(int));
+    cw->bucket_items = malloc((cw->bucket_start[bucket_count] + 1) * sizeof(int));
+    cw->stamps = calloc(cw->rects.count + 1, sizeof(uint32_t));
+    assert(cursor != NULL && cw->bucket_items != NULL && cw->stamps != NULL && "Buy more RAM lol");
+    memcpy(cursor, cw->bucket_start, bucket_count * sizeof(int));
+
+    for (size_t i = 0; i < cw->rects.count; i++) {
+        int c0, r0, c1, r1;
+        collision_bucket_range(cw, cw->rects.items[i], &c0, &r0, &c1, &r1);
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                cw->bucket_items[cursor[r * cw->cols + c]++] = (int)i;
+            }
+        }
+    }
+
+    free(cursor);
+    cw->stamp = 0;
+}
+
+static uint32_t collision_next_stamp(CollisionWorld *cw) {
+    cw->stamp++;
+    if (cw->stamp == 0) {
+        // Wrapped around, old stamps could now look like fresh ones.
+        memset(cw->stamps, 0, cw->rects.count * sizeof(uint32_t));
+        cw->stamp = 1;
+    }
+    return cw->stamp;
+}
+
+int collision_world_query(CollisionWorld *cw, Rectangle rect, int *out, int cap) {
+    assert(cw->bucket_start != NULL && "collision_world_build() was not called");
+
+    const uint32_t stamp = collision_next_stamp(cw);
+    int found = 0;
+
+    int c0, r0, c1, r1;
+    collision_bucket_range(cw, rect, &c0, &r0, &c1, &r1);
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            const int b = r * cw->cols + c;
+            for (int k = cw->bucket_start[b]; k < cw->bucket_start[b + 1]; k++) {
+                const int i = cw->bucket_items[k];
+                if (cw->stamps[i] == stamp) continue;
+                cw->stamps[i] = stamp;
+
+                if (collision_rects_overlap(rect, cw->rects.items[i])) {
+                    if (found == cap) return found;
+                    out[found++] = i;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+bool collision_world_overlaps(CollisionWorld *cw, Rectangle rect) {
+    int ignored;
+    return collision_world_query(cw, rect, &ignored, 1) > 0;
+}
+
+// Same as collision_world_query() but without the stamps, so any number of threads can sweep at
+// once. A rect spanning several buckets gets weeded out by looking through what was found so far
+// instead, which is cheap for the handful of hits a sweep has.
+static int collision_sweep_query(const CollisionWorld *cw, Rectangle rect, int *out, int cap) {
+    assert(cw->bucket_start != NULL && "collision_world_build() was not called");
+
+    int found = 0;
+    int c0, r0, c1, r1;
+    collision_bucket_range(cw, rect, &c0, &r0, &c1, &r1);
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            const int b = r * cw->cols + c;
+            for (int k = cw->bucket_start[b]; k < cw->bucket_start[b + 1]; k++) {
+                const int i = cw->bucket_items[k];
+                if (!collision_rects_overlap(rect, cw->rects.items[i])) continue;
+
+                bool seen = false;
+                for (int f = 0; f < found && !seen; f++) seen = out[f] == i;
+                if (seen) continue;
+
+                if (found == cap) return found;
+                out[found++] = i;
+            }
+        }
+    }
+
+    return found;
+}
+
+// Cuts `delta` short if the rect would run into `obstacle` on the way.
+static void collision_clip_axis(Rectangle rect, Rectangle obstacle, bool x_axis, float *delta, bool *blocked) {
+    // Already stuck in it, let the mover get out instead of pinning it in place.
+    if (collision_rects_overlap(rect, obstacle)) return;
+
+    float gap;
+    if (x_axis) {
+        gap = *delta > 0.0f ? obstacle.x - (rect.x + rect.width) : (obstacle.x + obstacle.width) - rect.x;
+    } else {
+        gap = *delta > 0.0f ? obstacle.y - (rect.y + rect.height) : (obstacle.y + obstacle.height) - rect.y;
+    }
+
+    // `gap` has the sign of the direction the obstacle is in, behind us does not count.
+    if (*delta > 0.0f && gap >= 0.0f && gap < *delta) {
+        *delta = gap;
+        *blocked = true;
+    } else if (*delta < 0.0f && gap <= 0.0f && gap > *delta) {
+        *delta = gap;
+        *blocked = true;
+    }
+}
+
+// Sweeps `rect` along one axis by `delta` and returns how far it actually gets before touching
+// an obstacle.
+static float collision_sweep_axis(const CollisionWorld *cw, const Rectangle *extra, size_t extra_count, Rectangle rect, float delta, bool x_axis, bool *blocked) {
+    *blocked = false;
+    if (delta == 0.0f) return 0.0f;
+
+    // The area the rect covers over the whole move.
+    Rectangle swept = rect;
+    if (x_axis) {
+        swept.width += fabsf(delta);
+        if (delta < 0.0f) swept.x += delta;
+    } else {
+        swept.height += fabsf(delta);
+        if (delta < 0.0f) swept.y += delta;
+    }
+
+    int hits[COLLISION_SWEEP_CAP];
+    const int hit_count = collision_sweep_query(cw, swept, hits, COLLISION_SWEEP_CAP);
+    for (int h = 0; h < hit_count; h++) collision_clip_axis(rect, cw->rects.items[hits[h]], x_axis, &delta, blocked);
+    for (size_t e = 0; e < extra_count; e++) {
+        if (collision_rects_overlap(swept, extra[e])) collision_clip_axis(rect, extra[e], x_axis, &delta, blocked);
+    }
+
+    return delta;
+}
+
+void collision_world_move(const CollisionWorld *cw, CollisionMover *movers, size_t count) {
+    collision_world_move_among(cw, NULL, 0, movers, count);
+}
+
+void collision_world_move_among(const CollisionWorld *cw, const Rectangle *extra, size_t extra_count, CollisionMover *movers, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        CollisionMover *mover = &movers[i];
+        mover->rect.x += collision_sweep_axis(cw, extra, extra_count, mover->rect, mover->delta.x, true, &mover->blocked_x);
+        mover->rect.y += collision_sweep_axis(cw, extra, extra_count, mover->rect, mover->delta.y, false, &mover->blocked_y);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef COLLISION_H_
+#define COLLISION_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <raylib.h>
+
+// Static obstacles bucketed in a uniform grid. Add every rectangle, build once, then each query
+// only looks at the buckets the query rectangle overlaps instead of every obstacle in the world.
+//
+// Buckets are stored CSR style: the rects of bucket `b` are
+// `bucket_items[bucket_start[b] .. bucket_start[b + 1]]`.
+
+typedef struct CollisionWorld {
+    float bucket_size;
+    int cols, rows;
+
+    struct { Rectangle *items; size_t count, capacity; } rects;
+
+    int *bucket_start;
+    int *bucket_items;
+
+    // A rect spanning several buckets should only be tested once per query. `stamps[i]` is the
+    // last query that looked at rect i.
+    uint32_t *stamps;
+    uint32_t stamp;
+} CollisionWorld;
+
+void collision_world_init(CollisionWorld *cw, int cols, int rows, float bucket_size);
+void collision_world_free(CollisionWorld *cw);
+
+void collision_world_add(CollisionWorld *cw, Rectangle rect);
+// Call after the last collision_world_add() and before the first query.
+void collision_world_build(CollisionWorld *cw);
+
+bool collision_world_overlaps(CollisionWorld *cw, Rectangle rect);
+// Writes the indices of up to `cap` rects overlapping `rect` into `out`, returns how many it found.
+int collision_world_query(CollisionWorld *cw, Rectangle rect, int *out, int cap);
+
+// Anything that moves through the static obstacles. `delta` is how far it wants to go this step,
+// collision_world_move() writes the resolved `rect` back and flags the axes it got stopped on.
+typedef struct CollisionMover {
+    Rectangle rect;
+    Vector2 delta;
+    bool blocked_x, blocked_y;
+} CollisionMover;
+
+// How many obstacles a single axis sweep considers. Way more than a mover can touch in one tick.
+#define COLLISION_SWEEP_CAP 64
+
+// Moves every mover by its delta, x first and then y, sliding along whatever it hits. Each axis
+// is swept over the whole distance in one go, so fast movers can't tunnel through thin walls.
+// Movers don't collide with each other, only with the static rects. A mover that already overlaps
+// an obstacle is allowed to move out of it. Only reads `cw`, so disjoint batches of movers can be
+// moved from several threads at once.
+void collision_world_move(const CollisionWorld *cw, CollisionMover *movers, size_t count);
+// Same, but also against `extra` obstacles that aren't in the grid, like the streamed terrain
+// around the player.
+void collision_world_move_among(const CollisionWorld *cw, const Rectangle *extra, size_t extra_count, CollisionMover *movers, size_t count);
+
+static inline bool collision_rects_overlap(Rectangle a, Rectangle b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+#endif // COLLISION_H_
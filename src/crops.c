@@ -0,0 +1,177 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CROPS_SSE2
+#endif
+
+#include "crops.h"
+
+CropStore crop_store_create(int count) {
+    CropStore store = {
+        .count = count,
+        .planted_at = calloc(count, sizeof(uint32_t)),
+        .stage = calloc(count, sizeof(uint8_t)),
+    };
+    assert(store.planted_at != NULL && store.stage != NULL && "Buy more RAM lol");
+    return store;
+}
+
+void crop_store_destroy(CropStore *store) {
+    free(store->planted_at);
+    free(store->stage);
+    memset(store, 0, sizeof(*store));
+}
+
+// Cells -------------------------------------------------------------------------------------------
+
+void crop_plant(CropStore *store, int id, uint32_t now) {
+    assert(now > 0 && "tick 0 means never planted");
+    store->planted_at[id] = now;
+    store->stage[id] = CROP_STAGE_SEED;
+}
+
+void crop_clear(CropStore *store, int id) {
+    store->planted_at[id] = 0;
+    store->stage[id] = CROP_STAGE_NONE;
+}
+
+bool crop_grow(CropStore *store, int id) {
+    assert(store->stage[id] != CROP_STAGE_NONE && "growing a cell with nothing planted on it");
+    if (store->stage[id] < CROP_STAGE_GROWN) store->stage[id]++;
+    return store->stage[id] < CROP_STAGE_GROWN;
+}
+
+bool crop_is_planted(const CropStore *store, int id) {
+    return store->planted_at[id] != 0;
+}
+
+bool crop_is_full_grown(const CropStore *store, int id) {
+    return store->stage[id] == CROP_STAGE_GROWN;
+}
+
+uint32_t crop_stage_ticks(float moisture) {
+    if (moisture < 0.0f) moisture = 0.0f;
+    if (moisture > 1.0f) moisture = 1.0f;
+    const float rate = (1.0f + (CROP_DRY_SLOWDOWN - 1) * moisture) / CROP_DRY_SLOWDOWN;
+    return (uint32_t)(CROP_TICKS_PER_STAGE / rate + 0.5f);
+}
+
+// Kernels -----------------------------------------------------------------------------------------
+
+static inline uint8_t crop_stage_at(uint32_t planted_at, uint32_t now) {
+    if (planted_at == 0) return CROP_STAGE_NONE;
+
+    // Signed, a crop planted "in the future" is just a seed.
+    const int32_t elapsed = (int32_t)(now - planted_at);
+    return CROP_STAGE_SEED
+        + (elapsed >= 1 * CROP_TICKS_PER_STAGE)
+        + (elapsed >= 2 * CROP_TICKS_PER_STAGE)
+        + (elapsed >= 3 * CROP_TICKS_PER_STAGE);
+}
+
+void crops_eval_stages_scalar(CropStore *store, uint32_t now) {
+    for (int i = 0; i < store->count; i++) {
+        store->stage[i] = crop_stage_at(store->planted_at[i], now);
+    }
+}
+
+#if defined(__AVX2__)
+
+// Same math as crop_stage_at(), 8 lanes at a time. `elapsed >= t` is `elapsed > t - 1`, the
+// comparisons produce -1 per passed threshold, so `SEED - sum` is the stage, masked to 0 where
+// nothing is planted.
+static inline __m256i crops_stage8(const uint32_t *planted_at, __m256i now, __m256i t1, __m256i t2, __m256i t3) {
+    const __m256i planted = _mm256_loadu_si256((const __m256i *)planted_at);
+    const __m256i elapsed = _mm256_sub_epi32(now, planted);
+    const __m256i not_planted = _mm256_cmpeq_epi32(planted, _mm256_setzero_si256());
+
+    __m256i passed = _mm256_cmpgt_epi32(elapsed, t1);
+    passed = _mm256_add_epi32(passed, _mm256_cmpgt_epi32(elapsed, t2));
+    passed = _mm256_add_epi32(passed, _mm256_cmpgt_epi32(elapsed, t3));
+
+    const __m256i stage = _mm256_sub_epi32(_mm256_set1_epi32(CROP_STAGE_SEED), passed);
+    return _mm256_andnot_si256(not_planted, stage);
+}
+
+void crops_eval_stages(CropStore *store, uint32_t now) {
+    const __m256i now8 = _mm256_set1_epi32((int32_t)now);
+    const __m256i t1 = _mm256_set1_epi32(1 * CROP_TICKS_PER_STAGE - 1);
+    const __m256i t2 = _mm256_set1_epi32(2 * CROP_TICKS_PER_STAGE - 1);
+    const __m256i t3 = _mm256_set1_epi32(3 * CROP_TICKS_PER_STAGE - 1);
+    // The packs work per 128-bit lane, this puts the dwords back in order afterwards.
+    const __m256i unshuffle = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int i = 0;
+    for (; i + 32 <= store->count; i += 32) {
+        const __m256i a = crops_stage8(store->planted_at + i +  0, now8, t1, t2, t3);
+        const __m256i b = crops_stage8(store->planted_at + i +  8, now8, t1, t2, t3);
+        const __m256i c = crops_stage8(store->planted_at + i + 16, now8, t1, t2, t3);
+        const __m256i d = crops_stage8(store->planted_at + i + 24, now8, t1, t2, t3);
+        const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+        _mm256_storeu_si256((__m256i *)(store->stage + i), _mm256_permutevar8x32_epi32(packed, unshuffle));
+    }
+    for (; i < store->count; i++) {
+        store->stage[i] = crop_stage_at(store->planted_at[i], now);
+    }
+}
+
+const char *crops_kernel_name(void) {
+    return "avx2";
+}
+
+#elif defined(CROPS_SSE2)
+
+// Same math as crop_stage_at(), 4 lanes at a time. See the AVX2 version.
+static inline __m128i crops_stage4(const uint32_t *planted_at, __m128i now, __m128i t1, __m128i t2, __m128i t3) {
+    const __m128i planted = _mm_loadu_si128((const __m128i *)planted_at);
+    const __m128i elapsed = _mm_sub_epi32(now, planted);
+    const __m128i not_planted = _mm_cmpeq_epi32(planted, _mm_setzero_si128());
+
+    __m128i passed = _mm_cmpgt_epi32(elapsed, t1);
+    passed = _mm_add_epi32(passed, _mm_cmpgt_epi32(elapsed, t2));
+    passed = _mm_add_epi32(passed, _mm_cmpgt_epi32(elapsed, t3));
+
+    const __m128i stage = _mm_sub_epi32(_mm_set1_epi32(CROP_STAGE_SEED), passed);
+    return _mm_andnot_si128(not_planted, stage);
+}
+
+void crops_eval_stages(CropStore *store, uint32_t now) {
+    const __m128i now4 = _mm_set1_epi32((int32_t)now);
+    const __m128i t1 = _mm_set1_epi32(1 * CROP_TICKS_PER_STAGE - 1);
+    const __m128i t2 = _mm_set1_epi32(2 * CROP_TICKS_PER_STAGE - 1);
+    const __m128i t3 = _mm_set1_epi32(3 * CROP_TICKS_PER_STAGE - 1);
+
+    int i = 0;
+    for (; i + 16 <= store->count; i += 16) {
+        const __m128i a = crops_stage4(store->planted_at + i +  0, now4, t1, t2, t3);
+        const __m128i b = crops_stage4(store->planted_at + i +  4, now4, t1, t2, t3);
+        const __m128i c = crops_stage4(store->planted_at + i +  8, now4, t1, t2, t3);
+        const __m128i d = crops_stage4(store->planted_at + i + 12, now4, t1, t2, t3);
+        const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128((__m128i *)(store->stage + i), packed);
+    }
+    for (; i < store->count; i++) {
+        store->stage[i] = crop_stage_at(store->planted_at[i], now);
+    }
+}
+
+const char *crops_kernel_name(void) {
+    return "sse2";
+}
+
+#else
+
+void crops_eval_stages(CropStore *store, uint32_t now) {
+    crops_eval_stages_scalar(store, now);
+}
+
+const char *crops_kernel_name(void) {
+    return "scalar";
+}
+
+#endif
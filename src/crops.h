@@ -0,0 +1,57 @@
+#ifndef CROPS_H_
+#define CROPS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Crop state for every cell on the map, stored as parallel columns (one entry per cell id) so the
+// growth kernel can chew through them with SIMD instead of chasing a struct per cell.
+//
+// Times are simulation ticks. Nothing in here ticks on its own, the world schedules a timer per
+// stage transition (see timers.h) and calls crop_grow() when it fires.
+
+// How long a stage takes in soaked soil, one second at SIM_TICKS_PER_SECOND.
+#define CROP_TICKS_PER_STAGE 144
+// How many times longer it takes in bone dry soil.
+#define CROP_DRY_SLOWDOWN 4
+
+typedef enum {
+    CROP_STAGE_NONE = 0,
+    CROP_STAGE_SEED,
+    CROP_STAGE_SPROUT,
+    CROP_STAGE_GROWING,
+    CROP_STAGE_GROWN,
+} CropStage;
+
+typedef struct CropStore {
+    int count;
+    // Tick it happened at, 0 means "never". uint32_t lasts for about a year of play at 144 ticks
+    // per second.
+    uint32_t *planted_at;
+    // CropStage, kept up to date by crop_grow().
+    uint8_t *stage;
+} CropStore;
+
+CropStore crop_store_create(int count);
+void crop_store_destroy(CropStore *store);
+
+void crop_plant(CropStore *store, int id, uint32_t now);
+void crop_clear(CropStore *store, int id);
+// Moves the crop one stage further, returns whether it can still grow after that.
+bool crop_grow(CropStore *store, int id);
+bool crop_is_planted(const CropStore *store, int id);
+bool crop_is_full_grown(const CropStore *store, int id);
+// Ticks the next stage takes at `moisture` (0 to 1, see moisture.h). Growth speeds up linearly
+// with it, from CROP_TICKS_PER_STAGE * CROP_DRY_SLOWDOWN down to CROP_TICKS_PER_STAGE.
+uint32_t crop_stage_ticks(float moisture);
+
+// Reference kernels for `./nob bench crops`, nothing in the game calls them. They recompute `stage`
+// for every cell from `planted_at` alone, as if every stage took CROP_TICKS_PER_STAGE, which is
+// only how crops grow in soaked soil. Real growth depends on moisture and goes through the timer
+// wheel, and saves restore the stages as they were (see world_restore_crop()). Uses AVX2 or SSE2
+// when the compiler targets them and falls back to crops_eval_stages_scalar() otherwise.
+void crops_eval_stages(CropStore *store, uint32_t now);
+void crops_eval_stages_scalar(CropStore *store, uint32_t now);
+const char *crops_kernel_name(void);
+
+#endif // CROPS_H_
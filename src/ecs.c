@@ -0,0 +1,115 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nob.h"
+#include "ecs.h"
+
+#define ENTITY_GENERATION_MASK ((1u << (32 - ENTITY_INDEX_BITS)) - 1)
+
+static Entity entity_make(uint32_t index, uint32_t generation) {
+    return (generation << ENTITY_INDEX_BITS) | index;
+}
+
+// Entities ----------------------------------------------------------------------------------------
+
+void entity_pool_free(EntityPool *pool) {
+    nob_da_free(pool->generations);
+    nob_da_free(pool->free_indices);
+    memset(pool, 0, sizeof(*pool));
+}
+
+Entity entity_create(EntityPool *pool) {
+    uint32_t index;
+    if (pool->free_indices.count > 0) {
+        index = pool->free_indices.items[--pool->free_indices.count];
+    } else {
+        assert(pool->generations.count < ENTITY_CAPACITY && "ran out of entities");
+        index = (uint32_t)pool->generations.count;
+        // Generation 0 would make the first entity come out as ENTITY_NONE.
+        nob_da_append(&pool->generations, 1);
+    }
+
+    pool->alive++;
+    return entity_make(index, pool->generations.items[index]);
+}
+
+void entity_destroy(EntityPool *pool, Entity entity) {
+    assert(entity_is_alive(pool, entity));
+
+    const uint32_t index = entity_index(entity);
+    uint32_t generation = (pool->generations.items[index] + 1) & ENTITY_GENERATION_MASK;
+    if (generation == 0) generation = 1;
+    pool->generations.items[index] = generation;
+
+    nob_da_append(&pool->free_indices, index);
+    pool->alive--;
+}
+
+bool entity_is_alive(const EntityPool *pool, Entity entity) {
+    const uint32_t index = entity_index(entity);
+    if (entity == ENTITY_NONE || index >= pool->generations.count) return false;
+    return entity_make(index, pool->generations.items[index]) == entity;
+}
+
+// Components --------------------------------------------------------------------------------------
+
+void component_store_init(ComponentStore *store, size_t size) {
+    memset(store, 0, sizeof(*store));
+    store->size = size;
+}
+
+void component_store_free(ComponentStore *store) {
+    free(store->sparse);
+    free(store->entities);
+    free(store->data);
+    memset(store, 0, sizeof(*store));
+}
+
+void *component_add(ComponentStore *store, Entity entity) {
+    void *existing = component_get(store, entity);
+    if (existing != NULL) return existing;
+
+    const uint32_t index = entity_index(entity);
+    if (index >= store->sparse_count) {
+        size_t sparse_count = store->sparse_count == 0 ? 256 : store->sparse_count;
+        while (sparse_count <= index) sparse_count *= 2;
+
+        store->sparse = realloc(store->sparse, sparse_count * sizeof(uint32_t));
+        assert(store->sparse != NULL && "Buy more RAM lol");
+        memset(store->sparse + store->sparse_count, 0, (sparse_count - store->sparse_count) * sizeof(uint32_t));
+        store->sparse_count = sparse_count;
+    }
+
+    if (store->count == store->capacity) {
+        store->capacity = store->capacity == 0 ? 256 : store->capacity * 2;
+        store->entities = realloc(store->entities, store->capacity * sizeof(Entity));
+        store->data = realloc(store->data, store->capacity * store->size);
+        assert(store->entities != NULL && store->data != NULL && "Buy more RAM lol");
+    }
+
+    const size_t slot = store->count++;
+    store->entities[slot] = entity;
+    store->sparse[index] = (uint32_t)slot + 1;
+
+    void *component = (char *)store->data + slot * store->size;
+    memset(component, 0, store->size);
+    return component;
+}
+
+void component_remove(ComponentStore *store, Entity entity) {
+    if (!component_has(store, entity)) return;
+
+    const uint32_t index = entity_index(entity);
+    const size_t slot = store->sparse[index] - 1;
+    const size_t last = --store->count;
+
+    // Swap the last component into the hole so the array stays dense.
+    if (slot != last) {
+        const Entity moved = store->entities[last];
+        store->entities[slot] = moved;
+        memcpy((char *)store->data + slot * store->size, (char *)store->data + last * store->size, store->size);
+        store->sparse[entity_index(moved)] = (uint32_t)slot + 1;
+    }
+    store->sparse[index] = 0;
+}
@@ -0,0 +1,83 @@
+#ifndef ECS_H_
+#define ECS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Entities are nothing but ids, whatever they are made of lives in one ComponentStore per
+// component type. A store is a sparse set: the components themselves are packed into a dense array
+// (so a system walking over, say, every transform touches contiguous memory only), and `sparse`
+// maps an entity to its slot in there for the lookups that go the other way.
+//
+// Removing a component moves the last one into the hole, so the order of the dense array changes
+// and pointers into it are only good until the next add or remove on that store.
+
+// Index in the low ENTITY_INDEX_BITS, generation above that. 0 is never a valid entity.
+typedef uint32_t Entity;
+
+#define ENTITY_NONE 0
+#define ENTITY_INDEX_BITS 20
+#define ENTITY_CAPACITY (1u << ENTITY_INDEX_BITS)
+
+typedef struct EntityPool {
+    // Current generation of every index handed out so far.
+    struct { uint32_t *items; size_t count, capacity; } generations;
+    struct { uint32_t *items; size_t count, capacity; } free_indices;
+    size_t alive;
+} EntityPool;
+
+void entity_pool_free(EntityPool *pool);
+Entity entity_create(EntityPool *pool);
+// The caller is on the hook for removing the components of the entity first.
+void entity_destroy(EntityPool *pool, Entity entity);
+bool entity_is_alive(const EntityPool *pool, Entity entity);
+
+static inline uint32_t entity_index(Entity entity) {
+    return entity & (ENTITY_CAPACITY - 1);
+}
+
+typedef struct ComponentStore {
+    // Bytes per component.
+    size_t size;
+    // Indexed by entity index: slot in the dense arrays plus one, 0 if the entity doesn't have the
+    // component. Grows on demand.
+    uint32_t *sparse;
+    size_t sparse_count;
+    // Dense, `entities[i]` owns component `i`.
+    Entity *entities;
+    void *data;
+    size_t count, capacity;
+} ComponentStore;
+
+void component_store_init(ComponentStore *store, size_t size);
+void component_store_free(ComponentStore *store);
+
+// Returns the component of `entity`, zeroed if it didn't have one yet.
+void *component_add(ComponentStore *store, Entity entity);
+void component_remove(ComponentStore *store, Entity entity);
+
+// NULL if the entity doesn't have the component.
+static inline void *component_get(const ComponentStore *store, Entity entity) {
+    const uint32_t index = entity_index(entity);
+    if (index >= store->sparse_count) return NULL;
+
+    const uint32_t slot = store->sparse[index];
+    // The index might have been reused by a newer entity since.
+    if (slot == 0 || store->entities[slot - 1] != entity) return NULL;
+    return (char *)store->data + (slot - 1) * store->size;
+}
+
+// Same as component_get(), but looks at `slot` first. Stores that always get their components
+// added and removed together keep the same order, so walking one of them and looking the entity up
+// in the others by the same slot never has to go through `sparse`.
+static inline void *component_get_hint(const ComponentStore *store, Entity entity, size_t slot) {
+    if (slot < store->count && store->entities[slot] == entity) return (char *)store->data + slot * store->size;
+    return component_get(store, entity);
+}
+
+static inline bool component_has(const ComponentStore *store, Entity entity) {
+    return component_get(store, entity) != NULL;
+}
+
+#endif // ECS_H_
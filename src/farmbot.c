@@ -0,0 +1,107 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "farmbot.h"
+
+// Close enough to the spot it's walking to. A tick of walking moves further than this, but never
+// twice as far, so it can't overshoot back and forth.
+#define FARMBOT_ARRIVE_DISTANCE (PLAYER_WALKING_SPEED * SIM_DT)
+
+static const uint16_t farm_bot_slots[FARMBOT_PASS_COUNT] = {
+    [FARMBOT_PLANT] = INPUT_SLOT_1,
+    [FARMBOT_WATER] = INPUT_SLOT_2,
+    [FARMBOT_HARVEST] = INPUT_SLOT_3,
+};
+
+void farm_bot_init(FarmBot *bot, const World *world) {
+    memset(bot, 0, sizeof(*bot));
+
+    const int cell_count = world->cols * world->rows;
+    bot->cells = malloc(cell_count * sizeof(int));
+    assert(bot->cells != NULL && "Buy more RAM lol");
+
+    // Cells in the first column have nowhere to be worked from.
+    for (int id = 0; id < cell_count; id++) {
+        if (id % world->cols == 0 || !tile_mask_test_id(&world->farmable, id)) continue;
+        bot->cells[bot->cell_count++] = id;
+    }
+}
+
+void farm_bot_free(FarmBot *bot) {
+    free(bot->cells);
+    memset(bot, 0, sizeof(*bot));
+}
+
+static void farm_bot_next_target(FarmBot *bot) {
+    bot->target_ticks = 0;
+    bot->arrived = false;
+    bot->target++;
+    if (bot->target < bot->cell_count) return;
+
+    bot->target = 0;
+    bot->pass++;
+    if (bot->pass == FARMBOT_PASS_COUNT) {
+        bot->pass = FARMBOT_PLANT;
+        bot->rounds++;
+    }
+}
+
+// Whether there's anything to do on the cell at all this pass, so it doesn't walk over for nothing.
+static bool farm_bot_needs_work(const FarmBot *bot, const World *world, int id) {
+    switch (bot->pass) {
+        case FARMBOT_PLANT: return !crop_is_planted(&world->crops, id);
+        case FARMBOT_WATER: return true;
+        case FARMBOT_HARVEST: return crop_is_planted(&world->crops, id);
+        default: return false;
+    }
+}
+
+Input farm_bot_input(FarmBot *bot, const World *world) {
+    Input input = { 0 };
+    if (bot->cell_count == 0 || world->game_state.paused) return input;
+
+    // Every cell needs watering, so this is over within a round.
+    while (!farm_bot_needs_work(bot, world, bot->cells[bot->target])) farm_bot_next_target(bot);
+
+    if (bot->target_ticks++ >= FARMBOT_TARGET_TICKS) {
+        bot->skipped++;
+        farm_bot_next_target(bot);
+        return input;
+    }
+
+    const int id = bot->cells[bot->target];
+    const float cell_size = MAP_CELL_SIZE * MAP_SCALE;
+    const Vector2 spot = {
+        (id % world->cols - 1 + 0.5f) * cell_size,
+        (id / world->cols + 0.5f) * cell_size,
+    };
+    const Vector2 pos = get_character_pos(world->player);
+
+    // Walk over, up or down first and then sideways.
+    if (!bot->arrived && fabsf(spot.y - pos.y) > FARMBOT_ARRIVE_DISTANCE) {
+        input.down = spot.y < pos.y ? INPUT_UP : INPUT_DOWN;
+        return input;
+    }
+    if (!bot->arrived && fabsf(spot.x - pos.x) > FARMBOT_ARRIVE_DISTANCE) {
+        input.down = spot.x < pos.x ? INPUT_LEFT : INPUT_RIGHT;
+        return input;
+    }
+    bot->arrived = true;
+
+    // Turning around takes a tick of walking, that's less than a cell.
+    if (get_cell_id_player_is_facing(world, world->player) != id) {
+        input.down = INPUT_RIGHT;
+        return input;
+    }
+
+    // The crop is still growing, stand there until it's done.
+    if (bot->pass == FARMBOT_HARVEST && !crop_is_full_grown(&world->crops, id)) return input;
+
+    input.pressed = farm_bot_slots[bot->pass] | INPUT_USE;
+    if (bot->pass == FARMBOT_PLANT) bot->planted++;
+    if (bot->pass == FARMBOT_HARVEST) bot->harvested++;
+    farm_bot_next_target(bot);
+    return input;
+}
@@ -0,0 +1,49 @@
+#ifndef FARMBOT_H_
+#define FARMBOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+// A scripted player for workloads that come out the same every run. Round after round it walks
+// up to every farmable cell of the map and plants it, then goes around again with the watering
+// can, then once more with the scythe, waiting at every crop that isn't grown yet. All it does is
+// hand out Input, so a run of it can be recorded into a replay like any other (see replay.h).
+//
+// Every cell gets worked from the one left of it, facing right. It walks there straight, first up
+// or down and then sideways, so it gets stuck on walls in between. After FARMBOT_TARGET_TICKS on
+// the same cell it gives up on that one and moves on.
+
+#define FARMBOT_TARGET_TICKS (SIM_TICKS_PER_SECOND * 20)
+
+typedef enum {
+    FARMBOT_PLANT = 0,
+    FARMBOT_WATER,
+    FARMBOT_HARVEST,
+    FARMBOT_PASS_COUNT,
+} FarmBotPass;
+
+typedef struct FarmBot {
+    // Farmable cell ids, in the order they get visited.
+    int *cells;
+    int cell_count;
+
+    FarmBotPass pass;
+    int target;
+    // Ticks spent on the current target so far.
+    uint32_t target_ticks;
+    // Made it to the spot next to the target. Turning towards it moves the player a bit, this
+    // keeps it from walking back and forth over the spot from then on.
+    bool arrived;
+
+    // How much it got done, for the logs.
+    int rounds, planted, harvested, skipped;
+} FarmBot;
+
+void farm_bot_init(FarmBot *bot, const World *world);
+void farm_bot_free(FarmBot *bot);
+// What the bot does this tick, given the world as it is after the last one.
+Input farm_bot_input(FarmBot *bot, const World *world);
+
+#endif // FARMBOT_H_
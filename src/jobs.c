@@ -0,0 +1,358 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "jobs.h"
+#include "profiler.h"
+
+// Most jobs a single loop gets cut into. Every queue can hold all of them, so dealing them out
+// never has to wait for room.
+#define JOB_QUEUE_CAPACITY 1024
+
+// Threads -----------------------------------------------------------------------------------------
+
+#ifdef _WIN32
+typedef SRWLOCK JobMutex;
+typedef CONDITION_VARIABLE JobCond;
+typedef HANDLE JobThread;
+
+static void job_mutex_init(JobMutex *m) { InitializeSRWLock(m); }
+static void job_mutex_destroy(JobMutex *m) { (void)m; }
+static void job_mutex_lock(JobMutex *m) { AcquireSRWLockExclusive(m); }
+static void job_mutex_unlock(JobMutex *m) { ReleaseSRWLockExclusive(m); }
+static void job_cond_init(JobCond *c) { InitializeConditionVariable(c); }
+static void job_cond_destroy(JobCond *c) { (void)c; }
+static void job_cond_wait(JobCond *c, JobMutex *m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void job_cond_broadcast(JobCond *c) { WakeAllConditionVariable(c); }
+#else
+typedef pthread_mutex_t JobMutex;
+typedef pthread_cond_t JobCond;
+typedef pthread_t JobThread;
+
+static void job_mutex_init(JobMutex *m) { pthread_mutex_init(m, NULL); }
+static void job_mutex_destroy(JobMutex *m) { pthread_mutex_destroy(m); }
+static void job_mutex_lock(JobMutex *m) { pthread_mutex_lock(m); }
+static void job_mutex_unlock(JobMutex *m) { pthread_mutex_unlock(m); }
+static void job_cond_init(JobCond *c) { pthread_cond_init(c, NULL); }
+static void job_cond_destroy(JobCond *c) { pthread_cond_destroy(c); }
+static void job_cond_wait(JobCond *c, JobMutex *m) { pthread_cond_wait(c, m); }
+static void job_cond_broadcast(JobCond *c) { pthread_cond_broadcast(c); }
+#endif
+
+int jobs_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+// Queues ------------------------------------------------------------------------------------------
+
+typedef struct Job {
+    JobFn fn;
+    void *ctx;
+    size_t begin, end;
+} Job;
+
+typedef struct JobQueue {
+    JobMutex lock;
+    Job jobs[JOB_QUEUE_CAPACITY];
+    // Thieves take from `head`, the owner pushes and pops at `tail`. Both only ever grow, the slot
+    // is the value modulo the capacity.
+    size_t head, tail;
+} JobQueue;
+
+typedef struct JobWorkerArgs {
+    struct JobShared *shared;
+    int index;
+} JobWorkerArgs;
+
+typedef struct JobShared {
+    JobSystem *jobs;
+    JobQueue *queues;
+    JobThread *threads;
+    JobWorkerArgs *args;
+
+    // Guards everything below.
+    JobMutex lock;
+    JobCond wake;
+    JobCond done;
+    // Bumped after every loop got dealt out, so a worker can tell it missed one while looking for
+    // jobs and shouldn't go to sleep.
+    uint64_t generation;
+    size_t pending;
+    bool quit;
+} JobShared;
+
+static void job_queue_push(JobQueue *queue, Job job) {
+    job_mutex_lock(&queue->lock);
+    assert(queue->tail - queue->head < JOB_QUEUE_CAPACITY);
+    queue->jobs[queue->tail++ % JOB_QUEUE_CAPACITY] = job;
+    job_mutex_unlock(&queue->lock);
+}
+
+static bool job_queue_pop(JobQueue *queue, Job *job) {
+    job_mutex_lock(&queue->lock);
+    const bool found = queue->tail > queue->head;
+    if (found) *job = queue->jobs[--queue->tail % JOB_QUEUE_CAPACITY];
+    job_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static bool job_queue_steal(JobQueue *queue, Job *job) {
+    job_mutex_lock(&queue->lock);
+    const bool found = queue->tail > queue->head;
+    if (found) *job = queue->jobs[queue->head++ % JOB_QUEUE_CAPACITY];
+    job_mutex_unlock(&queue->lock);
+    return found;
+}
+
+// Own queue first, then everybody else's starting with the next thread over.
+static bool job_take(JobShared *shared, int self, Job *job) {
+    if (job_queue_pop(&shared->queues[self], job)) return true;
+
+    const int thread_count = shared->jobs->thread_count;
+    for (int i = 1; i < thread_count; i++) {
+        if (job_queue_steal(&shared->queues[(self + i) % thread_count], job)) return true;
+    }
+    return false;
+}
+
+static void job_run(JobShared *shared, Job job) {
+    PROFILE_BEGIN(PROFILE_ZONE_JOB);
+    job.fn(job.ctx, job.begin, job.end);
+    PROFILE_END(PROFILE_ZONE_JOB);
+
+    job_mutex_lock(&shared->lock);
+    if (--shared->pending == 0) job_cond_broadcast(&shared->done);
+    job_mutex_unlock(&shared->lock);
+}
+
+// Workers -----------------------------------------------------------------------------------------
+
+static void job_worker_loop(JobShared *shared, int index) {
+    char name[32];
+    snprintf(name, sizeof(name), "worker %d", index);
+    profile_thread_name(name);
+
+    for (;;) {
+        job_mutex_lock(&shared->lock);
+        const uint64_t seen = shared->generation;
+        const bool quit = shared->quit;
+        job_mutex_unlock(&shared->lock);
+        if (quit) return;
+
+        Job job;
+        while (job_take(shared, index, &job)) job_run(shared, job);
+
+        job_mutex_lock(&shared->lock);
+        while (!shared->quit && shared->generation == seen) job_cond_wait(&shared->wake, &shared->lock);
+        job_mutex_unlock(&shared->lock);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI job_worker_main(LPVOID arg) {
+    const JobWorkerArgs *args = arg;
+    job_worker_loop(args->shared, args->index);
+    return 0;
+}
+#else
+static void *job_worker_main(void *arg) {
+    const JobWorkerArgs *args = arg;
+    job_worker_loop(args->shared, args->index);
+    return NULL;
+}
+#endif
+
+// System ------------------------------------------------------------------------------------------
+
+void job_system_init(JobSystem *jobs, int thread_count) {
+    memset(jobs, 0, sizeof(*jobs));
+    jobs->thread_count = thread_count < 1 ? 1 : thread_count;
+    if (jobs->thread_count == 1) return;
+
+    JobShared *shared = calloc(1, sizeof(JobShared));
+    assert(shared != NULL && "Buy more RAM lol");
+    shared->jobs = jobs;
+    shared->queues = calloc(jobs->thread_count, sizeof(JobQueue));
+    shared->threads = calloc(jobs->thread_count, sizeof(JobThread));
+    shared->args = calloc(jobs->thread_count, sizeof(JobWorkerArgs));
+    assert(shared->queues != NULL && shared->threads != NULL && shared->args != NULL && "Buy more RAM lol");
+    jobs->shared = shared;
+
+    job_mutex_init(&shared->lock);
+    job_cond_init(&shared->wake);
+    job_cond_init(&shared->done);
+    for (int i = 0; i < jobs->thread_count; i++) job_mutex_init(&shared->queues[i].lock);
+
+    // Queue 0 belongs to whoever calls job_parallel_for(), the workers get the rest.
+    for (int i = 1; i < jobs->thread_count; i++) {
+        shared->args[i] = (JobWorkerArgs) { .shared = shared, .index = i };
+#ifdef _WIN32
+        shared->threads[i] = CreateThread(NULL, 0, job_worker_main, &shared->args[i], 0, NULL);
+        const bool started = shared->threads[i] != NULL;
+#else
+        const bool started = pthread_create(&shared->threads[i], NULL, job_worker_main, &shared->args[i]) == 0;
+#endif
+        if (!started) {
+            // Make do with the ones we got.
+            jobs->thread_count = i;
+            break;
+        }
+    }
+}
+
+void job_system_free(JobSystem *jobs) {
+    JobShared *shared = jobs->shared;
+    if (shared != NULL) {
+        job_mutex_lock(&shared->lock);
+        shared->quit = true;
+        job_cond_broadcast(&shared->wake);
+        job_mutex_unlock(&shared->lock);
+
+        for (int i = 1; i < jobs->thread_count; i++) {
+#ifdef _WIN32
+            WaitForSingleObject(shared->threads[i], INFINITE);
+            CloseHandle(shared->threads[i]);
+#else
+            pthread_join(shared->threads[i], NULL);
+#endif
+        }
+
+        for (int i = 0; i < jobs->thread_count; i++) job_mutex_destroy(&shared->queues[i].lock);
+        job_cond_destroy(&shared->done);
+        job_cond_destroy(&shared->wake);
+        job_mutex_destroy(&shared->lock);
+        free(shared->queues);
+        free(shared->threads);
+        free(shared->args);
+        free(shared);
+    }
+    memset(jobs, 0, sizeof(*jobs));
+}
+
+void job_parallel_for(JobSystem *jobs, size_t count, size_t grain, JobFn fn, void *ctx) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    if (jobs == NULL || jobs->shared == NULL || count <= grain) {
+        PROFILE_BEGIN(PROFILE_ZONE_JOB);
+        fn(ctx, 0, count);
+        PROFILE_END(PROFILE_ZONE_JOB);
+        return;
+    }
+
+    JobShared *shared = jobs->shared;
+    if ((count + grain - 1) / grain > JOB_QUEUE_CAPACITY) grain = (count + JOB_QUEUE_CAPACITY - 1) / JOB_QUEUE_CAPACITY;
+    const size_t job_count = (count + grain - 1) / grain;
+
+    job_mutex_lock(&shared->lock);
+    assert(shared->pending == 0 && "job_parallel_for() is not reentrant");
+    shared->pending = job_count;
+    job_mutex_unlock(&shared->lock);
+
+    // Deal the jobs out like cards, everyone starts with a fair share before any stealing.
+    for (size_t j = 0; j < job_count; j++) {
+        const size_t begin = j * grain;
+        const size_t end = begin + grain < count ? begin + grain : count;
+        job_queue_push(&shared->queues[j % jobs->thread_count], (Job) { fn, ctx, begin, end });
+    }
+
+    job_mutex_lock(&shared->lock);
+    shared->generation++;
+    job_cond_broadcast(&shared->wake);
+    job_mutex_unlock(&shared->lock);
+
+    // Pitch in until there's nothing left to take, then wait for the jobs still running elsewhere.
+    Job job;
+    while (job_take(shared, 0, &job)) job_run(shared, job);
+
+    job_mutex_lock(&shared->lock);
+    while (shared->pending > 0) job_cond_wait(&shared->done, &shared->lock);
+    job_mutex_unlock(&shared->lock);
+}
+
+// Tasks -------------------------------------------------------------------------------------------
+
+struct JobTask {
+    void (*fn)(void *ctx);
+    void *ctx;
+    JobThread thread;
+    // Whether `thread` needs joining, it doesn't when the task ran on the caller.
+    bool started;
+    JobMutex lock;
+    bool done;
+};
+
+static void job_task_run(JobTask *task) {
+    task->fn(task->ctx);
+
+    job_mutex_lock(&task->lock);
+    task->done = true;
+    job_mutex_unlock(&task->lock);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI job_task_main(LPVOID arg) {
+    job_task_run(arg);
+    return 0;
+}
+#else
+static void *job_task_main(void *arg) {
+    job_task_run(arg);
+    return NULL;
+}
+#endif
+
+JobTask *job_task_start(void (*fn)(void *ctx), void *ctx) {
+    JobTask *task = calloc(1, sizeof(JobTask));
+    assert(task != NULL && "Buy more RAM lol");
+    task->fn = fn;
+    task->ctx = ctx;
+    job_mutex_init(&task->lock);
+
+#ifdef _WIN32
+    task->thread = CreateThread(NULL, 0, job_task_main, task, 0, NULL);
+    task->started = task->thread != NULL;
+#else
+    task->started = pthread_create(&task->thread, NULL, job_task_main, task) == 0;
+#endif
+    if (!task->started) job_task_run(task);
+    return task;
+}
+
+bool job_task_done(JobTask *task) {
+    job_mutex_lock(&task->lock);
+    const bool done = task->done;
+    job_mutex_unlock(&task->lock);
+    return done;
+}
+
+void job_task_wait(JobTask *task) {
+    if (task == NULL) return;
+
+    if (task->started) {
+#ifdef _WIN32
+        WaitForSingleObject(task->thread, INFINITE);
+        CloseHandle(task->thread);
+#else
+        pthread_join(task->thread, NULL);
+#endif
+    }
+    job_mutex_destroy(&task->lock);
+    free(task);
+}
@@ -0,0 +1,49 @@
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// A pool of worker threads that run parallel for loops. Every thread, the caller included, owns a
+// queue of jobs. A loop gets cut into jobs that are dealt out to all of the queues, each thread
+// works off the back of its own and when that runs dry steals from the front of somebody else's,
+// so a thread stuck on a slow chunk doesn't hold the rest up.
+//
+// Which thread runs which job is up to the scheduler, so for results that don't depend on the
+// thread count a job may only write to the items of its own range. Anything that has to happen in
+// order (drawing random numbers, pushing to a shared list) belongs in a serial pass after the loop.
+
+typedef void (*JobFn)(void *ctx, size_t begin, size_t end);
+
+typedef struct JobSystem {
+    // Including the thread that calls job_parallel_for().
+    int thread_count;
+    // Everything else is platform specific and lives in jobs.c.
+    struct JobShared *shared;
+} JobSystem;
+
+// One thread per CPU core the OS reports.
+int jobs_cpu_count(void);
+
+// `thread_count` includes the caller, 1 runs every loop right on the calling thread. The workers
+// point back at `jobs`, so it must not move after this.
+void job_system_init(JobSystem *jobs, int thread_count);
+void job_system_free(JobSystem *jobs);
+
+// Calls `fn` on pieces of [0, count) of at least `grain` items, spread over every thread, and
+// returns once all of them are done. `jobs` may be NULL to run it all on the caller. Not reentrant,
+// `fn` must not start another loop.
+void job_parallel_for(JobSystem *jobs, size_t count, size_t grain, JobFn fn, void *ctx);
+
+// A thread of its own for a single long running task next to the pool, like writing a save, that
+// the caller checks back on later.
+typedef struct JobTask JobTask;
+
+// Runs `fn` on the caller right away if no thread can be started, the task is done by the time
+// this returns then.
+JobTask *job_task_start(void (*fn)(void *ctx), void *ctx);
+bool job_task_done(JobTask *task);
+// Waits for the task to finish and frees it. Fine to call with NULL.
+void job_task_wait(JobTask *task);
+
+#endif // JOBS_H_
@@ -5,575 +5,657 @@
 #include <string.h>
 #include <complex.h>
 #include <math.h>
-#include <expat.h>
 #include <raylib.h>
 #include <raymath.h>
 
 #define NOB_IMPLEMENTATION
 #include "nob.h"
 #include "guppy.h"
+#include "sim.h"
+#include "mapblob.h"
+#include "sprites.h"
+#include "tilechunks.h"
+#include "camera.h"
+#include "save.h"
+#include "replay.h"
+#include "farmbot.h"
+#include "profiler.h"
 
 #define FONT_SIZE_DEBUG 20
 #define FONT_SIZE 64
 
-#define MAP_SCALE 3.0f
-#define MAP_CELL_SIZE 16.0f
-#define MAP_COLS 30
-#define MAP_ROWS 24 
-#define MAP_WIDTH (float)MAP_COLS * MAP_CELL_SIZE * MAP_SCALE
-#define MAP_HEIGHT (float)MAP_ROWS * MAP_CELL_SIZE * MAP_SCALE
-
 #define COLOR_BACKGROUND WHITE
-#define WINDOW_INIT_WIDTH MAP_WIDTH
-#define WINDOW_INIT_HEIGHT MAP_HEIGHT
+// How many cells fit on screen. The camera follows the player, so this has nothing to do with the
+// size of the map anymore.
+#define WINDOW_INIT_COLS 20
+#define WINDOW_INIT_ROWS 15
+#define WINDOW_INIT_WIDTH (float)WINDOW_INIT_COLS * MAP_CELL_SIZE * MAP_SCALE
+#define WINDOW_INIT_HEIGHT (float)WINDOW_INIT_ROWS * MAP_CELL_SIZE * MAP_SCALE
 
 
 #define PLANTS_SPRITE_SCALE 3.0f
 // The "stride" is how wide a sprite is on the sprite sheet
 #define PLANTS_SPRITE_SHEET_STRIDE 16.0f
 
-#define CHICKEN_SPRITE_SHEET_STRIDE 16.0f
-#define CHICKEN_WALKING_SPEED 50.0f
-
 #define PLAYER_SPRITE_SCALE 3.0f
-#define PLAYER_WIDTH 64.0f
-#define PLAYER_HEIGHT 64.0f
-// The "stride" is how wide a sprite is on the sprite sheet
-#define PLAYER_SPRITE_SHEET_STRIDE 48.0f
-#define PLAYER_SPRITE_SHEET_DOWN_ROW 0
-#define PLAYER_SPRITE_SHEET_UP_ROW 1
-#define PLAYER_SPRITE_SHEET_LEFT_ROW 2
-#define PLAYER_SPRITE_SHEET_RIGHT_ROW 3
-#define PLAYER_WALKING_SPEED 300.0f
-#define PLAYER_RUNNING_SPEED 500.0f
-#define PLAYER_WALKING_SPEED_ANIM_MILLIS 250
-#define PLAYER_RUNNING_SPEED_ANIM_MILLIS 100
-
-#define TOOL_ANIM_SPRITE_SHEET_STRIDE 16.0f
+
+// Soil drier than this isn't tinted at all, soaked soil gets the max alpha.
+#define SOIL_TINT_MIN_MOISTURE 0.02f
+#define SOIL_TINT_MAX_ALPHA 48.0f
 
 #define WHEAT_FLOAT_SPEED 50.0f
 #define WHEAT_FADE_SPEED 100.0f
 
-#define INVENTORY_CAPACITY 5
-
 #define ITEM_SPRITE_SCALE 100.0f
 // The "stride" is how wide a sprite is on the sprite sheet
 #define ITEM_SPRITE_SHEET_STRIDE 16.0f
-#define ITEM_ID_SEEDS 0
-#define ITEM_ID_WATERING_CAN 1
-#define ITEM_ID_SCYTHE 2
-
-// XML ---------------------------------------------------------------------------------------------
 
-void xml_start(void *data, const char *el, const char **attr) {
-    Rectangle *collision = (Rectangle *)data;
-    
-    // TODO: Really, this only does the first one.
-    if (strcmp(el, "object") == 0) {
-        attr += 2;
-        collision->x = (float)atof(attr[1]) * MAP_SCALE;
+// Frame graph of the debug overlay, one bar per frame of the profiler's history. The budget line
+// sits at PROFILE_GRAPH_HEIGHT / 2, so it's clear by how much frames go over.
+#define PROFILE_GRAPH_BAR_WIDTH 2
+#define PROFILE_GRAPH_HEIGHT 80
+
+// Where F2 writes a trace when --trace doesn't say, and how many frames it gets.
+#define TRACE_PATH "trace.json"
+#define TRACE_DEFAULT_FRAMES 600
+
+// Most farmable cells and collision rects the debug overlay draws in one frame.
+#define DEBUG_QUERY_CAP 4096
+
+#define HEADLESS_DEFAULT_TICKS (SIM_TICKS_PER_SECOND * 60)
+// Simulated time between autosaves, see save.h.
+#define AUTOSAVE_TICKS (SIM_TICKS_PER_SECOND * 60)
+
+typedef struct Options {
+    bool headless;
+    long headless_ticks;
+    int extra_animals;
+    int threads;
+    // Where the farm is loaded from and saved to, NULL to not save at all.
+    const char *save_path;
+    // Let the farm bot play instead of the keyboard (or nobody, headless).
+    bool bot;
+    // Replay to write every tick of input into, and replay to play back headless instead of
+    // `headless_ticks`, see replay.h. NULL for none.
+    const char *record_path;
+    const char *replay_path;
+    // Trace the first `trace_frames` frames to it, see profiler.h. NULL to only trace on F2.
+    const char *trace_path;
+    int trace_frames;
+} Options;
 
-        attr += 2;
-        collision->y = (float)atof(attr[1]) * MAP_SCALE;
+// CSS-like helpers --------------------------------------------------------------------------------
 
-        attr += 2;
-        collision->width = (float)atof(attr[1]) * MAP_SCALE;
+float vh(float vh) {
+    return GetRenderHeight() * vh * 0.01;
+}
 
-        attr += 2;
-        collision->height = (float)atof(attr[1]) * MAP_SCALE;
-    }
+float vw(float vw) {
+    return GetRenderWidth() * vw * 0.01;
 }
 
-void xml_end(void *data, const char *el) {
-    // noop
+void print_cell(const Cell cell) {
+    TraceLog(LOG_DEBUG, TextFormat("cell: (%d, %d)", cell.x, cell.y));
 }
 
-void parse_collision(Rectangle *collision) {
-    XML_Parser parser = XML_ParserCreate(NULL);
-    XML_SetElementHandler(parser, xml_start, xml_end);
-    XML_SetUserData(parser, collision);
+// Map ---------------------------------------------------------------------------------------------
+
+// Prefer the blob baked by `./nob map`, it gets mapped and used as is. Parsing the TMX is only the
+// fallback for when nobody baked it.
+bool load_map(TmxMap *map, MapBlob *blob) {
+    const double started_at = sim_monotonic_seconds();
 
-    char *xml = gup_file_read_as_cstr("resources/tilesets/map2.tmx");
+    bool ok = map_blob_open(MAP_BLOB_PATH, blob, map);
+    if (!ok) {
+        TraceLog(LOG_WARNING, "Could not open " MAP_BLOB_PATH ", parsing " MAP_PATH " instead. Run `./nob map` to bake it.");
+        ok = tmx_load(MAP_PATH, map);
+    }
 
-    int done = 1;
-    if (XML_Parse(parser, xml, strlen(xml), done) == XML_STATUS_ERROR) {
-        printf("Error: %s\n", XML_ErrorString(XML_GetErrorCode(parser)));
+    if (ok) {
+        TraceLog(LOG_INFO, TextFormat("map: %dx%d, %zu layers, %zu objects, %zu tilesets, loaded in %.3fms",
+            map->width, map->height, map->layers.count, map->objects.count, map->tilesets.count,
+            (sim_monotonic_seconds() - started_at) * 1000.0));
     }
 
-    XML_ParserFree(parser);
-    free(xml);
+    return ok;
 }
 
+// Input -------------------------------------------------------------------------------------------
 
-// CSS-like helpers --------------------------------------------------------------------------------
+Input poll_input(void) {
+    Input input = { 0 };
 
-float vh(float vh) {
-    return GetRenderHeight() * vh * 0.01;
-}
+    if (IsKeyDown(KEY_LEFT))       input.down |= INPUT_LEFT;
+    if (IsKeyDown(KEY_RIGHT))      input.down |= INPUT_RIGHT;
+    if (IsKeyDown(KEY_UP))         input.down |= INPUT_UP;
+    if (IsKeyDown(KEY_DOWN))       input.down |= INPUT_DOWN;
+    if (IsKeyDown(KEY_LEFT_SHIFT)) input.down |= INPUT_RUN;
 
-float vw(float vw) {
-    return GetRenderWidth() * vw * 0.01;
-}
+    if (IsKeyPressed(KEY_SPACE)) input.pressed |= INPUT_USE;
+    if (IsKeyPressed(KEY_F1))    input.pressed |= INPUT_TOGGLE_DEBUG;
+    if (IsKeyPressed(KEY_TAB))   input.pressed |= INPUT_TOGGLE_PAUSE;
+    if (IsKeyPressed(KEY_ONE))   input.pressed |= INPUT_SLOT_1;
+    if (IsKeyPressed(KEY_TWO))   input.pressed |= INPUT_SLOT_2;
+    if (IsKeyPressed(KEY_THREE)) input.pressed |= INPUT_SLOT_3;
+    if (IsKeyPressed(KEY_FOUR))  input.pressed |= INPUT_SLOT_4;
+    if (IsKeyPressed(KEY_FIVE))  input.pressed |= INPUT_SLOT_5;
 
-typedef struct GameState {
-    bool debug_mode;
-    bool paused;
-} GameState;
-
-typedef struct Cell {
-    int x; // col
-    int y; // row
-    double plantedAt;
-    double wettedAt;
-} Cell;
-
-typedef struct Item {
-    int id;
-    char name[256];
-    Vector2 sprite_sheet_pos;
-} Item;
-
-typedef struct Inventory {
-    Item items[INVENTORY_CAPACITY];
-    int selected_idx;
-    Rectangle rect;
-} Inventory;
-
-typedef enum {
-    UP = 0,
-    DOWN,
-    LEFT,
-    RIGHT
-} Direction;
-
-typedef struct Character {
-    Rectangle rect;
-    Direction dir;
-    double wheat_harvested_at;
-    double swung_scythe_at;
-} Character;
-
-Vector2 get_character_pos(Character player) {
-    return (Vector2) {
-        player.rect.x + (player.rect.width / 2),
-        // The feet are closer to the bottom of the sprite than the middle. So only chop off a
-        // quarter of the sprite, not half like a first impression may elicit.
-        player.rect.y + player.rect.height - (player.rect.height / 4),
-    };
+    return input;
 }
 
-Rectangle get_character_cell_rect(Character player) {
-    return (Rectangle) {
-        get_character_pos(player).x - (float)((int)get_character_pos(player).x % (int)(MAP_CELL_SIZE * MAP_SCALE)),
-        get_character_pos(player).y - (float)((int)get_character_pos(player).y % (int)(MAP_CELL_SIZE * MAP_SCALE)),
-        MAP_CELL_SIZE * MAP_SCALE,
-        MAP_CELL_SIZE * MAP_SCALE,
-    };
+// Animals -----------------------------------------------------------------------------------------
+
+// Half chickens, half cows, for seeing how the simulation copes with a crowded farm.
+void spawn_extra_animals(World *world, int count) {
+    if (count <= 0) return;
+
+    const int chickens = world_spawn_animals(world, ANIMAL_CHICKEN, count - count / 2);
+    const int cows = world_spawn_animals(world, ANIMAL_COW, count / 2);
+    TraceLog(LOG_INFO, TextFormat("animals: spawned %d chickens and %d cows, %zu animals total",
+        chickens, cows, world->animals.entities.alive));
 }
 
-Rectangle get_cell_rect_character_is_facing(Character player) {
-    Rectangle result = get_character_cell_rect(player);
-    
-    switch (player.dir) {
-        case UP: {
-            result.y -= (MAP_CELL_SIZE * MAP_SCALE);      
-            break;
-        }
-        case DOWN: {
-            result.y += (MAP_CELL_SIZE * MAP_SCALE);  
-            break;
-        }
-        case LEFT: {
-            result.x -= (MAP_CELL_SIZE * MAP_SCALE);  
-            break;
-        }
-        case RIGHT: {
-            result.x += (MAP_CELL_SIZE * MAP_SCALE);  
-            break;
-        }
+// Saves -------------------------------------------------------------------------------------------
+
+// Picks up where the save left off, if there is one. A save that's there but won't load stops the
+// game instead of letting the next autosave write over it. The terrain past the edge of the map
+// keeps its changed pages in a directory next to the save.
+bool load_save(SaveWriter *saver, World *world) {
+    if (!pages_set_dir(&world->pages, TextFormat("%s.pages", saver->path))) return false;
+
+    if (!nob_file_exists(saver->path)) {
+        TraceLog(LOG_INFO, TextFormat("save: no %s yet, starting a new farm", saver->path));
+        return true;
     }
+    if (!save_load(saver, world)) return false;
 
-    return result;
+    TraceLog(LOG_INFO, TextFormat("save: loaded %s at tick %llu", saver->path, (unsigned long long)world->tick));
+    return true;
 }
 
-void print_cell(const Cell cell) {
-    TraceLog(LOG_DEBUG, TextFormat("cell: (%d, %d)", cell.x, cell.y));
+void log_save_stats(const SaveWriter *saver, SaveStats stats) {
+    if (!stats.ok) {
+        TraceLog(LOG_ERROR, TextFormat("save: could not write %s", saver->path));
+        return;
+    }
+    TraceLog(LOG_INFO, TextFormat("save: %s snapshot of %d/%d chunks, %zu bytes, %.2fms snapshot, %.2fms write",
+        stats.full ? "full" : "incremental", stats.chunks_written, stats.chunk_count, stats.bytes,
+        stats.snapshot_seconds * 1000.0, stats.write_seconds * 1000.0));
 }
 
-Cell get_cell_player_is_facing(Character player) {
-    const Rectangle facing_cell_rect = get_cell_rect_character_is_facing(player);
-    const Cell result = {
-        (int)facing_cell_rect.x / (int)(MAP_CELL_SIZE * MAP_SCALE),
-        (int)facing_cell_rect.y / (int)(MAP_CELL_SIZE * MAP_SCALE)
-    };
-    return result;
+// The game only waits for the snapshot, the rest is written in the background. Autosaves that come
+// up while the last one is still being written get skipped, whatever they would have saved stays
+// dirty for the next one.
+void autosave(SaveWriter *saver, World *world) {
+    SaveStats stats;
+    if (save_poll(saver, &stats)) log_save_stats(saver, stats);
+    if (!save_write_async(saver, world)) TraceLog(LOG_WARNING, "save: last autosave is still being written, skipping");
 }
 
-int get_cell_id_player_is_facing(Character player) {
-    const Cell facing_cell = get_cell_player_is_facing(player);
-    return facing_cell.x + (facing_cell.y * MAP_COLS);
+// For quitting, everything has to be on disk before we're gone.
+void final_save(SaveWriter *saver, World *world) {
+    SaveStats stats;
+    if (save_wait(saver, &stats)) log_save_stats(saver, stats);
+    save_write(saver, world, &stats);
+    log_save_stats(saver, stats);
+    if (!pages_flush(&world->pages)) TraceLog(LOG_ERROR, TextFormat("save: could not write the pages of %s", saver->path));
 }
 
-bool is_cell_in_area(Cell needle, Cell haystack, int cols, int rows) {
-    if (cols == 0 || rows == 0) return false;
-    if (needle.x < haystack.x || needle.y < haystack.y) return false;
-    if (needle.x >= haystack.x + cols) return false;
-    if (needle.y >= haystack.y + rows) return false;
-    
+// Replays -----------------------------------------------------------------------------------------
+
+// Replays start from a new farm, so these don't go together with loading one.
+bool check_replay_options(const Options *options) {
+    if ((options->record_path != NULL || options->replay_path != NULL) && options->save_path != NULL) {
+        TraceLog(LOG_ERROR, "--record and --replay always start a new farm, they don't go with --save");
+        return false;
+    }
+    if (options->record_path != NULL && options->replay_path != NULL) {
+        TraceLog(LOG_ERROR, "--record and --replay don't go together, copy the file instead");
+        return false;
+    }
     return true;
 }
 
-static Cell cells[MAP_COLS * MAP_ROWS];
-
-Cell cell_id_to_cell(const int cell_id) {
-    // TODO: cells has to be moved to static and it's real bad
-    return cells[cell_id];
+void finish_recording(Replay *replay, const char *path, const World *world) {
+    replay->hash = world_hash(world);
+    if (replay_save(replay, path)) {
+        TraceLog(LOG_INFO, TextFormat("replay: recorded %llu ticks in %zu runs to %s, hash %016llx",
+            (unsigned long long)replay->ticks, replay->runs.count, path, (unsigned long long)replay->hash));
+    }
 }
 
-int cell_to_cell_id(const Cell cell) {
-    return cell.x + (cell.y * MAP_COLS);
+void log_farm_bot(const FarmBot *bot) {
+    TraceLog(LOG_INFO, TextFormat("bot: %d rounds, planted %d, harvested %d, gave up on %d",
+        bot->rounds, bot->planted, bot->harvested, bot->skipped));
 }
 
-bool player_is_facing_farmable_cell(Character player) {
-    const int cell_id = get_cell_id_player_is_facing(player);
-
-    // TODO: hardcoding these for now. Ideally we could somehow parse this from the tilemap,
-    // or do literally anything smarter than this.
-    return (
-        cell_id == 280 || cell_id == 281 || cell_id == 282 || cell_id == 283 ||
-        cell_id == 310 || cell_id == 311 || cell_id == 312 || cell_id == 313 ||
-        cell_id == 340 || cell_id == 341 || cell_id == 342 || cell_id == 343 ||
-        cell_id == 370 || cell_id == 371 || cell_id == 372 || cell_id == 373 ||
-
-        cell_id == 286 || cell_id == 287 || cell_id == 288 || cell_id == 289 ||
-        cell_id == 316 || cell_id == 317 || cell_id == 318 || cell_id == 319 ||
-        cell_id == 346 || cell_id == 347 || cell_id == 348 || cell_id == 349 ||
-        cell_id == 376 || cell_id == 377 || cell_id == 378 || cell_id == 379 ||
-
-        cell_id == 460 || cell_id == 461 || cell_id == 462 || cell_id == 463 ||
-        cell_id == 490 || cell_id == 491 || cell_id == 492 || cell_id == 493 ||
-        cell_id == 520 || cell_id == 521 || cell_id == 522 || cell_id == 523 ||
-        cell_id == 550 || cell_id == 551 || cell_id == 552 || cell_id == 553 ||
-
-        cell_id == 466 || cell_id == 467 || cell_id == 468 || cell_id == 469 ||
-        cell_id == 496 || cell_id == 497 || cell_id == 498 || cell_id == 499 ||
-        cell_id == 526 || cell_id == 527 || cell_id == 528 || cell_id == 529 ||
-        cell_id == 556 || cell_id == 557 || cell_id == 558 || cell_id == 559
-    );
+// Profiler ----------------------------------------------------------------------------------------
+
+// p50/p99 of every zone and of the whole frame, over the frames in the profiler's history, and a
+// graph of those frames against the budget. Nothing gets sorted unless this is on screen.
+void draw_profiler_overlay(int x, int y) {
+    const ProfileStats frame = profile_frame_stats();
+    DrawText(TextFormat("Frame: p50 %.2fms, p99 %.2fms, budget %.2fms", frame.p50_ns * 1e-6, frame.p99_ns * 1e-6, PROFILE_FRAME_BUDGET_NS * 1e-6), x, y, FONT_SIZE_DEBUG, WHITE);
+    y += FONT_SIZE_DEBUG;
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+        const ProfileStats stats = profile_zone_stats(zone);
+        DrawText(TextFormat("  %s: p50 %.2fms, p99 %.2fms", profile_zone_name(zone), stats.p50_ns * 1e-6, stats.p99_ns * 1e-6), x, y, FONT_SIZE_DEBUG, WHITE);
+        y += FONT_SIZE_DEBUG;
+    }
+    if (profile_dropped() > 0) {
+        DrawText(TextFormat("  %llu zones dropped", (unsigned long long)profile_dropped()), x, y, FONT_SIZE_DEBUG, RED);
+        y += FONT_SIZE_DEBUG;
+    }
+    y += 4;
+
+    static uint64_t times[PROFILE_HISTORY_FRAMES];
+    profile_frame_times(times);
+    const int width = PROFILE_HISTORY_FRAMES * PROFILE_GRAPH_BAR_WIDTH;
+    DrawRectangle(x, y, width, PROFILE_GRAPH_HEIGHT, (Color) { 0, 0, 0, 128 });
+    const int bottom = y + PROFILE_GRAPH_HEIGHT;
+    for (int i = 0; i < PROFILE_HISTORY_FRAMES; i++) {
+        if (times[i] == 0) continue;
+        const double budgets = (double)times[i] / PROFILE_FRAME_BUDGET_NS;
+        int height = (int)(budgets * PROFILE_GRAPH_HEIGHT / 2);
+        if (height > PROFILE_GRAPH_HEIGHT) height = PROFILE_GRAPH_HEIGHT;
+        if (height < 1) height = 1;
+        DrawRectangle(x + i * PROFILE_GRAPH_BAR_WIDTH, bottom - height, PROFILE_GRAPH_BAR_WIDTH, height, budgets > 1.0 ? RED : GREEN);
+    }
+    DrawLine(x, bottom - PROFILE_GRAPH_HEIGHT / 2, x + width, bottom - PROFILE_GRAPH_HEIGHT / 2, YELLOW);
 }
 
-bool is_cell_full_grown(Cell cell) {
-    return GetTime() - cell.plantedAt > 3.0;
+bool check_trace_options(const Options *options) {
+    if (options->trace_path != NULL && options->headless) {
+        TraceLog(LOG_ERROR, "--trace records frames, headless runs don't have any");
+        return false;
+    }
+    return true;
 }
 
-int main(void) {
-    // SetConfigFlags(FLAG_WINDOW_RESIZABLE);
-    InitWindow(WINDOW_INIT_WIDTH, WINDOW_INIT_HEIGHT, "YAFS");
-    SetTargetFPS(144);
-    SetExitKey(KEY_ESCAPE);
-    InitAudioDevice();
-    SetTraceLogLevel(LOG_DEBUG);
-
-    GameState game_state;
-
-    Character chicken;
-    Character player;
-    Texture2D player_sprite_sheet;
-    int player_sprite_sheet_row, player_sprite_sheet_col;
-    
-    Inventory inventory;
-    Texture2D item_sprite_sheet;
-
-    Texture2D map;
-    Rectangle collision;
+void start_trace(const char *path, int frames) {
+    if (profile_trace_begin(path, frames)) {
+        TraceLog(LOG_INFO, TextFormat("trace: tracing %d frames to %s", frames, path));
+    } else {
+        TraceLog(LOG_ERROR, TextFormat("trace: could not start tracing to %s", path));
+    }
+}
 
-    Texture2D plants_sprite_sheet;
-    Texture2D chicken_sprite_sheet;
-    Texture2D tool_anim_sprite_sheet;
+void finish_trace(const char *path) {
+    ProfileTraceStats stats;
+    if (profile_trace_end(&stats)) {
+        TraceLog(LOG_INFO, TextFormat("trace: wrote %llu frames, %llu zones, %.1fKB to %s",
+            (unsigned long long)stats.frames, (unsigned long long)stats.events, stats.bytes / 1024.0, path));
+    } else {
+        TraceLog(LOG_ERROR, TextFormat("trace: could not write %s", path));
+    }
+}
 
-    { // Initialization
-        parse_collision(&collision);
-        TraceLog(LOG_DEBUG, TextFormat("rect: {.x = %f, .y = %f, .width = %f, .height = %f }\n", collision.x, collision.y, collision.width, collision.height));
-
-        item_sprite_sheet = LoadTexture("resources/sprout-lands-sprites/Objects/Basic_tools_and_materials.png");
-        map = LoadTexture("resources/tilesets/map2.png");
-        plants_sprite_sheet = LoadTexture("resources/sprout-lands-sprites/Objects/Basic_Plants.png");
-        player_sprite_sheet = LoadTexture("resources/sprout-lands-sprites/Characters/basic-character-spritesheet.png");
-        tool_anim_sprite_sheet = LoadTexture("resources/sprout-lands-sprites/Characters/Tools.png");
-        chicken_sprite_sheet = LoadTexture("resources/sprout-lands-sprites/Characters/free-chicken-sprites.png");
-
-        player_sprite_sheet_row = 0;
-        player_sprite_sheet_col = 0;
-
-        game_state = (GameState) {
-            .debug_mode = false,
-            .paused = false,
-        };
+// Headless ----------------------------------------------------------------------------------------
+
+// Step the world as fast as the CPU allows, no window, no audio. Used for soak tests and for
+// measuring how many ticks per second the simulation can sustain. With a replay it plays that back
+// and checks it ends up where the recording did, which makes for workloads that are the same on
+// every run and every machine.
+int run_headless(const Options *options) {
+    static World world;
+    static TmxMap tmx_map;
+    static MapBlob map_blob;
+    static AnimLibrary clips;
+    static JobSystem jobs;
+    static SaveWriter saver;
+    static Replay replay;
+    static FarmBot bot;
+
+    if (!load_map(&tmx_map, &map_blob)) return 1;
+    if (!anim_library_load(&clips, ANIM_CLIPS_PATH, SIM_TICKS_PER_SECOND)) return 1;
+    job_system_init(&jobs, options->threads);
+    world_init(&world, &tmx_map, &clips, &jobs);
+    if (options->save_path != NULL) {
+        save_writer_init(&saver, options->save_path);
+        if (!load_save(&saver, &world)) return 1;
+    }
 
-        for (int i = 0; i < MAP_COLS * MAP_ROWS; i++) {
-            cells[i] = (Cell) {
-                .x = (i % MAP_COLS) * MAP_CELL_SIZE * MAP_SCALE,
-                .y = (i / MAP_COLS) * MAP_CELL_SIZE * MAP_SCALE,
-                .plantedAt = 0,
-                .wettedAt = 0,
-            };
+    long ticks = options->headless_ticks;
+    int extra_animals = options->extra_animals;
+    if (options->replay_path != NULL) {
+        if (!replay_load(&replay, options->replay_path)) return 1;
+        if (replay.cols != world.cols || replay.rows != world.rows) {
+            TraceLog(LOG_ERROR, TextFormat("replay: %s is of a %dx%d map, this one is %dx%d",
+                options->replay_path, replay.cols, replay.rows, world.cols, world.rows));
+            return 1;
+        }
+        ticks = (long)replay.ticks;
+        extra_animals = replay.extra_animals;
+    }
+    spawn_extra_animals(&world, extra_animals);
+    if (options->record_path != NULL) replay_begin(&replay, &world, extra_animals);
+    if (options->bot) farm_bot_init(&bot, &world);
+
+    ReplayCursor cursor = { 0 };
+    uint64_t saved_at = world.tick;
+
+    const double started_at = sim_monotonic_seconds();
+    for (long i = 0; i < ticks; i++) {
+        Input input = { 0 };
+        if (options->replay_path != NULL) {
+            replay_next(&replay, &cursor, &input);
+        } else if (options->bot) {
+            input = farm_bot_input(&bot, &world);
         }
+        if (options->record_path != NULL) replay_record(&replay, input);
 
-        player = (Character) {
-            .rect = (Rectangle) {
-                .x = vw(50),
-                .y = vh(50),
-                .width = PLAYER_WIDTH,
-                .height = PLAYER_HEIGHT,
-            },
-            .wheat_harvested_at = 0,
-        };
+        world_update(&world, input);
+        if (options->save_path != NULL && world.tick - saved_at >= AUTOSAVE_TICKS) {
+            autosave(&saver, &world);
+            saved_at = world.tick;
+        }
+    }
+    const double elapsed = sim_monotonic_seconds() - started_at;
+
+    TraceLog(LOG_INFO, TextFormat("headless: %ld ticks in %.3fs on %d threads (%.0f ticks/sec, %.1fx realtime)",
+        ticks, elapsed, jobs.thread_count, ticks / elapsed, (ticks * SIM_DT) / elapsed));
+
+    int result = 0;
+    if (options->bot) log_farm_bot(&bot);
+    if (options->record_path != NULL) finish_recording(&replay, options->record_path, &world);
+    if (options->replay_path != NULL) {
+        const uint64_t hash = world_hash(&world);
+        if (hash == replay.hash) {
+            TraceLog(LOG_INFO, TextFormat("replay: %s ended in the recorded state, hash %016llx", options->replay_path, (unsigned long long)hash));
+        } else {
+            TraceLog(LOG_ERROR, TextFormat("replay: %s ended in another state than recorded, hash %016llx instead of %016llx",
+                options->replay_path, (unsigned long long)hash, (unsigned long long)replay.hash));
+            result = 1;
+        }
+    }
 
-        chicken = (Character) {
-            .rect = (Rectangle) {
-                .x = vw(25),
-                .y = vh(25),
-                .width = PLAYER_WIDTH,
-                .height = PLAYER_HEIGHT,
-            }
-        };
+    if (options->save_path != NULL) {
+        final_save(&saver, &world);
+        save_writer_free(&saver);
+    }
+    if (options->bot) farm_bot_free(&bot);
+    replay_free(&replay);
+    job_system_free(&jobs);
+    return result;
+}
 
-        Item seeds = { 
-            .id = ITEM_ID_SEEDS,
-            .name = "Seeds",
-            .sprite_sheet_pos = (Vector2) { 0.0f, 0.0f },
-        };
-        Item watering_can = { 
-            .id = ITEM_ID_WATERING_CAN,
-            .name = "Watering Can",
-            .sprite_sheet_pos = (Vector2) { 0.0f, 0.0f },
-        };
-        Item scythe = { 
-            .id = ITEM_ID_SCYTHE,
-            .name = "Scythe",
-            .sprite_sheet_pos = (Vector2) { 32.0f, 0.0f },
-        };
+void log_usage(const char *program) {
+    TraceLog(LOG_INFO, TextFormat("Usage: %s [--headless] [--ticks N] [--animals N] [--threads N] [--save PATH] [--bot] [--record PATH] [--replay PATH] [--trace PATH] [--trace-frames N]", program));
+    TraceLog(LOG_INFO, "    --headless    run the simulation without a window");
+    TraceLog(LOG_INFO, TextFormat("    --ticks N     how many ticks to run headless (default %d)", HEADLESS_DEFAULT_TICKS));
+    TraceLog(LOG_INFO, "    --animals N   spawn N more animals on top of the ones the map starts with");
+    TraceLog(LOG_INFO, "    --threads N   how many threads run the simulation (default one per core)");
+    TraceLog(LOG_INFO, TextFormat("    --save PATH   load the farm from and autosave it to PATH (default %s, headless runs only save with this)", SAVE_PATH));
+    TraceLog(LOG_INFO, "    --bot         let a bot plant, water and harvest every farmable cell over and over");
+    TraceLog(LOG_INFO, "    --record PATH record the input of every tick to PATH, starting from a new farm");
+    TraceLog(LOG_INFO, "    --replay PATH play a recording back headless and check it ends the same way");
+    TraceLog(LOG_INFO, "    --trace PATH  write a Chrome trace of the first frames to PATH, F2 traces to it later on too");
+    TraceLog(LOG_INFO, TextFormat("    --trace-frames N how many frames a trace gets (default %d)", TRACE_DEFAULT_FRAMES));
+}
 
-        inventory = (Inventory) {
-            .items = { seeds, watering_can, scythe },
-            .selected_idx = 0,
-            .rect = (Rectangle) {
-                .x = vw(25.0f),
-                .y = vh(85.0f),
-                .width = vw(50.0f),
-                .height = vh(10.0f),
-            },
-        };
-    }
+int main(int argc, char **argv) {
+    const char *program = nob_shift_args(&argc, &argv);
 
-    while (!WindowShouldClose()) {
-        { // Update
-            { // Stuff that should be done regardless of pause state. 
-                if (IsKeyPressed(KEY_F1)) {
-                    game_state.debug_mode = !game_state.debug_mode;
-                }
+    Options options = {
+        .headless_ticks = HEADLESS_DEFAULT_TICKS,
+        .threads = jobs_cpu_count(),
+        .trace_frames = TRACE_DEFAULT_FRAMES,
+    };
 
-                if (IsKeyPressed(KEY_TAB)) {
-                    game_state.paused = !game_state.paused;
-                }
+    while (argc > 0) {
+        const char *flag = nob_shift_args(&argc, &argv);
+        if (strcmp(flag, "--headless") == 0) {
+            options.headless = true;
+        } else if (strcmp(flag, "--ticks") == 0) {
+            if (argc <= 0) {
+                TraceLog(LOG_ERROR, TextFormat("No value is provided for flag %s", flag));
+                return 1;
             }
+            options.headless_ticks = strtol(nob_shift_args(&argc, &argv), NULL, 10);
+            if (options.headless_ticks <= 0) {
+                TraceLog(LOG_ERROR, "--ticks expects a positive number");
+                return 1;
+            }
+        } else if (strcmp(flag, "--animals") == 0) {
+            if (argc <= 0) {
+                TraceLog(LOG_ERROR, TextFormat("No value is provided for flag %s", flag));
+                return 1;
+            }
+            options.extra_animals = (int)strtol(nob_shift_args(&argc, &argv), NULL, 10);
+            if (options.extra_animals < 0) {
+                TraceLog(LOG_ERROR, "--animals expects a number of animals");
+                return 1;
+            }
+        } else if (strcmp(flag, "--threads") == 0) {
+            if (argc <= 0) {
+                TraceLog(LOG_ERROR, TextFormat("No value is provided for flag %s", flag));
+                return 1;
+            }
+            options.threads = (int)strtol(nob_shift_args(&argc, &argv), NULL, 10);
+            if (options.threads <= 0) {
+                TraceLog(LOG_ERROR, "--threads expects a positive number");
+                return 1;
+            }
+        } else if (strcmp(flag, "--save") == 0) {
+            if (argc <= 0) {
+                TraceLog(LOG_ERROR, TextFormat("No value is provided for flag %s", flag));
+                return 1;
+            }
+            options.save_path = nob_shift_args(&argc, &argv);
+        } else if (strcmp(flag, "--bot") == 0) {
+            options.bot = true;
+        } else if (strcmp(flag, "--record") == 0) {
+            if (argc <= 0) {
+                TraceLog(LOG_ERROR, TextFormat("No value is provided for flag %s", flag));
+                return 1;
+            }
+            options.record_path = nob_shift_args(&argc, &argv);
+        } else if (strcmp(flag, "--replay") == 0) {
+            if (argc <= 0) {
+                TraceLog(LOG_ERROR, TextFormat("No value is provided for flag %s", flag));
+                return 1;
+            }
+            options.replay_path = nob_shift_args(&argc, &argv);
+            options.headless = true;
+        } else if (strcmp(flag, "--trace") == 0) {
+            if (argc <= 0) {
+                TraceLog(LOG_ERROR, TextFormat("No value is provided for flag %s", flag));
+                return 1;
+            }
+            options.trace_path = nob_shift_args(&argc, &argv);
+        } else if (strcmp(flag, "--trace-frames") == 0) {
+            if (argc <= 0) {
+                TraceLog(LOG_ERROR, TextFormat("No value is provided for flag %s", flag));
+                return 1;
+            }
+            options.trace_frames = (int)strtol(nob_shift_args(&argc, &argv), NULL, 10);
+            if (options.trace_frames <= 0) {
+                TraceLog(LOG_ERROR, "--trace-frames expects a positive number");
+                return 1;
+            }
+        } else if (strcmp(flag, "-h") == 0 || strcmp(flag, "--help") == 0) {
+            log_usage(program);
+            return 0;
+        } else {
+            TraceLog(LOG_ERROR, TextFormat("Unknown flag %s", flag));
+            log_usage(program);
+            return 1;
+        }
+    }
 
-            // The rest of the update should not happen if the game is paused.
-            // So, if we're paused at this point just jump to drawing.
-            if (game_state.paused) goto draw;
-
-            Vector2 pos_diff_normalized = { 0 };
-            { // Movement
-                Vector2 pos_diff = { 0 };
-                if (IsKeyDown(KEY_LEFT))  pos_diff.x--;
-                if (IsKeyDown(KEY_RIGHT)) pos_diff.x++;
-                if (IsKeyDown(KEY_UP))    pos_diff.y--;
-                if (IsKeyDown(KEY_DOWN))  pos_diff.y++;
+    if (!check_replay_options(&options)) return 1;
+    if (!check_trace_options(&options)) return 1;
+    if (options.headless) return run_headless(&options);
+    // Recordings start from a new farm, and that one shouldn't get saved over the real one.
+    if (options.save_path == NULL && options.record_path == NULL) options.save_path = SAVE_PATH;
 
-                pos_diff_normalized = Vector2Normalize(pos_diff);
-            }
+    // SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+    InitWindow(WINDOW_INIT_WIDTH, WINDOW_INIT_HEIGHT, "YAFS");
+    SetTargetFPS(144);
+    SetExitKey(KEY_ESCAPE);
+    InitAudioDevice();
+    SetTraceLogLevel(LOG_DEBUG);
+    // Before the job system starts its workers.
+    profile_enable();
+    profile_thread_name("main");
+    const char *trace_path = options.trace_path != NULL ? options.trace_path : TRACE_PATH;
+
+    static World world;
+    static TmxMap tmx_map;
+    static MapBlob map_blob;
+    static AnimLibrary clips;
+    static JobSystem jobs;
+    static SaveWriter saver;
+    static Replay replay;
+    static FarmBot bot;
+    uint64_t saved_at = 0;
+    FixedStep step;
+    Input input = { 0 };
+
+    static SpriteBatch sprites;
+    static TileChunks tile_chunks;
+    // There's streamed terrain all around the map, no need to stop at its edges.
+    FollowCamera camera = { .unbounded = true };
+    Rectangle inventory_rect;
 
-            const bool is_idle = Vector2Length(pos_diff_normalized) == 0.0f;
-            const bool is_running = !is_idle && IsKeyDown(KEY_LEFT_SHIFT);
-            const float speed = is_running ? PLAYER_RUNNING_SPEED : PLAYER_WALKING_SPEED;
+    { // Initialization
+        if (!load_map(&tmx_map, &map_blob)) return 1;
+        if (!anim_library_load(&clips, ANIM_CLIPS_PATH, SIM_TICKS_PER_SECOND)) return 1;
 
-            Vector2 scaled_pos_diff = Vector2Scale(pos_diff_normalized, speed * GetFrameTime());
+        if (!sprite_batch_load(&sprites)) return 1;
 
-            // Check what the new player rect would be if we were to move as much as
-            // the new position would like us to. We will then check if this is possible.
-            Rectangle hypothetical_player_rect = {
-                .x = player.rect.x + scaled_pos_diff.x,
-                .y = player.rect.y + scaled_pos_diff.y,
-                .width = player.rect.width,
-                .height = player.rect.height,
-            };
+        job_system_init(&jobs, options.threads);
+        world_init(&world, &tmx_map, &clips, &jobs);
+        if (options.save_path != NULL) {
+            save_writer_init(&saver, options.save_path);
+            if (!load_save(&saver, &world)) return 1;
+        }
+        saved_at = world.tick;
+        spawn_extra_animals(&world, options.extra_animals);
+        if (options.record_path != NULL) replay_begin(&replay, &world, options.extra_animals);
+        if (options.bot) farm_bot_init(&bot, &world);
+        if (!tile_chunks_init(&tile_chunks, &tmx_map)) return 1;
+
+        inventory_rect = (Rectangle) {
+            .x = vw(25.0f),
+            .y = vh(85.0f),
+            .width = vw(50.0f),
+            .height = vh(10.0f),
+        };
 
-            if (!CheckCollisionRecs(hypothetical_player_rect, collision)) {
-                // TODO: this probably isn't right i guess id need to cehck both axes?
-                player.rect = hypothetical_player_rect;
-            }
+        step = fixed_step_create(GetTime);
+        if (options.trace_path != NULL) start_trace(trace_path, options.trace_frames);
+    }
 
-            { // Items
-                if (IsKeyPressed(KEY_ONE)) inventory.selected_idx   = 0;
-                if (IsKeyPressed(KEY_TWO)) inventory.selected_idx   = 1;
-                if (IsKeyPressed(KEY_THREE)) inventory.selected_idx = 2;
-                if (IsKeyPressed(KEY_FOUR)) inventory.selected_idx  = 3;
-                if (IsKeyPressed(KEY_FIVE)) inventory.selected_idx  = 4;
-
-                if (IsKeyPressed(KEY_SPACE)) {
-                    switch (inventory.items[inventory.selected_idx].id) {
-                        case ITEM_ID_SEEDS: {
-                            const int id = get_cell_id_player_is_facing(player);
-                            if (!player_is_facing_farmable_cell(player)) break;
-                            if (cells[id].plantedAt > 0) break;
-
-                            cells[id].plantedAt = GetTime();
-                            break;
-                        }
-                        case ITEM_ID_WATERING_CAN: {
-                            // TODO: animation
-
-                            const int id = get_cell_id_player_is_facing(player);
-                            if (!player_is_facing_farmable_cell(player)) break;
-                            if (cells[id].wettedAt > 0) break;
-
-                            cells[id].wettedAt = GetTime();
-                            break;
-                        }
-                        case ITEM_ID_SCYTHE: {
-                            // Play animation every time.
-                            player.swung_scythe_at = GetTime();
-                            
-                            const int id = get_cell_id_player_is_facing(player);
-                            if (cells[id].plantedAt == 0) break;
-
-                            if (is_cell_full_grown(cells[id])) {
-                                player.wheat_harvested_at = GetTime();
-                                cells[id].plantedAt = 0;
-                            }
-                            
-                            break;
-                        }
-                        default: {
-                            TraceLog(LOG_ERROR, "tried to use a non-existent item");
-                            break;
-                        }
-                    }
-                }
-            }
+    while (!WindowShouldClose()) {
+        { // Input
+            PROFILE_BEGIN(PROFILE_ZONE_INPUT);
+            const Input polled = poll_input();
+            input.down = polled.down;
+            // Presses are only polled once per frame, but a frame can run zero ticks. Hold on to
+            // them until a tick actually gets to see them.
+            input.pressed |= polled.pressed;
+            // Not something the farm sees, so it stays out of Input and replays.
+            if (IsKeyPressed(KEY_F2) && !profile_tracing()) start_trace(trace_path, options.trace_frames);
+            PROFILE_END(PROFILE_ZONE_INPUT);
+        }
 
-            { // Timers
-                if (GetTime() - player.wheat_harvested_at > 1) {
-                    player.wheat_harvested_at = 0;
+        { // Update
+            PROFILE_BEGIN(PROFILE_ZONE_UPDATE);
+            const int ticks = fixed_step_begin_frame(&step);
+            for (int i = 0; i < ticks; i++) {
+                // The bot leaves the keys that don't touch the farm to the keyboard.
+                Input tick_input = input;
+                if (options.bot) {
+                    const Input played = farm_bot_input(&bot, &world);
+                    tick_input.down = played.down;
+                    tick_input.pressed = played.pressed | (input.pressed & (INPUT_TOGGLE_DEBUG | INPUT_TOGGLE_PAUSE));
                 }
+                if (options.record_path != NULL) replay_record(&replay, tick_input);
 
-                if ((GetTime() - player.swung_scythe_at) * 1000 > 500) {
-                    player.swung_scythe_at = 0;
-                }
+                world_update(&world, tick_input);
+                input.pressed = 0;
             }
 
-            { // Animation
-                if (IsKeyDown(KEY_UP)) {
-                    player_sprite_sheet_row = PLAYER_SPRITE_SHEET_UP_ROW;
-                    player.dir = UP;
-                } else if (IsKeyDown(KEY_DOWN) || (IsKeyDown(KEY_LEFT) && IsKeyDown(KEY_RIGHT))) {
-                    player_sprite_sheet_row = PLAYER_SPRITE_SHEET_DOWN_ROW;
-                    player.dir = DOWN;
-                } else if (IsKeyDown(KEY_LEFT)) {
-                    player_sprite_sheet_row = PLAYER_SPRITE_SHEET_LEFT_ROW;
-                    player.dir = LEFT;
-                } else if (IsKeyDown(KEY_RIGHT)) {
-                    player_sprite_sheet_row = PLAYER_SPRITE_SHEET_RIGHT_ROW;
-                    player.dir = RIGHT;
-                }
-
-                // Movement animation frames
-                const int now_in_millis = (int)(GetTime() * 1000.0f);
-                const int anim_millis = is_running ? PLAYER_RUNNING_SPEED_ANIM_MILLIS : PLAYER_WALKING_SPEED_ANIM_MILLIS;
-                if (is_idle) {
-                    if (now_in_millis % 2000 < 1500) {
-                        player_sprite_sheet_col = 0;
-                    } else {
-                        player_sprite_sheet_col = 1;
-                    }
+            if (options.save_path != NULL) {
+                if (world.tick - saved_at >= AUTOSAVE_TICKS) {
+                    autosave(&saver, &world);
+                    saved_at = world.tick;
                 } else {
-                    if (now_in_millis % (anim_millis*2) < anim_millis) {
-                        player_sprite_sheet_col = 2;
-                    } else {
-                        player_sprite_sheet_col = 3;
-                    }
+                    SaveStats stats;
+                    if (save_poll(&saver, &stats)) log_save_stats(&saver, stats);
                 }
             }
+            PROFILE_END(PROFILE_ZONE_UPDATE);
         }
 
         { // Draw
-draw:       BeginDrawing();
+            const Character player = world.player;
+            const Cell *cells = world.cells;
+            const CropStore *crops = &world.crops;
+            const float cell_size = MAP_CELL_SIZE * MAP_SCALE;
+
+            PROFILE_BEGIN(PROFILE_ZONE_DRAW_WORLD);
+            follow_camera_update(&camera, get_character_pos(player), GetScreenWidth(), GetScreenHeight(), world.width, world.height, cell_size);
+
+            sprite_batch_begin_frame(&sprites);
+            // Has to happen before BeginDrawing(), it switches render targets.
+            tile_chunks_update(&tile_chunks, &sprites);
+
+            BeginDrawing();
             ClearBackground(COLOR_BACKGROUND);
 
+            BeginMode2D(camera.camera);
             { // Draw world objects
-                // Draw map
-                DrawTextureEx(map, (Vector2) { 0.0f, 0.0f }, 0.0f, MAP_SCALE, WHITE);
-
-                // Draw additions to cells
-                // TODO: this is relatively slow because we have to go through all of the cells
-                // every frame. What would be better is if we could know beforehand which cells
-                // needed to be drawn.
-                for (int i = 0; i < MAP_COLS * MAP_ROWS; i++) {
-                    // Draw planted cells
-                    if (cells[i].plantedAt > 0) {
-                        float plant_sprite_sheet_x = 16.0f;
-                        if (GetTime() - cells[i].plantedAt > 1.0) {
-                            plant_sprite_sheet_x = 32.0f;
-                        }
-                        if (GetTime() - cells[i].plantedAt > 2.0) {
-                            plant_sprite_sheet_x = 48.0f;
-                        }
-                        if (GetTime() - cells[i].plantedAt > 3.0) {
-                            plant_sprite_sheet_x = 64.0f;
-                        }
-                        DrawTexturePro(
-                            plants_sprite_sheet,
+                // Draw map, and the terrain around it
+                tile_chunks_draw_pages(&tile_chunks, &sprites, &world.pages, camera.visible, MAP_SCALE);
+                tile_chunks_draw(&tile_chunks, &sprites, camera.visible, MAP_SCALE);
+
+                // Draw planted cells. Only the cells that have something on them are in the active
+                // set, so this scales with how much is planted, not with the map size.
+                for (int a = 0; a < world.active_cell_count; a++) {
+                    const int i = world.active_cells[a];
+                    if (!follow_camera_sees_cell(&camera, i % world.cols, i / world.cols)) continue;
+
+                    if (crop_is_planted(crops, i)) {
+                        // The growth stages sit left to right on the sprite sheet, starting at the
+                        // second column.
+                        const float plant_sprite_sheet_x = crops->stage[i] * PLANTS_SPRITE_SHEET_STRIDE;
+                        sprite_batch_draw(
+                            &sprites,
+                            SPRITE_LAYER_GROUND,
+                            ATLAS_PLANTS,
                             (Rectangle) { plant_sprite_sheet_x, 0.0f, PLANTS_SPRITE_SHEET_STRIDE, PLANTS_SPRITE_SHEET_STRIDE },
-                            (Rectangle) { cells[i].x, cells[i].y, MAP_CELL_SIZE * MAP_SCALE, MAP_CELL_SIZE * MAP_SCALE },
+                            (Rectangle) { cells[i].x, cells[i].y, cell_size, cell_size },
                             (Vector2) { 0, 0 },
-                            0.0f,
                             WHITE
                         );
                     }
-
-                    if (cells[i].wettedAt > 0) {
-                        DrawRectangle(
-                            cells[i].x,
-                            cells[i].y,
-                            MAP_CELL_SIZE * MAP_SCALE,
-                            MAP_CELL_SIZE * MAP_SCALE,
-                            (Color) { 0, 0, 64, 32 }
-                        );
-                    }
                 }
 
-                // Draw game objects debug info
-                if (game_state.debug_mode) {
-                    // Draw world grid
-                    for (int i = 0; i < MAP_WIDTH * MAP_SCALE; i += MAP_CELL_SIZE * MAP_SCALE) {
-                        DrawLine(i, 0, i+1, MAP_HEIGHT * MAP_SCALE, PINK);
-                        DrawLine(0, i, MAP_WIDTH * MAP_SCALE, i+1, PINK);
+                // Draw wet soil, darker the wetter it is. Moisture seeps everywhere, so this goes
+                // over every cell on screen instead of the active set.
+                for (int y = camera.cell_y0; y < camera.cell_y1; y++) {
+                    for (int x = camera.cell_x0; x < camera.cell_x1; x++) {
+                        const int i = x + y * world.cols;
+                        const float moisture = moisture_get(&world.moisture, i);
+                        if (moisture < SOIL_TINT_MIN_MOISTURE) continue;
+
+                        sprite_batch_rect(
+                            &sprites,
+                            SPRITE_LAYER_GROUND,
+                            (Rectangle) { cells[i].x, cells[i].y, cell_size, cell_size },
+                            (Color) { 0, 0, 64, (unsigned char)(SOIL_TINT_MAX_ALPHA * moisture) }
+                        );
                     }
-
-                    // Draw cell player is standing in
-                    DrawRectangleRec(get_character_cell_rect(player), (Color) { 230, 41, 55, 64 });
-                    DrawRectangleLinesEx(player.rect, 1.0f, ORANGE);
                 }
 
                 { // Draw player
-                    DrawTexturePro(
-                        player_sprite_sheet,
-                        (Rectangle) {
-                            player_sprite_sheet_col * PLAYER_SPRITE_SHEET_STRIDE,
-                            player_sprite_sheet_row * PLAYER_SPRITE_SHEET_STRIDE,
-                            PLAYER_SPRITE_SHEET_STRIDE,
-                            PLAYER_SPRITE_SHEET_STRIDE,
-                        },
+                    sprite_batch_draw(
+                        &sprites,
+                        SPRITE_LAYER_CHARACTERS,
+                        anim_clip(&clips, world.player_anim)->sheet,
+                        anim_sample(&clips, world.player_anim),
                         (Rectangle) {
                             player.rect.x,
                             player.rect.y,
@@ -581,19 +663,20 @@ draw:       BeginDrawing();
                             PLAYER_HEIGHT * PLAYER_SPRITE_SCALE,
                         },
                         (Vector2) { PLAYER_WIDTH, PLAYER_HEIGHT },
-                        0.0f,
                         WHITE
                     );
 
                     // Draw wheat above head if you just harvested some.
-                    if (GetTime() > 1 && GetTime() - player.wheat_harvested_at < 1.0) {
-                        const float wheatTimeAlive = (GetTime() - player.wheat_harvested_at) * WHEAT_FLOAT_SPEED;
+                    if (world.time > 1 && world.time - player.wheat_harvested_at < 1.0) {
+                        const float wheatTimeAlive = (world.time - player.wheat_harvested_at) * WHEAT_FLOAT_SPEED;
                         const unsigned char wheatAlpha = (int)(wheatTimeAlive * wheatTimeAlive / 5) <= 255
                             ? (unsigned char)(wheatTimeAlive * wheatTimeAlive / 5) 
                             : 255;
 
-                        DrawTexturePro(
-                            plants_sprite_sheet,
+                        sprite_batch_draw(
+                            &sprites,
+                            SPRITE_LAYER_CHARACTERS,
+                            ATLAS_PLANTS,
                             (Rectangle) {
                                 5 * PLANTS_SPRITE_SHEET_STRIDE,
                                 0,
@@ -607,156 +690,163 @@ draw:       BeginDrawing();
                                 player.rect.height,
                             },
                             (Vector2) { 0.0f, 0.0f },
-                            0.0f,
                             (Color) { 255, 255, 255, 255 - wheatAlpha }
                         );
                     }
                 }
 
                 // Draw tool in hand
-                const int now_in_millis = (int)(GetTime() * 1000.0f);
-                float tool_anim_sprite_sheet_col = 0.0f;
-                // TODO: lots of magic numbers here. Potential to DRY this up.
-                switch (player.dir) {
-                    case UP: {
-                        break;
-                    }
-
-                    case DOWN: {
-                        // Intentional fall through.
-                    }
-
-                    case LEFT: {
-                        if (now_in_millis % 500 < 125) {
-                            tool_anim_sprite_sheet_col = 2.0f;
-                        } else if (now_in_millis % 500 < 250) {
-                            tool_anim_sprite_sheet_col = 1.0f;
-                        } else {
-                            tool_anim_sprite_sheet_col = 0.0f;
-                        }
-                        break;
-                    }
-
-                    case RIGHT: {
-                        if (now_in_millis % 500 < 125) {
-                            tool_anim_sprite_sheet_col = 3.0f;
-                        } else if (now_in_millis % 500 < 250) {
-                            tool_anim_sprite_sheet_col = 4.0f;
-                        } else {
-                            tool_anim_sprite_sheet_col = 5.0f;
-                        }
-                        break;
-                    }
-                }
-                if (player.dir != UP && inventory.selected_idx == ITEM_ID_SCYTHE && player.swung_scythe_at != 0) {
-                    DrawTexturePro(
-                        tool_anim_sprite_sheet,
-                        (Rectangle) {
-                            tool_anim_sprite_sheet_col * TOOL_ANIM_SPRITE_SHEET_STRIDE,
-                            5 * TOOL_ANIM_SPRITE_SHEET_STRIDE,
-                            TOOL_ANIM_SPRITE_SHEET_STRIDE,
-                            TOOL_ANIM_SPRITE_SHEET_STRIDE,
-                        },
+                if (world.inventory.selected_idx == ITEM_ID_SCYTHE && player.swung_scythe_at != 0 && world.tool_anim.clip != ANIM_CLIP_NONE) {
+                    sprite_batch_draw(
+                        &sprites,
+                        SPRITE_LAYER_CHARACTERS,
+                        anim_clip(&clips, world.tool_anim)->sheet,
+                        anim_sample(&clips, world.tool_anim),
                         player.rect,
                         (Vector2) { 0 },
-                        0.0f,
                         WHITE
                     );
                 }
 
                 // Draw cell player is looking at
-                DrawRectangleRec(get_cell_rect_character_is_facing(player), (Color) { 55, 41, 230, 64 });
+                sprite_batch_rect(&sprites, SPRITE_LAYER_CHARACTERS, get_cell_rect_character_is_facing(player), (Color) { 55, 41, 230, 64 });
             
-                { // Draw chicken
-                    DrawTexturePro(
-                        chicken_sprite_sheet,
-                        (Rectangle) {
-                            CHICKEN_SPRITE_SHEET_STRIDE,
-                            CHICKEN_SPRITE_SHEET_STRIDE,
-                            CHICKEN_SPRITE_SHEET_STRIDE,
-                            CHICKEN_SPRITE_SHEET_STRIDE,
-                        },
-                        (Rectangle) {
-                            chicken.rect.x,
-                            chicken.rect.y,
-                            PLAYER_WIDTH,
-                            PLAYER_HEIGHT,
-                        },
-                        (Vector2) { 0.0f, 0.0f },
-                        0.0f,
-                        WHITE
+                { // Draw animals
+                    const Animals *animals = &world.animals;
+                    const SpriteComponent *animal_sprites = animals->sprites.data;
+                    for (size_t i = 0; i < animals->sprites.count; i++) {
+                        const TransformComponent *transform = component_get(&animals->transforms, animals->sprites.entities[i]);
+                        const Rectangle dst = {
+                            transform->position.x,
+                            transform->position.y,
+                            animal_sprites[i].size.x,
+                            animal_sprites[i].size.y,
+                        };
+                        if (!follow_camera_sees(&camera, dst)) continue;
+
+                        sprite_batch_draw(&sprites, SPRITE_LAYER_CHARACTERS, animal_sprites[i].sheet, animal_sprites[i].src, dst, (Vector2) { 0 }, WHITE);
+                    }
+                }
+
+                sprite_batch_flush(&sprites);
+
+                // Draw game objects debug info
+                if (world.game_state.debug_mode) {
+                    static int debug_ids[DEBUG_QUERY_CAP];
+                    const Rectangle visible_cells = {
+                        camera.cell_x0 * cell_size,
+                        camera.cell_y0 * cell_size,
+                        (camera.cell_x1 - camera.cell_x0) * cell_size,
+                        (camera.cell_y1 - camera.cell_y0) * cell_size,
+                    };
+
+                    // Draw world grid
+                    for (int x = camera.cell_x0; x <= camera.cell_x1; x++) {
+                        DrawLine(x * cell_size, visible_cells.y, x * cell_size + 1, visible_cells.y + visible_cells.height, PINK);
+                    }
+                    for (int y = camera.cell_y0; y <= camera.cell_y1; y++) {
+                        DrawLine(visible_cells.x, y * cell_size, visible_cells.x + visible_cells.width, y * cell_size + 1, PINK);
+                    }
+
+                    // Draw farmable cells on screen
+                    const int farmable_count = tile_mask_query_rect(
+                        &world.farmable,
+                        camera.cell_x0, camera.cell_y0, camera.cell_x1, camera.cell_y1,
+                        debug_ids, DEBUG_QUERY_CAP
                     );
+                    for (int i = 0; i < farmable_count; i++) {
+                        const Cell cell = cells[debug_ids[i]];
+                        DrawRectangleLines(cell.x, cell.y, cell_size, cell_size, GREEN);
+                    }
+
+                    // Draw collision rects on screen
+                    const int collision_count = collision_world_query(&world.collision, camera.visible, debug_ids, DEBUG_QUERY_CAP);
+                    for (int i = 0; i < collision_count; i++) {
+                        DrawRectangleLinesEx(world.collision.rects.items[debug_ids[i]], 1.0f, ORANGE);
+                    }
+
+                    // Draw cell player is standing in
+                    DrawRectangleRec(get_character_cell_rect(player), (Color) { 230, 41, 55, 64 });
+                    DrawRectangleLinesEx(player.rect, 1.0f, ORANGE);
                 }
             }
+            EndMode2D();
+            PROFILE_END(PROFILE_ZONE_DRAW_WORLD);
 
             { // Draw UI
+                PROFILE_BEGIN(PROFILE_ZONE_DRAW_UI);
                 { // Draw inventory
-                    DrawTexturePro(
-                        plants_sprite_sheet,
+                    sprite_batch_draw(
+                        &sprites,
+                        SPRITE_LAYER_UI,
+                        ATLAS_PLANTS,
                         (Rectangle) {
-                            inventory.items[0].sprite_sheet_pos.x,
-                            inventory.items[0].sprite_sheet_pos.y,
+                            world.inventory.items[0].sprite_sheet_pos.x,
+                            world.inventory.items[0].sprite_sheet_pos.y,
                             ITEM_SPRITE_SHEET_STRIDE,
                             ITEM_SPRITE_SHEET_STRIDE,
                         },
                         (Rectangle) {
-                            inventory.rect.x,
-                            inventory.rect.y,
+                            inventory_rect.x,
+                            inventory_rect.y,
                             ITEM_SPRITE_SCALE,
                             ITEM_SPRITE_SCALE,
                         },
                         (Vector2) { 0 },
-                        0.0f,
                         WHITE
                     );
 
                     // Draw watering can in inventory
-                    DrawTexturePro(
-                        item_sprite_sheet,
+                    sprite_batch_draw(
+                        &sprites,
+                        SPRITE_LAYER_UI,
+                        ATLAS_ITEMS,
                         (Rectangle) {
-                            inventory.items[1].sprite_sheet_pos.x,
-                            inventory.items[1].sprite_sheet_pos.y,
+                            world.inventory.items[1].sprite_sheet_pos.x,
+                            world.inventory.items[1].sprite_sheet_pos.y,
                             ITEM_SPRITE_SHEET_STRIDE,
                             ITEM_SPRITE_SHEET_STRIDE,
                         },
                         (Rectangle) {
-                            inventory.rect.x + (inventory.rect.width / INVENTORY_CAPACITY),
-                            inventory.rect.y,
+                            inventory_rect.x + (inventory_rect.width / INVENTORY_CAPACITY),
+                            inventory_rect.y,
                             ITEM_SPRITE_SCALE,
                             ITEM_SPRITE_SCALE,
                         },
                         (Vector2) { 0 },
-                        0.0f,
                         WHITE
                     );
 
                     // Draw scythe
-                    DrawTexturePro(
-                        item_sprite_sheet,
+                    sprite_batch_draw(
+                        &sprites,
+                        SPRITE_LAYER_UI,
+                        ATLAS_ITEMS,
                         (Rectangle) {
-                            inventory.items[2].sprite_sheet_pos.x,
-                            inventory.items[2].sprite_sheet_pos.y,
+                            world.inventory.items[2].sprite_sheet_pos.x,
+                            world.inventory.items[2].sprite_sheet_pos.y,
                             ITEM_SPRITE_SHEET_STRIDE,
                             ITEM_SPRITE_SHEET_STRIDE,
                         },
                         (Rectangle) {
-                            inventory.rect.x + (inventory.rect.width / INVENTORY_CAPACITY * 2),
-                            inventory.rect.y,
+                            inventory_rect.x + (inventory_rect.width / INVENTORY_CAPACITY * 2),
+                            inventory_rect.y,
                             ITEM_SPRITE_SCALE,
                             ITEM_SPRITE_SCALE,
                         },
                         (Vector2) { 0 },
-                        0.0f,
                         WHITE
                     );
                     
+                    sprite_batch_flush(&sprites);
+
                     // Draw selected item in inventory
                     DrawRectangleLinesEx(
                         (Rectangle) {
-                            inventory.rect.x + ((inventory.rect.width / INVENTORY_CAPACITY) * inventory.selected_idx),
-                            inventory.rect.y,
-                            inventory.rect.height,
-                            inventory.rect.height,
+                            inventory_rect.x + ((inventory_rect.width / INVENTORY_CAPACITY) * world.inventory.selected_idx),
+                            inventory_rect.y,
+                            inventory_rect.height,
+                            inventory_rect.height,
                         },
                         4.0f,
                         WHITE
@@ -764,20 +854,44 @@ draw:       BeginDrawing();
                 }
 
                 // Draw UI debug stuff
-                if (game_state.debug_mode) { 
+                if (world.game_state.debug_mode) { 
                     DrawFPS(10, 10);
                     DrawText(TextFormat("Player pos: (%d, %d)", (int)get_character_pos(player).x, (int)get_character_pos(player).y), 10, 30, FONT_SIZE_DEBUG, WHITE);
-                    DrawRectangleLinesEx(inventory.rect, 1.0f, ORANGE);
-                    DrawRectangleLinesEx(collision, 1.0f, ORANGE);
+                    DrawText(TextFormat("Draw calls: %d", sprites.draw_calls), 10, 50, FONT_SIZE_DEBUG, WHITE);
+                    const PageStats pages = world.pages.stats;
+                    DrawText(TextFormat("Pages: %d in, %d generated, %d read, %d written, %d missed", pages.resident, pages.generated, pages.read, pages.written, pages.misses), 10, 70, FONT_SIZE_DEBUG, WHITE);
+                    DrawRectangleLinesEx(inventory_rect, 1.0f, ORANGE);
+                    draw_profiler_overlay(10, 90);
                 }
+                PROFILE_END(PROFILE_ZONE_DRAW_UI);
             }
 
+            // Also where raylib waits out the rest of the frame for SetTargetFPS().
+            PROFILE_BEGIN(PROFILE_ZONE_END_DRAWING);
             EndDrawing();
+            PROFILE_END(PROFILE_ZONE_END_DRAWING);
         }
 
+        profile_frame_end();
+        if (profile_trace_full()) finish_trace(trace_path);
+
     }
     
-    UnloadTexture(player_sprite_sheet);
+    if (profile_tracing()) finish_trace(trace_path);
+    tile_chunks_free(&tile_chunks);
+    sprite_batch_unload(&sprites);
+    if (options.bot) {
+        log_farm_bot(&bot);
+        farm_bot_free(&bot);
+    }
+    if (options.record_path != NULL) finish_recording(&replay, options.record_path, &world);
+    replay_free(&replay);
+    if (options.save_path != NULL) {
+        final_save(&saver, &world);
+        save_writer_free(&saver);
+    }
+    anim_library_free(&clips);
+    job_system_free(&jobs);
     CloseAudioDevice();
     CloseWindow();
 
@@ -0,0 +1,249 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapblob.h"
+
+// These records are written and read as raw memory. If one of these fires you changed the layout,
+// bump MAP_BLOB_VERSION, fix the sizes here and rerun `./nob map`.
+static_assert(sizeof(MapBlobHeader) == 80, "MapBlobHeader layout changed");
+static_assert(sizeof(MapBlobLayer) == 40, "MapBlobLayer layout changed");
+static_assert(sizeof(TmxObjectGroup) == 32, "TmxObjectGroup layout changed");
+static_assert(sizeof(TmxObject) == 24, "TmxObject layout changed");
+static_assert(sizeof(TmxTileset) == 316, "TmxTileset layout changed");
+
+#define MAP_BLOB_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+static bool map_blob_host_is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t *)&probe == 1;
+}
+
+bool map_blob_write(const TmxMap *map, const char *path) {
+    if (!map_blob_host_is_little_endian()) {
+        fprintf(stderr, "ERROR: map blobs are little-endian, writing them on this host is not supported\n");
+        return false;
+    }
+
+    const size_t cells = (size_t)map->width * map->height;
+
+    MapBlobHeader header = {
+        .magic = MAP_BLOB_MAGIC,
+        .version = MAP_BLOB_VERSION,
+        .width = map->width,
+        .height = map->height,
+        .tilewidth = map->tilewidth,
+        .tileheight = map->tileheight,
+        .layer_count = map->layers.count,
+        .object_group_count = map->object_groups.count,
+        .object_count = map->objects.count,
+        .tileset_count = map->tilesets.count,
+        .tile_flag_count = map->tile_flags.count,
+        .tile_probability_count = map->tile_probabilities.count,
+    };
+
+    size_t size = MAP_BLOB_ALIGN(sizeof(header));
+    header.layers_offset = size;
+    size = MAP_BLOB_ALIGN(size + header.layer_count * sizeof(MapBlobLayer));
+    header.object_groups_offset = size;
+    size = MAP_BLOB_ALIGN(size + header.object_group_count * sizeof(TmxObjectGroup));
+    header.objects_offset = size;
+    size = MAP_BLOB_ALIGN(size + header.object_count * sizeof(TmxObject));
+    header.tilesets_offset = size;
+    size = MAP_BLOB_ALIGN(size + header.tileset_count * sizeof(TmxTileset));
+    header.tile_flags_offset = size;
+    size = MAP_BLOB_ALIGN(size + header.tile_flag_count * sizeof(uint8_t));
+    header.tile_probabilities_offset = size;
+    size = MAP_BLOB_ALIGN(size + header.tile_probability_count * sizeof(float));
+    const size_t gids_offset = size;
+    size = MAP_BLOB_ALIGN(size + header.layer_count * cells * sizeof(uint16_t));
+
+    if (size > UINT32_MAX) {
+        fprintf(stderr, "ERROR: map is too big for a map blob (%zu bytes)\n", size);
+        return false;
+    }
+    header.size = size;
+
+    uint8_t *buf = calloc(1, size);
+    assert(buf != NULL && "Buy more RAM lol");
+
+    memcpy(buf, &header, sizeof(header));
+
+    MapBlobLayer *layers = (MapBlobLayer *)(buf + header.layers_offset);
+    for (size_t i = 0; i < map->layers.count; i++) {
+        memcpy(layers[i].name, map->layers.items[i].name, TMX_NAME_CAP);
+        layers[i].gids_offset = gids_offset + i * cells * sizeof(uint16_t);
+        memcpy(buf + layers[i].gids_offset, map->layers.items[i].gids, cells * sizeof(uint16_t));
+    }
+
+    memcpy(buf + header.object_groups_offset, map->object_groups.items, header.object_group_count * sizeof(TmxObjectGroup));
+    memcpy(buf + header.objects_offset, map->objects.items, header.object_count * sizeof(TmxObject));
+    memcpy(buf + header.tilesets_offset, map->tilesets.items, header.tileset_count * sizeof(TmxTileset));
+    memcpy(buf + header.tile_flags_offset, map->tile_flags.items, header.tile_flag_count * sizeof(uint8_t));
+    memcpy(buf + header.tile_probabilities_offset, map->tile_probabilities.items, header.tile_probability_count * sizeof(float));
+
+    bool result = true;
+    FILE *f = fopen(path, "wb");
+    if (f == NULL || fwrite(buf, 1, size, f) != size) {
+        fprintf(stderr, "ERROR: could not write %s: %s\n", path, strerror(errno));
+        result = false;
+    }
+    if (f != NULL) fclose(f);
+    free(buf);
+    return result;
+}
+
+static bool map_blob_section_fits(const MapBlobHeader *header, uint32_t offset, uint32_t count, size_t item_size) {
+    return offset % 8 == 0 && offset <= header->size && (uint64_t)count * item_size <= header->size - offset;
+}
+
+static bool map_blob_map_file(const char *path, MapBlob *blob) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    blob->file = file;
+    blob->mapping = mapping;
+    blob->data = data;
+    blob->size = (size_t)size.QuadPart;
+    return true;
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive on its own.
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    blob->data = data;
+    blob->size = st.st_size;
+    return true;
+#endif
+}
+
+static void map_blob_unmap_file(MapBlob *blob) {
+#ifdef _WIN32
+    UnmapViewOfFile(blob->data);
+    CloseHandle(blob->mapping);
+    CloseHandle(blob->file);
+#else
+    munmap(blob->data, blob->size);
+#endif
+    memset(blob, 0, sizeof(*blob));
+}
+
+bool map_blob_open(const char *path, MapBlob *blob, TmxMap *map) {
+    memset(blob, 0, sizeof(*blob));
+    memset(map, 0, sizeof(*map));
+
+    if (!map_blob_host_is_little_endian()) return false;
+    if (!map_blob_map_file(path, blob)) return false;
+
+    const uint8_t *base = blob->data;
+    const MapBlobHeader *header = blob->data;
+    const size_t cells = (size_t)header->width * header->height;
+
+    const char *problem = NULL;
+    if (blob->size < sizeof(*header) || memcmp(header->magic, MAP_BLOB_MAGIC, sizeof(header->magic)) != 0) {
+        problem = "not a map blob";
+    } else if (header->version != MAP_BLOB_VERSION) {
+        problem = "map blob version mismatch, rerun `./nob map`";
+    } else if (header->size != blob->size) {
+        problem = "map blob is truncated";
+    } else if (!map_blob_section_fits(header, header->layers_offset, header->layer_count, sizeof(MapBlobLayer)) ||
+               !map_blob_section_fits(header, header->object_groups_offset, header->object_group_count, sizeof(TmxObjectGroup)) ||
+               !map_blob_section_fits(header, header->objects_offset, header->object_count, sizeof(TmxObject)) ||
+               !map_blob_section_fits(header, header->tilesets_offset, header->tileset_count, sizeof(TmxTileset)) ||
+               !map_blob_section_fits(header, header->tile_flags_offset, header->tile_flag_count, sizeof(uint8_t)) ||
+               !map_blob_section_fits(header, header->tile_probabilities_offset, header->tile_probability_count, sizeof(float))) {
+        problem = "map blob sections are out of bounds";
+    } else {
+        const MapBlobLayer *layers = (const MapBlobLayer *)(base + header->layers_offset);
+        for (uint32_t i = 0; i < header->layer_count && problem == NULL; i++) {
+            if (!map_blob_section_fits(header, layers[i].gids_offset, cells, sizeof(uint16_t))) {
+                problem = "map blob layer data is out of bounds";
+            }
+        }
+    }
+
+    if (problem != NULL) {
+        fprintf(stderr, "ERROR: %s: %s\n", path, problem);
+        map_blob_unmap_file(blob);
+        return false;
+    }
+
+    map->width = header->width;
+    map->height = header->height;
+    map->tilewidth = header->tilewidth;
+    map->tileheight = header->tileheight;
+
+    // Casting the const away is fine, nothing writes through a TmxMap and the pages are read only
+    // anyway, so a stray write would fault instead of quietly corrupting the map.
+    map->object_groups.items = (TmxObjectGroup *)(base + header->object_groups_offset);
+    map->object_groups.count = header->object_group_count;
+    map->objects.items = (TmxObject *)(base + header->objects_offset);
+    map->objects.count = header->object_count;
+    map->tilesets.items = (TmxTileset *)(base + header->tilesets_offset);
+    map->tilesets.count = header->tileset_count;
+    map->tile_flags.items = (uint8_t *)(base + header->tile_flags_offset);
+    map->tile_flags.count = header->tile_flag_count;
+    map->tile_probabilities.items = (float *)(base + header->tile_probabilities_offset);
+    map->tile_probabilities.count = header->tile_probability_count;
+
+    const MapBlobLayer *layers = (const MapBlobLayer *)(base + header->layers_offset);
+    map->layers.items = calloc(header->layer_count ? header->layer_count : 1, sizeof(TmxLayer));
+    assert(map->layers.items != NULL && "Buy more RAM lol");
+    map->layers.count = header->layer_count;
+    map->layers.capacity = header->layer_count;
+    for (uint32_t i = 0; i < header->layer_count; i++) {
+        memcpy(map->layers.items[i].name, layers[i].name, TMX_NAME_CAP);
+        map->layers.items[i].name[TMX_NAME_CAP - 1] = '\0';
+        map->layers.items[i].gids = (uint16_t *)(base + layers[i].gids_offset);
+    }
+
+    return true;
+}
+
+void map_blob_close(MapBlob *blob, TmxMap *map) {
+    free(map->layers.items);
+    memset(map, 0, sizeof(*map));
+    map_blob_unmap_file(blob);
+}
@@ -0,0 +1,58 @@
+#ifndef MAPBLOB_H_
+#define MAPBLOB_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tmx.h"
+
+// Pre-baked maps. `./nob map` compiles every .tmx (and the .tsx files it pulls in) into a .bin next
+// to it, and the game maps that file into memory and uses it as is: the object, object group and
+// tileset records are laid out exactly like their Tmx* structs, and layer gids are plain uint16_t
+// arrays. All numbers are little-endian, every section starts 8 byte aligned.
+//
+// [MapBlobHeader][MapBlobLayer * layer_count][TmxObjectGroup * ...][TmxObject * ...][TmxTileset * ...]
+// [tile flags, one byte per gid][tile probabilities, one float per gid][gids...]
+
+#define MAP_BLOB_MAGIC "YAFSMAP"
+// Bump whenever the layout of anything below, or of the Tmx* records, changes.
+#define MAP_BLOB_VERSION 3
+
+typedef struct MapBlobHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    uint32_t width, height;
+    uint32_t tilewidth, tileheight;
+    uint32_t layer_count, layers_offset;
+    uint32_t object_group_count, object_groups_offset;
+    uint32_t object_count, objects_offset;
+    uint32_t tileset_count, tilesets_offset;
+    uint32_t tile_flag_count, tile_flags_offset;
+    uint32_t tile_probability_count, tile_probabilities_offset;
+} MapBlobHeader;
+
+typedef struct MapBlobLayer {
+    char name[TMX_NAME_CAP];
+    uint32_t gids_offset;
+    uint32_t reserved;
+} MapBlobLayer;
+
+typedef struct MapBlob {
+    void *data;
+    size_t size;
+#ifdef _WIN32
+    void *file;
+    void *mapping;
+#endif
+} MapBlob;
+
+bool map_blob_write(const TmxMap *map, const char *path);
+
+// Fills `map` with pointers into the mapped file, so it must be released with map_blob_close()
+// and never with tmx_free(). Only `map->layers.items` is allocated, the rest is used in place.
+bool map_blob_open(const char *path, MapBlob *blob, TmxMap *map);
+void map_blob_close(MapBlob *blob, TmxMap *map);
+
+#endif // MAPBLOB_H_
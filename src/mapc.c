@@ -0,0 +1,22 @@
+// Bakes a Tiled map into a map blob (see mapblob.h). Run through `./nob map`.
+#include <stdio.h>
+
+#include "tmx.h"
+#include "mapblob.h"
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.tmx> <output.bin>\n", argv[0]);
+        return 1;
+    }
+
+    TmxMap map;
+    if (!tmx_load(argv[1], &map)) return 1;
+    if (!map_blob_write(&map, argv[2])) return 1;
+
+    printf("%s: %dx%d, %zu layers, %zu objects, %zu tilesets\n",
+        argv[2], map.width, map.height, map.layers.count, map.objects.count, map.tilesets.count);
+
+    tmx_free(&map);
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MOISTURE_SSE2
+#endif
+
+#include "moisture.h"
+
+// Columns of a row the kernel does before moving on to the next row. Three rows of input and one
+// of output at 4KB each fit in L1 together.
+#define MOISTURE_BLOCK_COLS 1024
+// Rows a single job gets. Maps the size of the farm fit in one job and skip the threads entirely.
+#define MOISTURE_JOB_ROWS 32
+
+void moisture_field_init(MoistureField *field, int cols, int rows, float diffusion, float evaporation) {
+    assert(diffusion >= 0.0f && diffusion <= 0.25f && "more than that and the field blows up");
+    assert(evaporation >= 0.0f && evaporation <= 1.0f);
+
+    memset(field, 0, sizeof(*field));
+    field->cols = cols;
+    field->rows = rows;
+    field->diffusion = diffusion;
+    field->evaporation = evaporation;
+    field->cells = calloc((size_t)cols * rows, sizeof(float));
+    field->next = calloc((size_t)cols * rows, sizeof(float));
+    assert(field->cells != NULL && field->next != NULL && "Buy more RAM lol");
+}
+
+void moisture_field_free(MoistureField *field) {
+    free(field->cells);
+    free(field->next);
+    memset(field, 0, sizeof(*field));
+}
+
+void moisture_add(MoistureField *field, int cell_id, float amount) {
+    const float wetter = field->cells[cell_id] + amount;
+    field->cells[cell_id] = wetter < 1.0f ? wetter : 1.0f;
+}
+
+// Kernels -----------------------------------------------------------------------------------------
+
+// The update folded into `a * c + b * (l + r + u + d)`, `a = keep * (1 - 4 * diffusion)` and
+// `b = keep * diffusion`. Every kernel adds the neighbours up in the same order so they round the
+// same way.
+static inline float moisture_cell(float a, float b, float c, float l, float r, float u, float d) {
+    const float next = a * c + b * ((l + r) + (u + d));
+    return next >= MOISTURE_EPSILON ? next : 0.0f;
+}
+
+// Cell `x` of the row `mid`, with the neighbours past the edges clamped back onto the map.
+static inline float moisture_cell_at(float a, float b, const float *up, const float *mid, const float *down, int x, int cols) {
+    const int left = x > 0 ? x - 1 : x;
+    const int right = x < cols - 1 ? x + 1 : x;
+    return moisture_cell(a, b, mid[x], mid[left], mid[right], up[x], down[x]);
+}
+
+static void moisture_weights(const MoistureField *field, float *a, float *b) {
+    const float keep = 1.0f - field->evaporation;
+    *a = keep * (1.0f - 4.0f * field->diffusion);
+    *b = keep * field->diffusion;
+}
+
+void moisture_step_scalar(MoistureField *field) {
+    float a, b;
+    moisture_weights(field, &a, &b);
+
+    for (int y = 0; y < field->rows; y++) {
+        const float *mid = field->cells + (size_t)y * field->cols;
+        const float *up = y > 0 ? mid - field->cols : mid;
+        const float *down = y + 1 < field->rows ? mid + field->cols : mid;
+        float *out = field->next + (size_t)y * field->cols;
+        for (int x = 0; x < field->cols; x++) out[x] = moisture_cell_at(a, b, up, mid, down, x, field->cols);
+    }
+
+    float *swap = field->cells;
+    field->cells = field->next;
+    field->next = swap;
+}
+
+// Cells [x0, x1) of one row. The first and last cell of the row need their neighbours clamped and
+// go through moisture_cell_at(), everything in between a vector at a time.
+static void moisture_row(float a, float b, const float *up, const float *mid, const float *down, float *out, int x0, int x1, int cols) {
+    int x = x0;
+    if (x == 0 && x < x1) {
+        out[0] = moisture_cell_at(a, b, up, mid, down, 0, cols);
+        x = 1;
+    }
+
+    const int interior_end = x1 < cols - 1 ? x1 : cols - 1;
+#if defined(__AVX__)
+    const __m256 a8 = _mm256_set1_ps(a);
+    const __m256 b8 = _mm256_set1_ps(b);
+    const __m256 epsilon8 = _mm256_set1_ps(MOISTURE_EPSILON);
+    for (; x + 8 <= interior_end; x += 8) {
+        const __m256 c = _mm256_loadu_ps(mid + x);
+        const __m256 lr = _mm256_add_ps(_mm256_loadu_ps(mid + x - 1), _mm256_loadu_ps(mid + x + 1));
+        const __m256 ud = _mm256_add_ps(_mm256_loadu_ps(up + x), _mm256_loadu_ps(down + x));
+        const __m256 next = _mm256_add_ps(_mm256_mul_ps(a8, c), _mm256_mul_ps(b8, _mm256_add_ps(lr, ud)));
+        _mm256_storeu_ps(out + x, _mm256_and_ps(next, _mm256_cmp_ps(next, epsilon8, _CMP_GE_OQ)));
+    }
+#elif defined(MOISTURE_SSE2)
+    const __m128 a4 = _mm_set1_ps(a);
+    const __m128 b4 = _mm_set1_ps(b);
+    const __m128 epsilon4 = _mm_set1_ps(MOISTURE_EPSILON);
+    for (; x + 4 <= interior_end; x += 4) {
+        const __m128 c = _mm_loadu_ps(mid + x);
+        const __m128 lr = _mm_add_ps(_mm_loadu_ps(mid + x - 1), _mm_loadu_ps(mid + x + 1));
+        const __m128 ud = _mm_add_ps(_mm_loadu_ps(up + x), _mm_loadu_ps(down + x));
+        const __m128 next = _mm_add_ps(_mm_mul_ps(a4, c), _mm_mul_ps(b4, _mm_add_ps(lr, ud)));
+        _mm_storeu_ps(out + x, _mm_and_ps(next, _mm_cmpge_ps(next, epsilon4)));
+    }
+#endif
+    for (; x < interior_end; x++) {
+        out[x] = moisture_cell(a, b, mid[x], mid[x - 1], mid[x + 1], up[x], down[x]);
+    }
+
+    if (x1 == cols && x < x1) out[x] = moisture_cell_at(a, b, up, mid, down, x, cols);
+}
+
+// Rows [begin, end) of the next field, one block of columns at a time.
+static void moisture_step_rows(void *ctx, size_t begin, size_t end) {
+    MoistureField *field = ctx;
+    const int cols = field->cols;
+    float a, b;
+    moisture_weights(field, &a, &b);
+
+    for (int x0 = 0; x0 < cols; x0 += MOISTURE_BLOCK_COLS) {
+        const int x1 = x0 + MOISTURE_BLOCK_COLS < cols ? x0 + MOISTURE_BLOCK_COLS : cols;
+        for (size_t y = begin; y < end; y++) {
+            const float *mid = field->cells + y * cols;
+            const float *up = y > 0 ? mid - cols : mid;
+            const float *down = y + 1 < (size_t)field->rows ? mid + cols : mid;
+            moisture_row(a, b, up, mid, down, field->next + y * cols, x0, x1, cols);
+        }
+    }
+}
+
+void moisture_step(MoistureField *field, JobSystem *jobs) {
+    job_parallel_for(jobs, field->rows, MOISTURE_JOB_ROWS, moisture_step_rows, field);
+
+    float *swap = field->cells;
+    field->cells = field->next;
+    field->next = swap;
+}
+
+const char *moisture_kernel_name(void) {
+#if defined(__AVX__)
+    return "avx";
+#elif defined(MOISTURE_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
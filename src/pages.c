@@ -0,0 +1,548 @@
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nob.h"
+#include "pages.h"
+
+// These records are written and read as raw memory. If one of these fires you changed the layout,
+// bump PAGE_VERSION and fix the sizes here.
+static_assert(sizeof(PageHeader) == 32, "PageHeader layout changed");
+static_assert((PAGE_MAP_CAPACITY & (PAGE_MAP_CAPACITY - 1)) == 0, "PAGE_MAP_CAPACITY has to be a power of two");
+static_assert(PAGE_MAP_CAPACITY > PAGE_POOL_CAPACITY, "the page map would fill up");
+static_assert(PAGE_LAYER_WATER == (int)TERRAIN_WATER && PAGE_LAYER_GRASS == (int)TERRAIN_GRASS &&
+              PAGE_LAYER_HILLS == (int)TERRAIN_HILLS && PAGE_LAYER_DIRT == (int)TERRAIN_DIRT &&
+              PAGE_LAYERS == (int)TERRAIN_KIND_COUNT, "page layers have to match the terrain kinds");
+
+static bool pages_host_is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t *)&probe == 1;
+}
+
+static bool pages_cell_is_on_map(const WorldPages *pages, int x, int y) {
+    return x >= 0 && y >= 0 && x < pages->map->width && y < pages->map->height;
+}
+
+// How many pages away from the one the player is on, in the worse of the two directions.
+static int page_distance(const WorldPages *pages, const Page *page) {
+    const int dx = abs(page->x - pages->center_x);
+    const int dy = abs(page->y - pages->center_y);
+    return dx > dy ? dx : dy;
+}
+
+// Hash map ----------------------------------------------------------------------------------------
+
+static uint32_t page_hash(int x, int y) {
+    uint32_t h = (uint32_t)x * 0x9E3779B1u ^ (uint32_t)y * 0x85EBCA77u;
+    h ^= h >> 16;
+    return h & (PAGE_MAP_CAPACITY - 1);
+}
+
+// Slot of the page, -1 if it's not in. Never runs forever, the map is never full.
+static int page_map_find(const WorldPages *pages, int x, int y) {
+    for (uint32_t i = page_hash(x, y);; i = (i + 1) & (PAGE_MAP_CAPACITY - 1)) {
+        const PageEntry *entry = &pages->entries[i];
+        if (entry->slot < 0) return -1;
+        if (entry->x == x && entry->y == y) return entry->slot;
+    }
+}
+
+static void page_map_insert(WorldPages *pages, int x, int y, int slot) {
+    uint32_t i = page_hash(x, y);
+    while (pages->entries[i].slot >= 0) i = (i + 1) & (PAGE_MAP_CAPACITY - 1);
+    pages->entries[i] = (PageEntry) { .x = x, .y = y, .slot = slot };
+}
+
+// Backward shift deletion: every entry after the hole that could live in it moves up, so lookups
+// never have to step over tombstones.
+static void page_map_remove(WorldPages *pages, int x, int y) {
+    const uint32_t mask = PAGE_MAP_CAPACITY - 1;
+    uint32_t hole = page_hash(x, y);
+    while (pages->entries[hole].x != x || pages->entries[hole].y != y) {
+        assert(pages->entries[hole].slot >= 0 && "removing a page that isn't in the map");
+        hole = (hole + 1) & mask;
+    }
+    pages->entries[hole].slot = -1;
+
+    for (uint32_t i = (hole + 1) & mask; pages->entries[i].slot >= 0; i = (i + 1) & mask) {
+        const uint32_t home = page_hash(pages->entries[i].x, pages->entries[i].y);
+        // Entries whose home is between the hole and them have to stay where they are.
+        if (((i - home) & mask) < ((i - hole) & mask)) continue;
+
+        pages->entries[hole] = pages->entries[i];
+        pages->entries[i].slot = -1;
+        hole = i;
+    }
+}
+
+// Pool --------------------------------------------------------------------------------------------
+
+// Takes a free slot for page (x, y). There has to be one.
+static int page_claim(WorldPages *pages, int x, int y, PageState state) {
+    assert(pages->free_count > 0);
+    const int slot = pages->free_slots[--pages->free_count];
+    Page *page = &pages->pool[slot];
+    page->x = x;
+    page->y = y;
+    page->state = state;
+    page->dirty = false;
+    page->writing = false;
+    page_map_insert(pages, x, y, slot);
+    pages->stats.resident++;
+    return slot;
+}
+
+static void page_release(WorldPages *pages, int slot) {
+    Page *page = &pages->pool[slot];
+    page_map_remove(pages, page->x, page->y);
+    page->state = PAGE_FREE;
+    page->dirty = false;
+    page->writing = false;
+    pages->free_slots[pages->free_count++] = slot;
+    pages->stats.resident--;
+}
+
+// Files -------------------------------------------------------------------------------------------
+
+static bool page_path(const WorldPages *pages, int x, int y, const char *suffix, char *path, size_t size) {
+    if (snprintf(path, size, "%s/%d_%d.page%s", pages->dir, x, y, suffix) < (int)size) return true;
+    fprintf(stderr, "ERROR: page directory %s is too long\n", pages->dir);
+    return false;
+}
+
+static Page *page_find_spilled(const WorldPages *pages, int x, int y) {
+    for (size_t i = 0; i < pages->spilled.count; i++) {
+        Page *spilled = &pages->spilled.items[i];
+        if (spilled->x == x && spilled->y == y) return spilled;
+    }
+    return NULL;
+}
+
+// Keeps a copy of a changed page that's about to go without being written out.
+static void page_spill(WorldPages *pages, const Page *page) {
+    assert(pages->task == NULL && "the task reads the spilled pages");
+    Page *spilled = page_find_spilled(pages, page->x, page->y);
+    if (spilled == NULL) {
+        nob_da_append(&pages->spilled, *page);
+    } else {
+        *spilled = *page;
+    }
+    pages->stats.spilled++;
+}
+
+// False when there's nothing usable in memory or on disk, the page has to be generated then.
+static bool page_read(const WorldPages *pages, Page *page) {
+    const Page *spilled = page_find_spilled(pages, page->x, page->y);
+    if (spilled != NULL) {
+        memcpy(page->gids, spilled->gids, sizeof(page->gids));
+        return true;
+    }
+
+    char path[1024];
+    if (pages->dir == NULL || !page_path(pages, page->x, page->y, "", path, sizeof(path))) return false;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    PageHeader header;
+    const char *problem = NULL;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, PAGE_MAGIC, sizeof(header.magic)) != 0) {
+        problem = "not a page";
+    } else if (header.version != PAGE_VERSION || header.cells != PAGE_CELLS || header.layers != PAGE_LAYERS) {
+        problem = "page is from another version of the game";
+    } else if (header.x != page->x || header.y != page->y || header.seed != pages->seed) {
+        problem = "page is of another world";
+    } else if (fread(page->gids, sizeof(page->gids), 1, f) != 1) {
+        problem = "page is truncated";
+    }
+    fclose(f);
+
+    if (problem != NULL) {
+        fprintf(stderr, "WARNING: ignoring %s, generating it again: %s\n", path, problem);
+        return false;
+    }
+    return true;
+}
+
+// Written next to the old one and renamed over it, a crash halfway through leaves that one be.
+static bool page_write(const WorldPages *pages, const Page *page) {
+    char path[1024], tmp_path[1024];
+    if (!page_path(pages, page->x, page->y, "", path, sizeof(path))) return false;
+    if (!page_path(pages, page->x, page->y, ".tmp", tmp_path, sizeof(tmp_path))) return false;
+
+    const PageHeader header = {
+        .magic = PAGE_MAGIC,
+        .version = PAGE_VERSION,
+        .cells = PAGE_CELLS,
+        .layers = PAGE_LAYERS,
+        .x = page->x,
+        .y = page->y,
+        .seed = pages->seed,
+    };
+
+    FILE *f = fopen(tmp_path, "wb");
+    bool ok = f != NULL && fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(page->gids, sizeof(page->gids), 1, f) == 1;
+    if (f != NULL && fclose(f) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "ERROR: could not write %s: %s\n", tmp_path, strerror(errno));
+        return false;
+    }
+
+#ifdef _WIN32
+    // rename() won't replace an existing file there.
+    remove(path);
+#endif
+    if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "ERROR: could not rename %s to %s: %s\n", tmp_path, path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Filling -----------------------------------------------------------------------------------------
+
+static uint8_t page_cell_flags(const WorldPages *pages, const Page *page, int i) {
+    // Whatever is drawn on top decides, same as on the map.
+    for (int l = PAGE_LAYERS; l > 0; l--) {
+        const uint16_t gid = page->gids[l - 1][i];
+        if (gid != 0) return tmx_tile_flags(pages->map, gid);
+    }
+    return 0;
+}
+
+static void page_generate(const WorldPages *pages, Page *page) {
+    uint16_t *const layers[PAGE_LAYERS] = {
+        page->gids[PAGE_LAYER_WATER],
+        page->gids[PAGE_LAYER_GRASS],
+        page->gids[PAGE_LAYER_HILLS],
+        page->gids[PAGE_LAYER_DIRT],
+    };
+    terrain_generate(&pages->terrain, page->x * PAGE_CELLS, page->y * PAGE_CELLS, PAGE_CELLS, PAGE_CELLS, layers);
+}
+
+// Off the disk or out of the generator. Only reads `pages`, so it's fine on the task's thread.
+static void page_fill(const WorldPages *pages, Page *page, PageStats *stats) {
+    if (page_read(pages, page)) {
+        stats->read++;
+    } else {
+        page_generate(pages, page);
+        stats->generated++;
+    }
+    for (int i = 0; i < PAGE_CELLS * PAGE_CELLS; i++) page->flags[i] = page_cell_flags(pages, page, i);
+}
+
+// Streaming ---------------------------------------------------------------------------------------
+
+static void pages_task(void *ctx) {
+    WorldPages *pages = ctx;
+
+    for (int i = 0; i < pages->write_count; i++) {
+        Page *page = &pages->pool[pages->batch_writes[i]];
+        if (!page_write(pages, page)) continue;
+        page->dirty = false;
+        pages->task_stats.written++;
+    }
+    for (int i = 0; i < pages->load_count; i++) {
+        page_fill(pages, &pages->pool[pages->batch_loads[i]], &pages->task_stats);
+    }
+}
+
+// Hands the pages of a finished task back. With `wait` it waits for the task to finish, otherwise
+// it leaves one that's still going alone.
+static void pages_finish_task(WorldPages *pages, bool wait) {
+    if (pages->task == NULL) return;
+    if (!wait && !job_task_done(pages->task)) return;
+
+    job_task_wait(pages->task);
+    pages->task = NULL;
+
+    for (int i = 0; i < pages->load_count; i++) pages->pool[pages->batch_loads[i]].state = PAGE_READY;
+    for (int i = 0; i < pages->write_count; i++) {
+        const int slot = pages->batch_writes[i];
+        Page *page = &pages->pool[slot];
+        page->writing = false;
+        // Failed writes stay dirty and get another go with the next batch.
+        if (!page->dirty && page_distance(pages, page) > PAGE_KEEP_RADIUS) page_release(pages, slot);
+    }
+
+    pages->stats.generated += pages->task_stats.generated;
+    pages->stats.read += pages->task_stats.read;
+    pages->stats.written += pages->task_stats.written;
+    memset(&pages->task_stats, 0, sizeof(pages->task_stats));
+    pages->load_count = 0;
+    pages->write_count = 0;
+    pages->replan = true;
+}
+
+void pages_stream(WorldPages *pages, int cell_x, int cell_y) {
+    pages_finish_task(pages, false);
+
+    const int center_x = page_of_cell(cell_x);
+    const int center_y = page_of_cell(cell_y);
+    if (center_x != pages->center_x || center_y != pages->center_y) {
+        pages->center_x = center_x;
+        pages->center_y = center_y;
+        pages->replan = true;
+    }
+    if (!pages->replan || pages->task != NULL) return;
+    pages->replan = false;
+
+    for (int slot = 0; slot < PAGE_POOL_CAPACITY; slot++) {
+        Page *page = &pages->pool[slot];
+        if (page->state != PAGE_READY || page_distance(pages, page) <= PAGE_KEEP_RADIUS) continue;
+
+        if (!page->dirty) {
+            page_release(pages, slot);
+        } else if (pages->dir == NULL) {
+            page_spill(pages, page);
+            page_release(pages, slot);
+        } else {
+            page->writing = true;
+            pages->batch_writes[pages->write_count++] = slot;
+        }
+    }
+
+    // Nearest first, ring by ring, so the page the player is on never waits for the corners.
+    for (int r = 0; r <= PAGE_LOAD_RADIUS; r++) {
+        for (int y = center_y - r; y <= center_y + r; y++) {
+            for (int x = center_x - r; x <= center_x + r; x++) {
+                if (abs(x - center_x) != r && abs(y - center_y) != r) continue;
+                if (page_map_find(pages, x, y) >= 0) continue;
+                if (pages->free_count == 0) {
+                    // Whatever is being written out frees up room, try again after that.
+                    pages->replan = true;
+                    goto start;
+                }
+                pages->batch_loads[pages->load_count++] = page_claim(pages, x, y, PAGE_LOADING);
+            }
+        }
+    }
+
+start:
+    if (pages->load_count > 0 || pages->write_count > 0) pages->task = job_task_start(pages_task, pages);
+}
+
+bool pages_flush(WorldPages *pages) {
+    pages_finish_task(pages, true);
+    if (pages->dir == NULL) return true;
+
+    bool ok = true;
+    for (int slot = 0; slot < PAGE_POOL_CAPACITY; slot++) {
+        Page *page = &pages->pool[slot];
+        if (page->state != PAGE_READY || !page->dirty) continue;
+
+        if (page_write(pages, page)) {
+            page->dirty = false;
+            pages->stats.written++;
+        } else {
+            ok = false;
+        }
+    }
+    // The ones whose writes failed before, the copies stay so they're read first either way.
+    for (size_t i = 0; i < pages->spilled.count; i++) {
+        if (page_write(pages, &pages->spilled.items[i])) {
+            pages->stats.written++;
+        } else {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static int page_compare_coords(const void *a, const void *b) {
+    const Page *p = *(const Page *const *)a;
+    const Page *q = *(const Page *const *)b;
+    if (p->y != q->y) return (p->y > q->y) - (p->y < q->y);
+    return (p->x > q->x) - (p->x < q->x);
+}
+
+size_t pages_changed(const WorldPages *pages, const Page **out) {
+    size_t count = 0;
+    for (int slot = 0; slot < PAGE_POOL_CAPACITY; slot++) {
+        const Page *page = &pages->pool[slot];
+        if (page->state != PAGE_READY) continue;
+        if (page->dirty || page_find_spilled(pages, page->x, page->y) != NULL) out[count++] = page;
+    }
+    // The resident copy is the newer one, a spilled page that's still loading is the same as what
+    // it's going to load.
+    for (size_t i = 0; i < pages->spilled.count; i++) {
+        const Page *spilled = &pages->spilled.items[i];
+        const Page *resident = pages_peek(pages, spilled->x, spilled->y);
+        if (resident == NULL) out[count++] = spilled;
+    }
+    qsort(out, count, sizeof(*out), page_compare_coords);
+    return count;
+}
+
+// Makes sure there's a free slot. Gets rid of the page furthest from the player if it has to.
+static void pages_make_room(WorldPages *pages) {
+    if (pages->free_count > 0) return;
+    pages_finish_task(pages, true);
+    if (pages->free_count > 0) return;
+
+    int victim = -1;
+    int victim_distance = -1;
+    for (int slot = 0; slot < PAGE_POOL_CAPACITY; slot++) {
+        const int distance = page_distance(pages, &pages->pool[slot]);
+        if (distance > victim_distance) {
+            victim = slot;
+            victim_distance = distance;
+        }
+    }
+
+    Page *page = &pages->pool[victim];
+    if (page->dirty) {
+        if (pages->dir != NULL && page_write(pages, page)) {
+            pages->stats.written++;
+        } else {
+            page_spill(pages, page);
+        }
+    }
+    page_release(pages, victim);
+}
+
+// Pages -------------------------------------------------------------------------------------------
+
+void pages_init(WorldPages *pages, const TmxMap *map, uint32_t seed) {
+    memset(pages, 0, sizeof(*pages));
+    pages->map = map;
+    pages->seed = seed;
+    pages->replan = true;
+
+    pages->pool = calloc(PAGE_POOL_CAPACITY, sizeof(Page));
+    assert(pages->pool != NULL && "Buy more RAM lol");
+    // Backwards, so slot 0 is the first to go.
+    for (int slot = PAGE_POOL_CAPACITY - 1; slot >= 0; slot--) pages->free_slots[pages->free_count++] = slot;
+    for (int i = 0; i < PAGE_MAP_CAPACITY; i++) pages->entries[i].slot = -1;
+
+    terrain_init(&pages->terrain, map, seed);
+}
+
+void pages_free(WorldPages *pages) {
+    pages_finish_task(pages, true);
+    free(pages->pool);
+    free(pages->dir);
+    nob_da_free(pages->spilled);
+    memset(pages, 0, sizeof(*pages));
+}
+
+bool pages_set_dir(WorldPages *pages, const char *dir) {
+    // The task reads `dir`.
+    pages_finish_task(pages, true);
+    free(pages->dir);
+    pages->dir = NULL;
+
+    if (!pages_host_is_little_endian()) {
+        fprintf(stderr, "ERROR: pages are little-endian, writing them on this host is not supported\n");
+        return false;
+    }
+    if (!nob_mkdir_if_not_exists(dir)) return false;
+
+    pages->dir = strdup(dir);
+    assert(pages->dir != NULL && "Buy more RAM lol");
+    return true;
+}
+
+Page *pages_get(WorldPages *pages, int page_x, int page_y) {
+    int slot = page_map_find(pages, page_x, page_y);
+    if (slot >= 0) {
+        if (pages->pool[slot].state == PAGE_LOADING) pages_finish_task(pages, true);
+        return &pages->pool[slot];
+    }
+
+    pages->stats.misses++;
+    pages_make_room(pages);
+    slot = page_claim(pages, page_x, page_y, PAGE_LOADING);
+    Page *page = &pages->pool[slot];
+    page_fill(pages, page, &pages->stats);
+    page->state = PAGE_READY;
+    return page;
+}
+
+const Page *pages_peek(const WorldPages *pages, int page_x, int page_y) {
+    const int slot = page_map_find(pages, page_x, page_y);
+    if (slot < 0 || pages->pool[slot].state != PAGE_READY) return NULL;
+    return &pages->pool[slot];
+}
+
+uint8_t pages_cell_flags(WorldPages *pages, int x, int y) {
+    if (pages_cell_is_on_map(pages, x, y)) return 0;
+
+    const Page *page = pages_get(pages, page_of_cell(x), page_of_cell(y));
+    return page->flags[(x - page->x * PAGE_CELLS) + (y - page->y * PAGE_CELLS) * PAGE_CELLS];
+}
+
+void pages_set_gid(WorldPages *pages, int x, int y, int layer, uint16_t gid) {
+    assert(layer >= 0 && layer < PAGE_LAYERS);
+    if (pages_cell_is_on_map(pages, x, y)) return;
+
+    Page *page = pages_get(pages, page_of_cell(x), page_of_cell(y));
+    if (page->writing) pages_finish_task(pages, true);
+
+    const int i = (x - page->x * PAGE_CELLS) + (y - page->y * PAGE_CELLS) * PAGE_CELLS;
+    page->gids[layer][i] = gid;
+    page->flags[i] = page_cell_flags(pages, page, i);
+    page->dirty = true;
+}
+
+static bool pages_cell_has(WorldPages *pages, int x, int y, TerrainKind kind) {
+    if (pages_cell_is_on_map(pages, x, y)) return terrain_map_has(&pages->terrain, kind, x, y);
+
+    const Page *page = pages_get(pages, page_of_cell(x), page_of_cell(y));
+    return page->gids[kind][(x - page->x * PAGE_CELLS) + (y - page->y * PAGE_CELLS) * PAGE_CELLS] != 0;
+}
+
+bool pages_set_terrain(WorldPages *pages, int x, int y, TerrainKind kind, bool present) {
+    if (pages_cell_is_on_map(pages, x, y)) return false;
+
+    // Anything will do for now, it only has to be there for the neighbours to see.
+    pages_set_gid(pages, x, y, kind, present ? pages->terrain.tiles[kind].firstgid : 0);
+
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            const int cx = x + dx;
+            const int cy = y + dy;
+            if (pages_cell_is_on_map(pages, cx, cy) || !pages_cell_has(pages, cx, cy, kind)) continue;
+
+            uint8_t mask = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                if (pages_cell_has(pages, cx + autotile_offsets[bit][0], cy + autotile_offsets[bit][1], kind)) mask |= 1 << bit;
+            }
+            pages_set_gid(pages, cx, cy, kind, terrain_tile(&pages->terrain, kind, cx, cy, mask));
+        }
+    }
+    return true;
+}
+
+int pages_solid_rects(WorldPages *pages, Rectangle area, float cell_size, Rectangle *out, int cap) {
+    const int x0 = (int)floorf(area.x / cell_size);
+    const int y0 = (int)floorf(area.y / cell_size);
+    const int x1 = (int)ceilf((area.x + area.width) / cell_size);
+    const int y1 = (int)ceilf((area.y + area.height) / cell_size);
+
+    int count = 0;
+    for (int y = y0; y < y1; y++) {
+        int x = x0;
+        while (x < x1) {
+            if (!(pages_cell_flags(pages, x, y) & TMX_TILE_SOLID)) {
+                x++;
+                continue;
+            }
+
+            const int run_start = x;
+            while (x < x1 && (pages_cell_flags(pages, x, y) & TMX_TILE_SOLID)) x++;
+
+            if (count == cap) return count;
+            out[count++] = (Rectangle) {
+                .x = run_start * cell_size,
+                .y = y * cell_size,
+                .width = (x - run_start) * cell_size,
+                .height = cell_size,
+            };
+        }
+    }
+    return count;
+}
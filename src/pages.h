@@ -0,0 +1,169 @@
+#ifndef PAGES_H_
+#define PAGES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <raylib.h>
+
+#include "jobs.h"
+#include "terrain.h"
+#include "tmx.h"
+
+// The world past the edge of the hand-painted map, which goes on for as far as anybody cares to
+// walk. It's cut into pages of PAGE_CELLS by PAGE_CELLS cells, page (0, 0) having its top left
+// corner where the map has its own, and only the pages around the player are in memory:
+//
+// - Pages within PAGE_LOAD_RADIUS of the page the player is on get loaded ahead of time, by a task
+//   on a thread of its own (see JobTask in jobs.h). A page comes off the disk if it was changed and
+//   written out at some point, otherwise it gets generated from the seed, same page every time (see
+//   terrain.h).
+// - Pages further out than PAGE_KEEP_RADIUS get evicted. Changed ones are written to `dir` first,
+//   by the same kind of task. Without a `dir`, or when writing one fails, they get copied aside in
+//   memory instead and come back from there. A change is never lost to eviction.
+// - Whatever needs a page that isn't in yet, like a player outrunning the loading, loads it right
+//   there instead. What's on a page never depends on how far the loading got, only how long it
+//   takes does, so the simulation stays deterministic.
+//
+// Pages live in a pool of PAGE_POOL_CAPACITY allocated up front and are found through a hash map
+// keyed by page coordinate, so memory stays the same no matter how far the player walks.
+//
+// The cells of the map itself are left empty in here, the farm keeps working off the arrays in
+// World.
+
+#define PAGE_CELLS 64
+#define PAGE_LOAD_RADIUS 1
+#define PAGE_KEEP_RADIUS 2
+// Every page the player can keep around, plus room for a ring of them waiting to be written out.
+#define PAGE_POOL_CAPACITY ((2 * PAGE_KEEP_RADIUS + 1) * (2 * PAGE_KEEP_RADIUS + 1) + (2 * PAGE_LOAD_RADIUS + 1) * (2 * PAGE_LOAD_RADIUS + 1))
+// Power of two, a good bit more than the pool so probes stay short.
+#define PAGE_MAP_CAPACITY 128
+
+#define PAGE_MAGIC "YAFSPAG"
+// Bump whenever the layout of a page file changes.
+#define PAGE_VERSION 1
+
+// Drawn bottom to top, the same as the terrain layers of the map.
+typedef enum {
+    PAGE_LAYER_WATER = 0,
+    PAGE_LAYER_GRASS,
+    PAGE_LAYER_HILLS,
+    PAGE_LAYER_DIRT,
+    PAGE_LAYERS,
+} PageLayer;
+
+typedef enum {
+    PAGE_FREE = 0,
+    PAGE_LOADING,
+    PAGE_READY,
+} PageState;
+
+// Start of a page file, followed by `uint16_t gids[PAGE_LAYERS][PAGE_CELLS * PAGE_CELLS]`.
+// Little-endian, raw memory like the map blobs.
+typedef struct PageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t cells, layers;
+    int32_t x, y;
+    // Pages only go with the world they were generated for.
+    uint32_t seed;
+} PageHeader;
+
+typedef struct Page {
+    int x, y;
+    PageState state;
+    // Changed since it was loaded, has to be written out before it can go.
+    bool dirty;
+    // The task is writing it out, it must not change until that's done.
+    bool writing;
+    // Row major, gids of the map's tilesets, 0 for nothing.
+    uint16_t gids[PAGE_LAYERS][PAGE_CELLS * PAGE_CELLS];
+    // TmxTileFlag bits of every cell, from the top-most tile on it.
+    uint8_t flags[PAGE_CELLS * PAGE_CELLS];
+} Page;
+
+typedef struct PageStats {
+    int resident;
+    int generated, read, written, spilled;
+    // Pages somebody needed before the streaming got to them.
+    int misses;
+} PageStats;
+
+typedef struct PageEntry {
+    int32_t x, y;
+    // Into the pool, -1 for an empty entry.
+    int slot;
+} PageEntry;
+
+typedef struct WorldPages {
+    const TmxMap *map;
+    uint32_t seed;
+    // Where changed pages get written, NULL to keep them in `spilled`.
+    char *dir;
+    // Changed pages that got evicted without being written, by coordinate. Read before `dir`. Only
+    // touched while there's no task, the task reads it.
+    struct {
+        Page *items;
+        size_t count, capacity;
+    } spilled;
+
+    Page *pool;
+    int free_slots[PAGE_POOL_CAPACITY];
+    int free_count;
+    // Open addressing with linear probing.
+    PageEntry entries[PAGE_MAP_CAPACITY];
+
+    // What the task in flight loads and writes, slots into `pool`. Nothing else touches those
+    // pages until it's done, and the task doesn't touch anything else.
+    JobTask *task;
+    int batch_loads[PAGE_POOL_CAPACITY], load_count;
+    int batch_writes[PAGE_POOL_CAPACITY], write_count;
+    PageStats task_stats;
+
+    // Page the player was on at the last pages_stream(), and whether it needs another look even
+    // if that didn't change.
+    int center_x, center_y;
+    bool replan;
+
+    // Where pages that were never written out come from.
+    Terrain terrain;
+
+    PageStats stats;
+} WorldPages;
+
+void pages_init(WorldPages *pages, const TmxMap *map, uint32_t seed);
+// Waits for the task, doesn't write anything, see pages_flush().
+void pages_free(WorldPages *pages);
+// Where changed pages go from now on, created if it's not there.
+bool pages_set_dir(WorldPages *pages, const char *dir);
+
+// Call once a tick with the cell the player is on. Picks up whatever the task finished, evicts the
+// pages that got too far and starts loading the ones that came close. Never waits.
+void pages_stream(WorldPages *pages, int cell_x, int cell_y);
+// Writes every changed page out right now, for quitting.
+bool pages_flush(WorldPages *pages);
+// Every page that got changed and is still held in memory, resident or spilled, sorted by
+// coordinate into `out`, which needs room for `spilled.count + PAGE_POOL_CAPACITY`. Without a `dir`
+// that's every change ever made, no matter how the streaming went.
+size_t pages_changed(const WorldPages *pages, const Page **out);
+
+// Loads the page on the spot if it has to.
+Page *pages_get(WorldPages *pages, int page_x, int page_y);
+// NULL unless the page is in, never waits. For drawing.
+const Page *pages_peek(const WorldPages *pages, int page_x, int page_y);
+
+// TmxTileFlag bits of any cell, 0 on the map.
+uint8_t pages_cell_flags(WorldPages *pages, int x, int y);
+void pages_set_gid(WorldPages *pages, int x, int y, int layer, uint16_t gid);
+// Puts a kind of terrain on a cell off the map or takes it off, and redoes the edges of that cell
+// and the 8 around it. False on the map.
+bool pages_set_terrain(WorldPages *pages, int x, int y, TerrainKind kind, bool present);
+// Solid cells off the map overlapping `area` (world coordinates, cells `cell_size` wide), merged
+// into one rect per horizontal run. Returns how many it wrote to `out`.
+int pages_solid_rects(WorldPages *pages, Rectangle area, float cell_size, Rectangle *out, int cap);
+
+// Page a cell is on, rounding towards minus infinity.
+static inline int page_of_cell(int cell) {
+    return cell >= 0 ? cell / PAGE_CELLS : -((-cell + PAGE_CELLS - 1) / PAGE_CELLS);
+}
+
+#endif // PAGES_H_
@@ -0,0 +1,373 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#include "profiler.h"
+
+bool profile_enabled = false;
+
+static const char *profile_zone_names[PROFILE_ZONE_COUNT] = {
+    [PROFILE_ZONE_INPUT]       = "input",
+    [PROFILE_ZONE_UPDATE]      = "update",
+    [PROFILE_ZONE_TIMERS]      = "timers",
+    [PROFILE_ZONE_DRAW_WORLD]  = "draw world",
+    [PROFILE_ZONE_DRAW_UI]     = "draw ui",
+    [PROFILE_ZONE_END_DRAWING] = "EndDrawing",
+    [PROFILE_ZONE_JOB]         = "job",
+};
+
+// Threads -----------------------------------------------------------------------------------------
+
+// The rings are shared between the thread that writes one and the main thread that drains them,
+// with nothing but the order of a load and a store in between.
+#ifdef _MSC_VER
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+// x64 doesn't move loads before loads or stores before stores, volatile keeps the compiler from
+// doing it either.
+static uint64_t profile_load_acquire(volatile uint64_t *p) { return *p; }
+static void profile_store_release(volatile uint64_t *p, uint64_t value) { *p = value; }
+static void *profile_load_acquire_ptr(void *volatile *p) { return *p; }
+static void profile_store_release_ptr(void *volatile *p, void *value) { *p = value; }
+static uint64_t profile_fetch_add(volatile uint64_t *p) { return (uint64_t)InterlockedIncrement64((volatile LONG64 *)p) - 1; }
+#else
+#define PROFILE_THREAD_LOCAL _Thread_local
+static uint64_t profile_load_acquire(uint64_t *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static void profile_store_release(uint64_t *p, uint64_t value) { __atomic_store_n(p, value, __ATOMIC_RELEASE); }
+static void *profile_load_acquire_ptr(void **p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static void profile_store_release_ptr(void **p, void *value) { __atomic_store_n(p, value, __ATOMIC_RELEASE); }
+static uint64_t profile_fetch_add(uint64_t *p) { return __atomic_fetch_add(p, 1, __ATOMIC_RELAXED); }
+#endif
+
+typedef struct ProfileRing {
+    // Its thread's track in traces.
+    uint64_t index;
+    char name[32];
+    // Only the thread it belongs to writes events and moves `head`, which only ever grows, the slot
+    // is the value modulo the capacity. Writing doesn't wait for the reader, a thread that records
+    // more than fits between two frame ends overwrites its oldest zones.
+    uint64_t head;
+    ProfileEvent events[PROFILE_RING_CAPACITY];
+} ProfileRing;
+
+static_assert((PROFILE_RING_CAPACITY & (PROFILE_RING_CAPACITY - 1)) == 0, "ring capacity must be a power of two");
+
+// Every thread gets its ring the first time it ends a zone and keeps it until exit.
+static uint64_t profile_ring_count = 0;
+static void *profile_rings[PROFILE_MAX_THREADS] = {0};
+
+static PROFILE_THREAD_LOCAL ProfileRing *profile_ring = NULL;
+// Past PROFILE_MAX_THREADS, the thread doesn't get to record anything.
+static PROFILE_THREAD_LOCAL bool profile_ring_full = false;
+static PROFILE_THREAD_LOCAL uint32_t profile_depth = 0;
+
+static ProfileRing *profile_ring_get(void) {
+    if (profile_ring != NULL || profile_ring_full) return profile_ring;
+
+    const uint64_t index = profile_fetch_add(&profile_ring_count);
+    if (index >= PROFILE_MAX_THREADS) {
+        profile_ring_full = true;
+        return NULL;
+    }
+    profile_ring = calloc(1, sizeof(*profile_ring));
+    assert(profile_ring != NULL && "Buy more RAM lol");
+    profile_ring->index = index;
+    snprintf(profile_ring->name, sizeof(profile_ring->name), "thread %llu", (unsigned long long)index);
+    profile_store_release_ptr(&profile_rings[index], profile_ring);
+    return profile_ring;
+}
+
+uint64_t profile_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq = {0};
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Split so the multiplication can't overflow for any uptime.
+    const uint64_t seconds = counter.QuadPart / freq.QuadPart;
+    const uint64_t rest = counter.QuadPart % freq.QuadPart;
+    return seconds * 1000000000ull + rest * 1000000000ull / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+uint64_t profile_begin(void) {
+    profile_depth += 1;
+    return profile_now_ns();
+}
+
+void profile_end(ProfileZone zone, uint64_t begin_ns) {
+    const uint64_t end_ns = profile_now_ns();
+    profile_depth -= 1;
+
+    ProfileRing *ring = profile_ring_get();
+    if (ring == NULL) return;
+    ring->events[ring->head & (PROFILE_RING_CAPACITY - 1)] = (ProfileEvent) {
+        .begin_ns = begin_ns,
+        .end_ns = end_ns,
+        .zone = zone,
+        .depth = profile_depth,
+    };
+    profile_store_release(&ring->head, ring->head + 1);
+}
+
+void profile_enable(void) {
+    profile_enabled = true;
+}
+
+const char *profile_zone_name(ProfileZone zone) {
+    assert(zone < PROFILE_ZONE_COUNT);
+    return profile_zone_names[zone];
+}
+
+void profile_thread_name(const char *name) {
+    if (!profile_enabled) return;
+    ProfileRing *ring = profile_ring_get();
+    if (ring != NULL) snprintf(ring->name, sizeof(ring->name), "%s", name);
+}
+
+// Traces ------------------------------------------------------------------------------------------
+
+// Longest an event can get in the trace, the buffer goes to the file before it has less room left.
+#define PROFILE_TRACE_EVENT_MAX 256
+
+typedef struct ProfileTrace {
+    FILE *file;
+    const char *path;
+    char *buffer;
+    size_t size;
+    // Timestamps in the file count from here.
+    uint64_t start_ns;
+    int frames_left;
+    // Whether the next event needs a comma before it.
+    bool separate;
+    bool failed;
+    ProfileTraceStats stats;
+} ProfileTrace;
+
+static ProfileTrace profile_trace = {0};
+
+static void profile_trace_flush(void) {
+    ProfileTrace *trace = &profile_trace;
+    if (trace->size == 0) return;
+    if (!trace->failed && fwrite(trace->buffer, 1, trace->size, trace->file) != trace->size) {
+        fprintf(stderr, "ERROR: could not write %s: %s\n", trace->path, strerror(errno));
+        trace->failed = true;
+    }
+    trace->stats.bytes += trace->size;
+    trace->size = 0;
+}
+
+// The names are all ours, none of them need escaping.
+static void profile_trace_event(const char *name, uint64_t tid, uint64_t begin_ns, uint64_t end_ns) {
+    ProfileTrace *trace = &profile_trace;
+    // Started before the trace did.
+    if (begin_ns < trace->start_ns) return;
+    if (PROFILE_TRACE_BUFFER_SIZE - trace->size < PROFILE_TRACE_EVENT_MAX) profile_trace_flush();
+
+    const int n = snprintf(trace->buffer + trace->size, PROFILE_TRACE_EVENT_MAX,
+        "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+        trace->separate ? ",\n" : "", name, (unsigned long long)tid,
+        (begin_ns - trace->start_ns) * 1e-3, (end_ns - begin_ns) * 1e-3);
+    assert(n > 0 && n < PROFILE_TRACE_EVENT_MAX);
+    trace->size += n;
+    trace->separate = true;
+    trace->stats.events += 1;
+}
+
+bool profile_trace_begin(const char *path, int frames) {
+    ProfileTrace *trace = &profile_trace;
+    assert(trace->file == NULL && "already tracing");
+    assert(frames > 0);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: could not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    // It gets written a buffer at a time anyway.
+    setvbuf(file, NULL, _IONBF, 0);
+
+    char *buffer = trace->buffer;
+    if (buffer == NULL) {
+        buffer = malloc(PROFILE_TRACE_BUFFER_SIZE);
+        assert(buffer != NULL && "Buy more RAM lol");
+    }
+    *trace = (ProfileTrace) {
+        .file = file,
+        .path = path,
+        .buffer = buffer,
+        .start_ns = profile_now_ns(),
+        .frames_left = frames,
+    };
+
+    static const char header[] = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    memcpy(trace->buffer, header, sizeof(header) - 1);
+    trace->size = sizeof(header) - 1;
+    return true;
+}
+
+bool profile_tracing(void) {
+    return profile_trace.file != NULL;
+}
+
+bool profile_trace_full(void) {
+    return profile_trace.file != NULL && profile_trace.frames_left <= 0;
+}
+
+bool profile_trace_end(ProfileTraceStats *stats) {
+    ProfileTrace *trace = &profile_trace;
+    assert(trace->file != NULL && "not tracing");
+
+    // Names of the tracks, for every thread that recorded something by now.
+    uint64_t count = profile_load_acquire(&profile_ring_count);
+    if (count > PROFILE_MAX_THREADS) count = PROFILE_MAX_THREADS;
+    for (uint64_t i = 0; i < count; i++) {
+        const ProfileRing *ring = profile_load_acquire_ptr(&profile_rings[i]);
+        if (ring == NULL) continue;
+        if (PROFILE_TRACE_BUFFER_SIZE - trace->size < PROFILE_TRACE_EVENT_MAX) profile_trace_flush();
+        const int n = snprintf(trace->buffer + trace->size, PROFILE_TRACE_EVENT_MAX,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":\"%s\"}}",
+            trace->separate ? ",\n" : "", (unsigned long long)ring->index, ring->name);
+        assert(n > 0 && n < PROFILE_TRACE_EVENT_MAX);
+        trace->size += n;
+        trace->separate = true;
+    }
+
+    static const char footer[] = "\n]}\n";
+    if (PROFILE_TRACE_BUFFER_SIZE - trace->size < sizeof(footer)) profile_trace_flush();
+    memcpy(trace->buffer + trace->size, footer, sizeof(footer) - 1);
+    trace->size += sizeof(footer) - 1;
+    profile_trace_flush();
+
+    bool ok = !trace->failed;
+    if (fclose(trace->file) != 0 && ok) {
+        fprintf(stderr, "ERROR: could not write %s: %s\n", trace->path, strerror(errno));
+        ok = false;
+    }
+    if (stats != NULL) *stats = trace->stats;
+    // Keeps the buffer for the next one.
+    trace->file = NULL;
+    return ok;
+}
+
+// Frames ------------------------------------------------------------------------------------------
+
+// All of it only for the main thread.
+static uint64_t profile_tails[PROFILE_MAX_THREADS] = {0};
+// Indexed by the frame modulo PROFILE_HISTORY_FRAMES.
+static uint64_t profile_zone_history[PROFILE_ZONE_COUNT][PROFILE_HISTORY_FRAMES] = {0};
+static uint64_t profile_frame_history[PROFILE_HISTORY_FRAMES] = {0};
+static uint64_t profile_frame_count = 0;
+static uint64_t profile_previous_end_ns = 0;
+static uint64_t profile_dropped_count = 0;
+
+// Adds up the zones a ring got since the last time, and traces them if there's a trace going.
+// Whatever the thread overwrote before it got read counts as dropped.
+static void profile_drain(ProfileRing *ring, uint64_t *tail, uint64_t zone_ns[PROFILE_ZONE_COUNT]) {
+    static ProfileEvent events[PROFILE_RING_CAPACITY];
+
+    // The slot of event `head` may be getting written right now, so one short of the whole ring.
+    const uint64_t head = profile_load_acquire(&ring->head);
+    if (head - *tail > PROFILE_RING_CAPACITY - 1) {
+        profile_dropped_count += head - *tail - (PROFILE_RING_CAPACITY - 1);
+        *tail = head - (PROFILE_RING_CAPACITY - 1);
+    }
+    const size_t count = head - *tail;
+    for (size_t i = 0; i < count; i++) events[i] = ring->events[(*tail + i) & (PROFILE_RING_CAPACITY - 1)];
+
+    // The thread keeps going while this copies, it may have come around to the oldest of them. It
+    // writes event `overwritten` over event `overwritten - PROFILE_RING_CAPACITY`.
+    const uint64_t overwritten = profile_load_acquire(&ring->head);
+    const bool torn = overwritten - *tail >= PROFILE_RING_CAPACITY;
+    *tail = head;
+    if (torn) {
+        profile_dropped_count += count;
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const ProfileEvent *event = &events[i];
+        if (event->zone >= PROFILE_ZONE_COUNT) continue;
+        zone_ns[event->zone] += event->end_ns - event->begin_ns;
+        if (profile_trace.file != NULL) profile_trace_event(profile_zone_names[event->zone], ring->index, event->begin_ns, event->end_ns);
+    }
+}
+
+void profile_frame_end(void) {
+    if (!profile_enabled) return;
+
+    uint64_t zone_ns[PROFILE_ZONE_COUNT] = {0};
+    uint64_t count = profile_load_acquire(&profile_ring_count);
+    if (count > PROFILE_MAX_THREADS) count = PROFILE_MAX_THREADS;
+    for (uint64_t i = 0; i < count; i++) {
+        ProfileRing *ring = profile_load_acquire_ptr(&profile_rings[i]);
+        // Got its index but isn't done setting up yet.
+        if (ring == NULL) continue;
+        profile_drain(ring, &profile_tails[i], zone_ns);
+    }
+
+    const uint64_t now = profile_now_ns();
+    if (profile_trace.file != NULL && profile_trace.frames_left > 0) {
+        if (profile_previous_end_ns != 0) {
+            ProfileRing *ring = profile_ring_get();
+            profile_trace_event("frame", ring != NULL ? ring->index : 0, profile_previous_end_ns, now);
+        }
+        profile_trace.stats.frames += 1;
+        profile_trace.frames_left -= 1;
+    }
+
+    const size_t slot = profile_frame_count % PROFILE_HISTORY_FRAMES;
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) profile_zone_history[zone][slot] = zone_ns[zone];
+    profile_frame_history[slot] = profile_previous_end_ns != 0 ? now - profile_previous_end_ns : 0;
+    profile_previous_end_ns = now;
+    profile_frame_count += 1;
+}
+
+static int profile_compare_ns(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static ProfileStats profile_stats(const uint64_t history[PROFILE_HISTORY_FRAMES]) {
+    const size_t count = profile_frame_count < PROFILE_HISTORY_FRAMES ? profile_frame_count : PROFILE_HISTORY_FRAMES;
+    if (count == 0) return (ProfileStats) {0};
+
+    uint64_t sorted[PROFILE_HISTORY_FRAMES];
+    memcpy(sorted, history, count * sizeof(*sorted));
+    qsort(sorted, count, sizeof(*sorted), profile_compare_ns);
+    return (ProfileStats) {
+        .p50_ns = sorted[(count - 1) / 2],
+        .p99_ns = sorted[(count - 1) * 99 / 100],
+    };
+}
+
+ProfileStats profile_zone_stats(ProfileZone zone) {
+    assert(zone < PROFILE_ZONE_COUNT);
+    return profile_stats(profile_zone_history[zone]);
+}
+
+ProfileStats profile_frame_stats(void) {
+    return profile_stats(profile_frame_history);
+}
+
+void profile_frame_times(uint64_t out[PROFILE_HISTORY_FRAMES]) {
+    for (size_t i = 0; i < PROFILE_HISTORY_FRAMES; i++) {
+        out[i] = profile_frame_history[(profile_frame_count + i) % PROFILE_HISTORY_FRAMES];
+    }
+}
+
+uint64_t profile_dropped(void) {
+    return profile_dropped_count;
+}
@@ -0,0 +1,99 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Where the frame time goes. Code between PROFILE_BEGIN(zone) and PROFILE_END(zone) in the same
+// block gets timed on the monotonic clock, in nanoseconds, and the timing goes into a ring buffer
+// of the thread it ran on, so recording never takes a lock. Once a frame profile_frame_end() drains
+// the rings of every thread, adds up what every zone took that frame and keeps the last
+// PROFILE_HISTORY_FRAMES frames around for the debug overlay.
+//
+//     PROFILE_BEGIN(PROFILE_ZONE_UPDATE);
+//     ...
+//     PROFILE_END(PROFILE_ZONE_UPDATE);
+//
+// Zones nest and may run any number of times a frame. Nothing gets recorded until
+// profile_enable(), so headless runs don't pay for the clock.
+//
+// For a closer look than the overlay, profile_trace_begin() writes every zone of the next however
+// many frames to a Chrome trace event file, for chrome://tracing or ui.perfetto.dev. Every thread
+// gets its own track.
+
+// Add new zones here and to profile_zone_names in profiler.c.
+typedef enum {
+    PROFILE_ZONE_INPUT = 0,
+    PROFILE_ZONE_UPDATE,
+    PROFILE_ZONE_TIMERS,
+    PROFILE_ZONE_DRAW_WORLD,
+    PROFILE_ZONE_DRAW_UI,
+    PROFILE_ZONE_END_DRAWING,
+    // Loops of the job system, on whichever thread runs them. Its time in the overlay is added up
+    // over all of them.
+    PROFILE_ZONE_JOB,
+    PROFILE_ZONE_COUNT,
+} ProfileZone;
+
+// Per thread. Drained every frame, so this only has to hold a frame worth of zones.
+#define PROFILE_RING_CAPACITY 4096
+#define PROFILE_MAX_THREADS 64
+#define PROFILE_HISTORY_FRAMES 256
+// What the trace writer fills before it goes to the file. One event takes up about 100 bytes of it.
+#define PROFILE_TRACE_BUFFER_SIZE (1 << 20)
+// 144 FPS.
+#define PROFILE_FRAME_BUDGET_NS (1000000000ull / 144)
+
+typedef struct ProfileEvent {
+    uint64_t begin_ns, end_ns;
+    uint32_t zone;
+    // How many zones it's in on its thread.
+    uint32_t depth;
+} ProfileEvent;
+
+typedef struct ProfileStats {
+    // Over the last PROFILE_HISTORY_FRAMES frames, of the time a frame spent in the zone.
+    uint64_t p50_ns, p99_ns;
+} ProfileStats;
+
+extern bool profile_enabled;
+
+#define PROFILE_BEGIN(zone) const uint64_t profile_begin_##zone = profile_enabled ? profile_begin() : 0
+#define PROFILE_END(zone) do { if (profile_enabled) profile_end((zone), profile_begin_##zone); } while (0)
+
+uint64_t profile_now_ns(void);
+// Only for the macros.
+uint64_t profile_begin(void);
+void profile_end(ProfileZone zone, uint64_t begin_ns);
+
+// Call before the threads that record anything are started.
+void profile_enable(void);
+const char *profile_zone_name(ProfileZone zone);
+// What the thread it's called on is called in traces, before it records anything. Keeps a copy.
+void profile_thread_name(const char *name);
+
+// Once a frame, on the main thread, right after the last zone of it.
+void profile_frame_end(void);
+ProfileStats profile_zone_stats(ProfileZone zone);
+ProfileStats profile_frame_stats(void);
+// Frame times in nanoseconds, oldest first, PROFILE_HISTORY_FRAMES of them. Frames before the
+// first one are 0.
+void profile_frame_times(uint64_t out[PROFILE_HISTORY_FRAMES]);
+// Zones that got overwritten before a frame end came around to them, since the start.
+uint64_t profile_dropped(void);
+
+typedef struct ProfileTraceStats {
+    uint64_t frames, events, bytes;
+} ProfileTraceStats;
+
+// Starts writing the zones every profile_frame_end() drains to `path`, for the next `frames`
+// frames. The events get formatted into a buffer that's allocated once here and only go to the
+// file when it's full, so tracing costs the frames next to nothing.
+bool profile_trace_begin(const char *path, int frames);
+bool profile_tracing(void);
+// Whether the trace got all of its frames and wants profile_trace_end().
+bool profile_trace_full(void);
+// Writes out the rest and closes the file. Fine to call before the trace is full.
+bool profile_trace_end(ProfileTraceStats *stats);
+
+#endif // PROFILER_H_
@@ -0,0 +1,135 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nob.h"
+#include "replay.h"
+
+// These records are written and read as raw memory. If one of these fires you changed the layout,
+// bump REPLAY_VERSION and fix the sizes here.
+static_assert(sizeof(ReplayHeader) == 48, "ReplayHeader layout changed");
+static_assert(sizeof(ReplayRun) == 8, "ReplayRun layout changed");
+
+static bool replay_host_is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t *)&probe == 1;
+}
+
+void replay_begin(Replay *replay, const World *world, int extra_animals) {
+    memset(replay, 0, sizeof(*replay));
+    replay->cols = world->cols;
+    replay->rows = world->rows;
+    replay->extra_animals = extra_animals;
+}
+
+void replay_free(Replay *replay) {
+    free(replay->runs.items);
+    memset(replay, 0, sizeof(*replay));
+}
+
+void replay_record(Replay *replay, Input input) {
+    replay->ticks++;
+
+    if (replay->runs.count > 0) {
+        ReplayRun *last = &replay->runs.items[replay->runs.count - 1];
+        if (last->down == input.down && last->pressed == input.pressed && last->ticks < UINT32_MAX) {
+            last->ticks++;
+            return;
+        }
+    }
+
+    const ReplayRun run = { .down = input.down, .pressed = input.pressed, .ticks = 1 };
+    nob_da_append(&replay->runs, run);
+}
+
+bool replay_save(const Replay *replay, const char *path) {
+    if (!replay_host_is_little_endian()) {
+        fprintf(stderr, "ERROR: replays are little-endian, writing them on this host is not supported\n");
+        return false;
+    }
+
+    const ReplayHeader header = {
+        .magic = REPLAY_MAGIC,
+        .version = REPLAY_VERSION,
+        .cols = replay->cols,
+        .rows = replay->rows,
+        .extra_animals = replay->extra_animals,
+        .ticks = replay->ticks,
+        .hash = replay->hash,
+        .run_count = replay->runs.count,
+    };
+
+    FILE *f = fopen(path, "wb");
+    bool ok = f != NULL
+        && fwrite(&header, sizeof(header), 1, f) == 1
+        && fwrite(replay->runs.items, sizeof(ReplayRun), replay->runs.count, f) == replay->runs.count;
+    if (f != NULL && fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "ERROR: could not write %s: %s\n", path, strerror(errno));
+    return ok;
+}
+
+bool replay_load(Replay *replay, const char *path) {
+    memset(replay, 0, sizeof(*replay));
+
+    if (!replay_host_is_little_endian()) {
+        fprintf(stderr, "ERROR: replays are little-endian, reading them on this host is not supported\n");
+        return false;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    ReplayHeader header;
+    const char *problem = NULL;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) != 0) {
+        problem = "not a replay";
+    } else if (header.version != REPLAY_VERSION) {
+        problem = "replay is from another version of the game";
+    } else if (header.run_count > SIZE_MAX / sizeof(ReplayRun)) {
+        problem = "replay is too big";
+    }
+
+    if (problem == NULL) {
+        replay->runs.capacity = header.run_count;
+        replay->runs.items = malloc(header.run_count > 0 ? header.run_count * sizeof(ReplayRun) : 1);
+        assert(replay->runs.items != NULL && "Buy more RAM lol");
+        if (fread(replay->runs.items, sizeof(ReplayRun), header.run_count, f) != header.run_count) problem = "replay is truncated";
+        replay->runs.count = header.run_count;
+    }
+    fclose(f);
+
+    uint64_t ticks = 0;
+    for (size_t i = 0; problem == NULL && i < replay->runs.count; i++) ticks += replay->runs.items[i].ticks;
+    if (problem == NULL && ticks != header.ticks) problem = "replay runs don't add up to its tick count";
+
+    if (problem != NULL) {
+        fprintf(stderr, "ERROR: could not load %s: %s\n", path, problem);
+        replay_free(replay);
+        return false;
+    }
+
+    replay->cols = header.cols;
+    replay->rows = header.rows;
+    replay->extra_animals = header.extra_animals;
+    replay->ticks = header.ticks;
+    replay->hash = header.hash;
+    return true;
+}
+
+bool replay_next(const Replay *replay, ReplayCursor *cursor, Input *input) {
+    while (cursor->run < replay->runs.count && cursor->tick >= replay->runs.items[cursor->run].ticks) {
+        cursor->run++;
+        cursor->tick = 0;
+    }
+    if (cursor->run >= replay->runs.count) return false;
+
+    const ReplayRun run = replay->runs.items[cursor->run];
+    *input = (Input) { .down = run.down, .pressed = run.pressed };
+    cursor->tick++;
+    return true;
+}
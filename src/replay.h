@@ -0,0 +1,73 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+// Recorded play. world_update() only ever looks at the Input it's handed, so the Input of every
+// tick starting from a fresh world is all it takes to get back to the exact same world later on.
+// That is what a replay is, plus the world_hash() it ended on so playing it back can tell whether
+// it still ends up there:
+//
+//     [ReplayHeader][ReplayRun][ReplayRun]...
+//
+// Input hardly ever changes from one tick to the next, so it's stored run length encoded: a run is
+// the same Input for `ticks` ticks in a row. Presses only last a single tick, a minute of walking
+// around and planting comes out at a few hundred runs.
+//
+// A replay starts from world_init() on a map of the recorded size with `extra_animals` spawned on
+// top, never from a save. All numbers are little-endian, records are raw memory like the map blobs.
+
+#define REPLAY_MAGIC "YAFSREP"
+// Bump whenever the layout of anything below changes, or world_update() does something else with
+// the same input.
+#define REPLAY_VERSION 1
+
+typedef struct ReplayHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t cols, rows;
+    uint32_t extra_animals;
+    // Calls to world_update(), paused ones included.
+    uint64_t ticks;
+    uint64_t hash;
+    uint64_t run_count;
+} ReplayHeader;
+
+typedef struct ReplayRun {
+    uint16_t down, pressed;
+    uint32_t ticks;
+} ReplayRun;
+
+typedef struct Replay {
+    int cols, rows;
+    int extra_animals;
+    uint64_t ticks;
+    // world_hash() after the last tick, set by whoever recorded it.
+    uint64_t hash;
+    struct { ReplayRun *items; size_t count, capacity; } runs;
+} Replay;
+
+// Where playing a replay back is at.
+typedef struct ReplayCursor {
+    size_t run;
+    uint32_t tick;
+} ReplayCursor;
+
+// Starts an empty recording for `world`, which has to be fresh out of world_init() and
+// `extra_animals` spawns.
+void replay_begin(Replay *replay, const World *world, int extra_animals);
+void replay_free(Replay *replay);
+// Appends the input of one more tick.
+void replay_record(Replay *replay, Input input);
+
+bool replay_save(const Replay *replay, const char *path);
+bool replay_load(Replay *replay, const char *path);
+
+// Input of the next tick, false once the replay is over.
+bool replay_next(const Replay *replay, ReplayCursor *cursor, Input *input);
+
+#endif // REPLAY_H_
@@ -0,0 +1,698 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "nob.h"
+#include "save.h"
+
+// These records are written and read as raw memory. If one of these fires you changed the layout,
+// bump SAVE_VERSION and fix the sizes here.
+static_assert(sizeof(SaveHeader) == 24, "SaveHeader layout changed");
+static_assert(sizeof(SaveSection) == 16, "SaveSection layout changed");
+static_assert(sizeof(SaveSnapshot) == 16, "SaveSnapshot layout changed");
+static_assert(sizeof(SaveWorld) == 48, "SaveWorld layout changed");
+static_assert(sizeof(SaveAnimal) == 40, "SaveAnimal layout changed");
+
+// Bytes a chunk section needs per cell, see the CHUNK payload in save.h.
+#define SAVE_CHUNK_CELL_SIZE (sizeof(uint64_t) + sizeof(uint32_t) + sizeof(float) + sizeof(uint8_t))
+
+// CRC32 -------------------------------------------------------------------------------------------
+
+// The usual zlib one, reflected 0xEDB88320.
+static uint32_t save_crc_table[256];
+
+// Called by save_writer_init() and save_load(), before there's a background save that could be
+// reading it.
+static void save_crc_init(void) {
+    if (save_crc_table[1] != 0) return;
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        save_crc_table[i] = c;
+    }
+}
+
+static uint32_t save_crc32(const uint8_t *data, size_t size) {
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) c = save_crc_table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+static bool save_host_is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t *)&probe == 1;
+}
+
+// Chunks ------------------------------------------------------------------------------------------
+
+typedef struct SaveChunkRect {
+    int x0, y0, x1, y1;
+} SaveChunkRect;
+
+static SaveChunkRect save_chunk_rect(const World *world, int chunk_id) {
+    const int cx = chunk_id % world->dirty_chunks.cols;
+    const int cy = chunk_id / world->dirty_chunks.cols;
+    const int x0 = cx * WORLD_CHUNK_CELLS;
+    const int y0 = cy * WORLD_CHUNK_CELLS;
+    return (SaveChunkRect) {
+        x0, y0,
+        x0 + WORLD_CHUNK_CELLS < world->cols ? x0 + WORLD_CHUNK_CELLS : world->cols,
+        y0 + WORLD_CHUNK_CELLS < world->rows ? y0 + WORLD_CHUNK_CELLS : world->rows,
+    };
+}
+
+static size_t save_chunk_cell_count(SaveChunkRect r) {
+    return (size_t)(r.x1 - r.x0) * (r.y1 - r.y0);
+}
+
+// Wet soil changes every tick without anybody marking it, see save_keep_wet_chunks_dirty().
+static bool save_chunk_is_wet(const World *world, SaveChunkRect r) {
+    for (int y = r.y0; y < r.y1; y++) {
+        const float *row = world->moisture.cells + (size_t)y * world->cols;
+        for (int x = r.x0; x < r.x1; x++) {
+            if (row[x] != 0.0f) return true;
+        }
+    }
+    return false;
+}
+
+static void save_clear_dirty_chunks(World *world) {
+    TileMask *mask = &world->dirty_chunks;
+    memset(mask->bits, 0, (size_t)mask->words_per_row * mask->rows * sizeof(uint64_t));
+}
+
+// Nothing marks wet soil as it spreads and dries, so every chunk in `saver->wet_chunks` stays
+// dirty, and so do its neighbours that it can seep into before the next save.
+static void save_keep_wet_chunks_dirty(const SaveWriter *saver, World *world) {
+    TileMask *dirty = &world->dirty_chunks;
+    for (size_t i = 0; i < saver->wet_chunks.count; i++) {
+        const int cx = saver->wet_chunks.items[i] % dirty->cols;
+        const int cy = saver->wet_chunks.items[i] / dirty->cols;
+        for (int y = cy - 1; y <= cy + 1; y++) {
+            for (int x = cx - 1; x <= cx + 1; x++) {
+                if (x >= 0 && y >= 0 && x < dirty->cols && y < dirty->rows) tile_mask_set(dirty, x, y);
+            }
+        }
+    }
+}
+
+// Writing -----------------------------------------------------------------------------------------
+
+void save_writer_init(SaveWriter *saver, const char *path) {
+    memset(saver, 0, sizeof(*saver));
+    saver->path = path;
+    save_crc_init();
+}
+
+void save_writer_free(SaveWriter *saver) {
+    save_wait(saver, NULL);
+    nob_da_free(saver->buffer);
+    nob_da_free(saver->wet_chunks);
+    memset(saver, 0, sizeof(*saver));
+}
+
+// Room for `size` more bytes at the end of the buffer.
+static uint8_t *save_reserve(SaveWriter *saver, size_t size) {
+    if (saver->buffer.count + size > saver->buffer.capacity) {
+        size_t capacity = saver->buffer.capacity == 0 ? NOB_DA_INIT_CAP : saver->buffer.capacity;
+        while (saver->buffer.count + size > capacity) capacity *= 2;
+        saver->buffer.items = realloc(saver->buffer.items, capacity);
+        assert(saver->buffer.items != NULL && "Buy more RAM lol");
+        saver->buffer.capacity = capacity;
+    }
+    uint8_t *at = saver->buffer.items + saver->buffer.count;
+    saver->buffer.count += size;
+    return at;
+}
+
+static void save_put(SaveWriter *saver, const void *data, size_t size) {
+    memcpy(save_reserve(saver, size), data, size);
+}
+
+// Leaves room for the section header, save_section_end() fills its size in once the payload is
+// there.
+static size_t save_section_begin(SaveWriter *saver, SaveSectionType type, uint32_t index) {
+    const size_t at = saver->buffer.count;
+    const SaveSection section = { .type = type, .index = index };
+    save_put(saver, &section, sizeof(section));
+    return at;
+}
+
+// The CRC gets filled in by save_flush().
+static void save_section_end(SaveWriter *saver, size_t at) {
+    SaveSection section;
+    memcpy(&section, saver->buffer.items + at, sizeof(section));
+    section.size = (uint32_t)(saver->buffer.count - at - sizeof(section));
+    memcpy(saver->buffer.items + at, &section, sizeof(section));
+}
+
+// Clips are saved as what they are to the player rather than by id, the ids come from the order
+// of the animation file. NULL past the last kind.
+static const uint16_t *save_player_clips(const PlayerClips *clips, uint32_t which) {
+    switch (which) {
+        case 0: return clips->idle;
+        case 1: return clips->walk;
+        case 2: return clips->run;
+        default: return NULL;
+    }
+}
+
+static uint32_t save_player_clip(const World *world) {
+    const uint16_t *clips;
+    for (uint32_t which = 0; (clips = save_player_clips(&world->player_clips, which)) != NULL; which++) {
+        if (clips[world->player.dir] == world->player_anim.clip) return which;
+    }
+    return 0;
+}
+
+static uint32_t save_tool_swing(const World *world) {
+    if (world->tool_anim.clip == ANIM_CLIP_NONE) return 0;
+    for (uint32_t dir = 0; dir <= RIGHT; dir++) {
+        if (world->player_clips.scythe_swing[dir] == world->tool_anim.clip) return dir + 1;
+    }
+    return 0;
+}
+
+static void save_put_world(SaveWriter *saver, const World *world) {
+    const SaveWorld state = {
+        .tick = world->tick,
+        .rng = world->rng,
+        .animals_rng = world->animals.rng,
+        .player_x = world->player.rect.x,
+        .player_y = world->player.rect.y,
+        .player_dir = world->player.dir,
+        .selected_item = world->inventory.selected_idx,
+        .player_clip = save_player_clip(world),
+        .player_anim_time = world->player_anim.time,
+        .tool_swing = save_tool_swing(world),
+        .tool_anim_time = world->tool_anim.time,
+    };
+    const size_t at = save_section_begin(saver, SAVE_SECTION_WORLD, 0);
+    save_put(saver, &state, sizeof(state));
+    save_section_end(saver, at);
+}
+
+static void save_put_animals(SaveWriter *saver, const World *world) {
+    const Animals *animals = &world->animals;
+    const TransformComponent *transforms = animals->transforms.data;
+    const Entity *entities = animals->transforms.entities;
+
+    const size_t at = save_section_begin(saver, SAVE_SECTION_ANIMALS, 0);
+    uint8_t *out = save_reserve(saver, animals->transforms.count * sizeof(SaveAnimal));
+    for (size_t i = 0; i < animals->transforms.count; i++) {
+        const AnimationComponent *animation = component_get_hint(&animals->animations, entities[i], i);
+        const WanderComponent *wander = component_get_hint(&animals->wanderers, entities[i], i);
+        const SaveAnimal animal = {
+            .wander_due = wander != NULL ? timer_due(animals->timers, wander->timer) : 0,
+            .x = transforms[i].position.x,
+            .y = transforms[i].position.y,
+            .velocity_x = transforms[i].velocity.x,
+            .velocity_y = transforms[i].velocity.y,
+            .kind = animal_kind(animals, entities[i]),
+            .walking = animation->cursor.clip == animation->walk_clip,
+            .anim_time = animation->cursor.time,
+            .wander_rng = wander != NULL ? wander->rng : 0,
+        };
+        memcpy(out + i * sizeof(animal), &animal, sizeof(animal));
+    }
+    save_section_end(saver, at);
+}
+
+static void save_put_chunk(SaveWriter *saver, const World *world, int chunk_id) {
+    const SaveChunkRect r = save_chunk_rect(world, chunk_id);
+    const size_t n = save_chunk_cell_count(r);
+
+    const size_t at = save_section_begin(saver, SAVE_SECTION_CHUNK, (uint32_t)chunk_id);
+    uint8_t *grow_due = save_reserve(saver, n * SAVE_CHUNK_CELL_SIZE);
+    uint8_t *planted_at = grow_due + n * sizeof(uint64_t);
+    uint8_t *moisture = planted_at + n * sizeof(uint32_t);
+    uint8_t *stage = moisture + n * sizeof(float);
+
+    size_t i = 0;
+    for (int y = r.y0; y < r.y1; y++) {
+        const int row = y * world->cols;
+        const size_t width = r.x1 - r.x0;
+        memcpy(planted_at + i * sizeof(uint32_t), world->crops.planted_at + row + r.x0, width * sizeof(uint32_t));
+        memcpy(moisture + i * sizeof(float), world->moisture.cells + row + r.x0, width * sizeof(float));
+        memcpy(stage + i, world->crops.stage + row + r.x0, width);
+        for (int x = r.x0; x < r.x1; x++, i++) {
+            const uint64_t due = timer_due(&world->timers, world->grow_timers[row + x]);
+            memcpy(grow_due + i * sizeof(uint64_t), &due, sizeof(due));
+        }
+    }
+    save_section_end(saver, at);
+}
+
+static void save_put_snapshot_marker(SaveWriter *saver, SaveSectionType type, const World *world, bool full) {
+    const SaveSnapshot snapshot = { .tick = world->tick, .full = full };
+    const size_t at = save_section_begin(saver, type, 0);
+    save_put(saver, &snapshot, sizeof(snapshot));
+    save_section_end(saver, at);
+}
+
+// Makes sure the bytes are on the disk and not just in the OS cache, before the save claims to be
+// done.
+static bool save_sync_file(FILE *f) {
+    if (fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Full snapshots replace the file as a whole, so a crash while writing one leaves the old save be.
+static bool save_replace_file(const char *path, const uint8_t *data, size_t size) {
+    char tmp_path[1024];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        fprintf(stderr, "ERROR: save path %s is too long\n", path);
+        return false;
+    }
+
+    FILE *f = fopen(tmp_path, "wb");
+    bool ok = f != NULL && fwrite(data, 1, size, f) == size && save_sync_file(f);
+    if (f != NULL && fclose(f) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "ERROR: could not write %s: %s\n", tmp_path, strerror(errno));
+        return false;
+    }
+
+#ifdef _WIN32
+    // rename() won't replace an existing file there.
+    remove(path);
+#endif
+    if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "ERROR: could not rename %s to %s: %s\n", tmp_path, path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static bool save_append_file(const char *path, size_t offset, const uint8_t *data, size_t size) {
+    FILE *f = fopen(path, "r+b");
+    bool ok = f != NULL && fseek(f, (long)offset, SEEK_SET) == 0 && fwrite(data, 1, size, f) == size && save_sync_file(f);
+    if (f != NULL && fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "ERROR: could not append to %s: %s\n", path, strerror(errno));
+    return ok;
+}
+
+void save_snapshot(SaveWriter *saver, World *world) {
+    assert(saver->task == NULL && "the last snapshot is still being written");
+
+    const double started_at = sim_monotonic_seconds();
+    const bool full = saver->needs_full || saver->file_size == 0 ||
+        saver->file_size - saver->base_size > SAVE_COMPACT_RATIO * saver->base_size;
+
+    saver->buffer.count = 0;
+    if (full) {
+        const SaveHeader header = {
+            .magic = SAVE_MAGIC,
+            .version = SAVE_VERSION,
+            .cols = world->cols,
+            .rows = world->rows,
+            .chunk_cells = WORLD_CHUNK_CELLS,
+        };
+        save_put(saver, &header, sizeof(header));
+    }
+    save_put_snapshot_marker(saver, SAVE_SECTION_BEGIN, world, full);
+    save_put_world(saver, world);
+    save_put_animals(saver, world);
+
+    const TileMask *dirty = &world->dirty_chunks;
+    const int chunk_count = dirty->cols * dirty->rows;
+    int chunks_written = 0;
+    saver->wet_chunks.count = 0;
+    for (int chunk_id = 0; chunk_id < chunk_count; chunk_id++) {
+        if (!full && !tile_mask_test(dirty, chunk_id % dirty->cols, chunk_id / dirty->cols)) continue;
+
+        save_put_chunk(saver, world, chunk_id);
+        chunks_written++;
+        if (save_chunk_is_wet(world, save_chunk_rect(world, chunk_id))) nob_da_append(&saver->wet_chunks, chunk_id);
+    }
+
+    save_put_snapshot_marker(saver, SAVE_SECTION_END, world, full);
+
+    save_clear_dirty_chunks(world);
+    save_keep_wet_chunks_dirty(saver, world);
+
+    saver->stats = (SaveStats) {
+        .full = full,
+        .chunks_written = chunks_written,
+        .chunk_count = chunk_count,
+        .bytes = saver->buffer.count,
+        .snapshot_seconds = sim_monotonic_seconds() - started_at,
+    };
+}
+
+bool save_flush(SaveWriter *saver) {
+    const double started_at = sim_monotonic_seconds();
+    const bool full = saver->stats.full;
+
+    // The checksums are left to here so the snapshot is nothing but copying.
+    size_t offset = full ? sizeof(SaveHeader) : 0;
+    while (offset < saver->buffer.count) {
+        SaveSection section;
+        memcpy(&section, saver->buffer.items + offset, sizeof(section));
+        section.crc = save_crc32(saver->buffer.items + offset + sizeof(section), section.size);
+        memcpy(saver->buffer.items + offset, &section, sizeof(section));
+        offset += sizeof(section) + section.size;
+    }
+
+    const bool ok = full
+        ? save_replace_file(saver->path, saver->buffer.items, saver->buffer.count)
+        : save_append_file(saver->path, saver->file_size, saver->buffer.items, saver->buffer.count);
+    if (!ok) {
+        // Whatever is on disk now, it can't be trusted to append to.
+        saver->needs_full = true;
+    } else if (full) {
+        saver->base_size = saver->buffer.count;
+        saver->file_size = saver->buffer.count;
+        saver->needs_full = false;
+    } else {
+        saver->file_size += saver->buffer.count;
+    }
+
+    saver->stats.ok = ok;
+    saver->stats.write_seconds = sim_monotonic_seconds() - started_at;
+    return ok;
+}
+
+bool save_write(SaveWriter *saver, World *world, SaveStats *stats) {
+    if (!save_host_is_little_endian()) {
+        fprintf(stderr, "ERROR: saves are little-endian, writing them on this host is not supported\n");
+        return false;
+    }
+
+    save_wait(saver, NULL);
+    save_snapshot(saver, world);
+    const bool ok = save_flush(saver);
+    if (stats != NULL) *stats = saver->stats;
+    return ok;
+}
+
+// Background --------------------------------------------------------------------------------------
+
+static void save_flush_task(void *ctx) {
+    save_flush(ctx);
+}
+
+bool save_write_async(SaveWriter *saver, World *world) {
+    if (!save_host_is_little_endian()) {
+        fprintf(stderr, "ERROR: saves are little-endian, writing them on this host is not supported\n");
+        return false;
+    }
+    if (saver->task != NULL) return false;
+
+    save_snapshot(saver, world);
+    saver->task = job_task_start(save_flush_task, saver);
+    return true;
+}
+
+bool save_poll(SaveWriter *saver, SaveStats *stats) {
+    if (saver->task == NULL || !job_task_done(saver->task)) return false;
+
+    job_task_wait(saver->task);
+    saver->task = NULL;
+    if (stats != NULL) *stats = saver->stats;
+    return true;
+}
+
+bool save_wait(SaveWriter *saver, SaveStats *stats) {
+    if (saver->task == NULL) return false;
+
+    job_task_wait(saver->task);
+    saver->task = NULL;
+    if (stats != NULL) *stats = saver->stats;
+    return true;
+}
+
+// Loading -----------------------------------------------------------------------------------------
+
+// Sections of one snapshot, pointing into the file contents.
+typedef struct SaveSnapshotView {
+    const uint8_t *world;
+    const uint8_t *animals;
+    size_t animal_count;
+    // Indexed by chunk id, NULL where the snapshot doesn't have that chunk.
+    const uint8_t **chunks;
+} SaveSnapshotView;
+
+static bool save_read_file(const char *path, uint8_t **data, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    bool ok = fseek(f, 0, SEEK_END) == 0;
+    const long length = ok ? ftell(f) : -1;
+    ok = ok && length >= 0 && fseek(f, 0, SEEK_SET) == 0;
+    if (ok) {
+        *size = (size_t)length;
+        *data = malloc(*size > 0 ? *size : 1);
+        assert(*data != NULL && "Buy more RAM lol");
+        ok = fread(*data, 1, *size, f) == *size;
+        if (!ok) free(*data);
+    }
+    if (!ok) fprintf(stderr, "ERROR: could not read %s: %s\n", path, strerror(errno));
+    fclose(f);
+    return ok;
+}
+
+static void save_restore_animals(World *world, const uint8_t *data, size_t count) {
+    Animals *animals = &world->animals;
+    for (size_t i = 0; i < count; i++) {
+        SaveAnimal saved;
+        memcpy(&saved, data + i * sizeof(saved), sizeof(saved));
+        if (saved.kind >= ANIMAL_KIND_COUNT) {
+            fprintf(stderr, "WARNING: skipping a saved animal of unknown kind %u\n", saved.kind);
+            continue;
+        }
+
+        const Entity entity = animal_spawn(animals, (AnimalKind)saved.kind, (Vector2) { saved.x, saved.y });
+        TransformComponent *transform = component_get(&animals->transforms, entity);
+        transform->velocity = (Vector2) { saved.velocity_x, saved.velocity_y };
+
+        AnimationComponent *animation = component_get(&animals->animations, entity);
+        anim_restart(&animation->cursor, saved.walking ? animation->walk_clip : animation->idle_clip);
+        anim_advance(animals->clips, &animation->cursor, saved.anim_time);
+        SpriteComponent *sprite = component_get(&animals->sprites, entity);
+        sprite->src = anim_sample(animals->clips, animation->cursor);
+
+        WanderComponent *wander = component_get(&animals->wanderers, entity);
+        if (saved.wander_rng != 0) wander->rng = saved.wander_rng;
+        if (saved.wander_due != 0) animal_schedule_wander(animals, entity, saved.wander_due);
+    }
+}
+
+static void save_restore_chunk(World *world, int chunk_id, const uint8_t *data) {
+    const SaveChunkRect r = save_chunk_rect(world, chunk_id);
+    const size_t n = save_chunk_cell_count(r);
+    const uint8_t *grow_due = data;
+    const uint8_t *planted_at = grow_due + n * sizeof(uint64_t);
+    const uint8_t *moisture = planted_at + n * sizeof(uint32_t);
+    const uint8_t *stage = moisture + n * sizeof(float);
+
+    size_t i = 0;
+    for (int y = r.y0; y < r.y1; y++) {
+        for (int x = r.x0; x < r.x1; x++, i++) {
+            const int id = x + y * world->cols;
+            uint64_t due;
+            uint32_t planted;
+            memcpy(&due, grow_due + i * sizeof(due), sizeof(due));
+            memcpy(&planted, planted_at + i * sizeof(planted), sizeof(planted));
+            memcpy(&world->moisture.cells[id], moisture + i * sizeof(float), sizeof(float));
+            world_restore_crop(world, id, planted, stage[i], due);
+        }
+    }
+}
+
+static void save_restore(SaveWriter *saver, World *world, const SaveSnapshotView *view, int chunk_count) {
+    SaveWorld state;
+    memcpy(&state, view->world, sizeof(state));
+
+    // Out with whatever world_init() put there, the timers start over at the saved tick.
+    while (world->animals.transforms.count > 0) {
+        animal_despawn(&world->animals, world->animals.transforms.entities[0]);
+    }
+    timer_wheel_free(&world->timers);
+    timer_wheel_init(&world->timers, state.tick);
+    memset(world->grow_timers, 0, (size_t)world->cols * world->rows * sizeof(TimerId));
+    world->wheat_float_timer = 0;
+    world->scythe_swing_timer = 0;
+
+    world->tick = state.tick;
+    world->time = state.tick * SIM_DT;
+    world->player.rect.x = state.player_x;
+    world->player.rect.y = state.player_y;
+    world->player.dir = state.player_dir <= RIGHT ? (Direction)state.player_dir : DOWN;
+    const uint16_t *player_clips = save_player_clips(&world->player_clips, state.player_clip);
+    if (player_clips == NULL) player_clips = world->player_clips.idle;
+    anim_restart(&world->player_anim, player_clips[world->player.dir]);
+    anim_advance(world->clips, &world->player_anim, state.player_anim_time);
+    const bool swinging = state.tool_swing >= 1 && state.tool_swing <= RIGHT + 1;
+    anim_restart(&world->tool_anim, swinging ? world->player_clips.scythe_swing[state.tool_swing - 1] : ANIM_CLIP_NONE);
+    anim_advance(world->clips, &world->tool_anim, state.tool_anim_time);
+    if (state.selected_item >= 0 && state.selected_item < INVENTORY_CAPACITY) {
+        world->inventory.selected_idx = state.selected_item;
+    }
+
+    save_restore_animals(world, view->animals, view->animal_count);
+    for (int chunk_id = 0; chunk_id < chunk_count; chunk_id++) {
+        if (view->chunks[chunk_id] != NULL) save_restore_chunk(world, chunk_id, view->chunks[chunk_id]);
+    }
+
+    // Spawning drew from the rngs, put them back last.
+    world->rng = state.rng;
+    world->animals.rng = state.animals_rng;
+
+    // The loaded soil keeps drying from here on, the next save can't skip it.
+    save_clear_dirty_chunks(world);
+    saver->wet_chunks.count = 0;
+    for (int chunk_id = 0; chunk_id < chunk_count; chunk_id++) {
+        if (save_chunk_is_wet(world, save_chunk_rect(world, chunk_id))) nob_da_append(&saver->wet_chunks, chunk_id);
+    }
+    save_keep_wet_chunks_dirty(saver, world);
+}
+
+bool save_load(SaveWriter *saver, World *world) {
+    save_crc_init();
+
+    uint8_t *data = NULL;
+    size_t size = 0;
+    if (!save_read_file(saver->path, &data, &size)) return false;
+
+    const int chunk_count = world->dirty_chunks.cols * world->dirty_chunks.rows;
+    SaveSnapshotView latest = { .chunks = calloc(chunk_count, sizeof(uint8_t *)) };
+    SaveSnapshotView pending = { .chunks = calloc(chunk_count, sizeof(uint8_t *)) };
+    assert(latest.chunks != NULL && pending.chunks != NULL && "Buy more RAM lol");
+
+    SaveHeader header = { 0 };
+    if (size >= sizeof(header)) memcpy(&header, data, sizeof(header));
+
+    const char *problem = NULL;
+    if (size < sizeof(header) || memcmp(header.magic, SAVE_MAGIC, sizeof(header.magic)) != 0) {
+        problem = "not a save file";
+    } else if (header.version != SAVE_VERSION) {
+        problem = "save is from another version of the game";
+    } else if (header.cols != (uint32_t)world->cols || header.rows != (uint32_t)world->rows || header.chunk_cells != WORLD_CHUNK_CELLS) {
+        problem = "save is of a map of another size";
+    }
+
+    // Walk the sections, a snapshot moves from `pending` to `latest` once its END checks out. The
+    // first section that doesn't is where the file stops making sense, everything after it goes.
+    size_t offset = sizeof(header);
+    size_t valid_size = 0, base_size = 0;
+    bool in_snapshot = false;
+    SaveSnapshot begin = { 0 };
+    const char *torn = NULL;
+    while (problem == NULL && torn == NULL && offset < size) {
+        SaveSection section;
+        if (size - offset < sizeof(section)) {
+            torn = "truncated section header";
+            break;
+        }
+        memcpy(&section, data + offset, sizeof(section));
+        const uint8_t *payload = data + offset + sizeof(section);
+        if (section.size > size - offset - sizeof(section)) {
+            torn = "truncated section";
+            break;
+        }
+        if (save_crc32(payload, section.size) != section.crc) {
+            torn = "checksum mismatch";
+            break;
+        }
+        offset += sizeof(section) + section.size;
+
+        if (section.type == SAVE_SECTION_BEGIN) {
+            if (section.size != sizeof(SaveSnapshot)) {
+                torn = "bad snapshot marker";
+                break;
+            }
+            memcpy(&begin, payload, sizeof(begin));
+            memset(pending.chunks, 0, chunk_count * sizeof(uint8_t *));
+            pending.world = NULL;
+            pending.animals = NULL;
+            pending.animal_count = 0;
+            in_snapshot = true;
+            continue;
+        }
+        if (!in_snapshot) {
+            torn = "section outside of a snapshot";
+            break;
+        }
+
+        switch (section.type) {
+            case SAVE_SECTION_WORLD: {
+                if (section.size != sizeof(SaveWorld)) torn = "bad world section";
+                pending.world = payload;
+            } break;
+            case SAVE_SECTION_ANIMALS: {
+                if (section.size % sizeof(SaveAnimal) != 0) torn = "bad animals section";
+                pending.animals = payload;
+                pending.animal_count = section.size / sizeof(SaveAnimal);
+            } break;
+            case SAVE_SECTION_CHUNK: {
+                if (section.index >= (uint32_t)chunk_count ||
+                    section.size != save_chunk_cell_count(save_chunk_rect(world, section.index)) * SAVE_CHUNK_CELL_SIZE) {
+                    torn = "bad chunk section";
+                    break;
+                }
+                pending.chunks[section.index] = payload;
+            } break;
+            case SAVE_SECTION_END: {
+                SaveSnapshot end = { 0 };
+                if (section.size == sizeof(end)) memcpy(&end, payload, sizeof(end));
+                if (section.size != sizeof(end) || end.tick != begin.tick || pending.world == NULL || pending.animals == NULL) {
+                    torn = "incomplete snapshot";
+                    break;
+                }
+                if (latest.world == NULL && !end.full) {
+                    torn = "save does not start with a full snapshot";
+                    break;
+                }
+
+                latest.world = pending.world;
+                latest.animals = pending.animals;
+                latest.animal_count = pending.animal_count;
+                for (int i = 0; i < chunk_count; i++) {
+                    if (pending.chunks[i] != NULL) latest.chunks[i] = pending.chunks[i];
+                }
+                valid_size = offset;
+                if (end.full) base_size = offset;
+                in_snapshot = false;
+            } break;
+            default: {
+                torn = "unknown section";
+            } break;
+        }
+    }
+    if (problem == NULL && torn == NULL && in_snapshot) torn = "unfinished snapshot";
+    if (problem == NULL && latest.world == NULL) problem = torn != NULL ? torn : "save has no snapshots";
+
+    if (problem != NULL) {
+        fprintf(stderr, "ERROR: could not load %s: %s\n", saver->path, problem);
+    } else {
+        if (torn != NULL) {
+            fprintf(stderr, "WARNING: %s: %s at byte %zu, dropping everything from there on\n", saver->path, torn, valid_size);
+        }
+        save_restore(saver, world, &latest, chunk_count);
+        saver->file_size = valid_size;
+        saver->base_size = base_size;
+        // Appending after the garbage would leave the new snapshots unreachable.
+        saver->needs_full = torn != NULL;
+    }
+
+    free(latest.chunks);
+    free(pending.chunks);
+    free(data);
+    return problem == NULL;
+}
@@ -0,0 +1,159 @@
+#ifndef SAVE_H_
+#define SAVE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+// Saved games. A save file is a header followed by snapshots of the world, each a run of sections:
+//
+//     [SaveHeader]
+//     [BEGIN][WORLD][ANIMALS][CHUNK][CHUNK]...[END]    full, every chunk of the map
+//     [BEGIN][WORLD][ANIMALS][CHUNK]...[END]           incremental, only the chunks that changed
+//     ...
+//
+// Every section starts with a SaveSection holding its type, the size of the payload after it and a
+// CRC32 of that payload. A chunk is one WORLD_CHUNK_CELLS square of the map: the crops on it, when
+// they grow next and how wet the soil is. Loading plays the snapshots back in order and the newest
+// copy of every chunk wins. A snapshot only counts once its END made it to disk, so a crash halfway
+// through writing one loses that snapshot and nothing else.
+//
+// Which chunks changed comes from `World.dirty_chunks`. Incremental snapshots are appended to the
+// file in a single write, full ones go to a temporary file that then gets renamed over the save,
+// either way the file is synced to disk before the save counts as done. Once the increments add up
+// to more than SAVE_COMPACT_RATIO times the full snapshot they started from, the next save is a
+// full one again.
+//
+// Saving is split in two so the game never waits on the disk: save_snapshot() copies the state
+// into a buffer of the writer's, the world is free to go on right after, and save_flush() does the
+// checksums and the IO, on a thread of its own when it goes through save_write_async().
+//
+// All numbers are little-endian, records are written as raw memory like the map blobs are.
+
+#define SAVE_PATH "yafs.save"
+#define SAVE_MAGIC "YAFSSAV"
+// Bump whenever the layout of anything below changes.
+#define SAVE_VERSION 3
+#define SAVE_COMPACT_RATIO 2
+
+typedef enum {
+    SAVE_SECTION_BEGIN = 1,
+    SAVE_SECTION_WORLD,
+    SAVE_SECTION_ANIMALS,
+    SAVE_SECTION_CHUNK,
+    SAVE_SECTION_END,
+} SaveSectionType;
+
+typedef struct SaveHeader {
+    char magic[8];
+    uint32_t version;
+    // A save only loads into a world made from a map of the same size.
+    uint32_t cols, rows;
+    uint32_t chunk_cells;
+} SaveHeader;
+
+typedef struct SaveSection {
+    uint32_t type;
+    // Chunk id (`x + y * chunk columns`) for chunks, 0 for everything else.
+    uint32_t index;
+    uint32_t size;
+    uint32_t crc;
+} SaveSection;
+
+// Payload of BEGIN and END, they have to match.
+typedef struct SaveSnapshot {
+    uint64_t tick;
+    uint32_t full;
+    uint32_t reserved;
+} SaveSnapshot;
+
+typedef struct SaveWorld {
+    uint64_t tick;
+    uint32_t rng, animals_rng;
+    float player_x, player_y;
+    uint32_t player_dir;
+    int32_t selected_item;
+    // Which of its idle, walk and run clips the player was playing (0, 1, 2), and how far into it.
+    uint32_t player_clip;
+    uint32_t player_anim_time;
+    // Direction of the scythe swing the tool was playing plus one, 0 for none, and how far into it.
+    uint32_t tool_swing;
+    uint32_t tool_anim_time;
+} SaveWorld;
+
+// ANIMALS is an array of these in dense component order.
+typedef struct SaveAnimal {
+    // Tick of the next wander turn.
+    uint64_t wander_due;
+    float x, y;
+    float velocity_x, velocity_y;
+    uint32_t kind;
+    // Whether it was playing its walk clip rather than its idle one, and how far into it.
+    uint32_t walking;
+    uint32_t anim_time;
+    // State of its wander xorshift, 0 for none.
+    uint32_t wander_rng;
+} SaveAnimal;
+
+// CHUNK payload, for the n cells of the chunk in row major order (fewer than a full square at the
+// right and bottom edges of the map): uint64_t grow_due[n], uint32_t planted_at[n],
+// float moisture[n], uint8_t stage[n]. `grow_due` is the tick of the next stage, 0 for none.
+
+typedef struct SaveStats {
+    bool full;
+    int chunks_written, chunk_count;
+    size_t bytes;
+    // Time the world was held up copying the snapshot, and time spent checksumming, writing and
+    // syncing it, which may have been on another thread.
+    double snapshot_seconds;
+    double write_seconds;
+    bool ok;
+} SaveStats;
+
+typedef struct SaveWriter {
+    const char *path;
+    // How much of the file on disk is valid, and how much of that is the full snapshot it starts
+    // with. 0 when there's no file yet.
+    size_t file_size, base_size;
+    // Set when the file can't be appended to, say after a failed write.
+    bool needs_full;
+    // Scratch the snapshot is put together in before it's written out in one go.
+    struct { uint8_t *items; size_t count, capacity; } buffer;
+    struct { int *items; size_t count, capacity; } wet_chunks;
+    // Writing the snapshot in `buffer` in the background, NULL when there's none in flight.
+    JobTask *task;
+    // Of the last snapshot, whichever thread wrote it.
+    SaveStats stats;
+} SaveWriter;
+
+void save_writer_init(SaveWriter *saver, const char *path);
+void save_writer_free(SaveWriter *saver);
+
+// Copies what needs saving out of `world` into the writer's buffer and clears its dirty chunks. This
+// is the only part of saving that has to stop the world.
+void save_snapshot(SaveWriter *saver, World *world);
+// Checksums the snapshot and writes it out. Never looks at the world, so it's fine for that to keep
+// ticking meanwhile on another thread.
+bool save_flush(SaveWriter *saver);
+
+// Snapshot and flush right here. Waits for a background save first if there is one. `stats` may be
+// NULL.
+bool save_write(SaveWriter *saver, World *world, SaveStats *stats);
+
+// Takes the snapshot here and leaves the flush to a thread of its own, so the caller only pays for
+// the copy. Returns false without doing anything while the previous one is still being written,
+// the dirty chunks just wait for the next try then. Don't touch `saver` until save_poll() or
+// save_wait() say it's done.
+bool save_write_async(SaveWriter *saver, World *world);
+// True once, when the background save finished, with `stats` (may be NULL) filled in.
+bool save_poll(SaveWriter *saver, SaveStats *stats);
+// Blocks until the background save finished, same return value as save_poll().
+bool save_wait(SaveWriter *saver, SaveStats *stats);
+
+// Restores the newest complete snapshot of the save into a `world` fresh out of world_init(), and
+// has `saver` append to that file from then on. Must not be in the middle of a background save.
+bool save_load(SaveWriter *saver, World *world);
+
+#endif // SAVE_H_
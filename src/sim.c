@@ -0,0 +1,647 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <raylib.h>
+#include <raymath.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "sim.h"
+#include "profiler.h"
+
+static_assert(CROP_TICKS_PER_STAGE == SIM_TICKS_PER_SECOND, "crops are supposed to grow a stage per second");
+
+// How many cows a fresh world starts out with, on top of the chicken.
+#define WORLD_INIT_COWS 2
+
+// Clock -------------------------------------------------------------------------------------------
+
+double sim_monotonic_seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+FixedStep fixed_step_create(double (*now)(void)) {
+    return (FixedStep) {
+        .now = now,
+        .previous = now(),
+        .accumulator = 0.0,
+    };
+}
+
+int fixed_step_begin_frame(FixedStep *step) {
+    const double now = step->now();
+    step->accumulator += now - step->previous;
+    step->previous = now;
+
+    int ticks = 0;
+    while (step->accumulator >= SIM_DT && ticks < SIM_MAX_TICKS_PER_FRAME) {
+        step->accumulator -= SIM_DT;
+        ticks++;
+    }
+
+    // We hit the cap, drop the backlog on the floor instead of carrying it into the next frame.
+    if (ticks == SIM_MAX_TICKS_PER_FRAME) step->accumulator = 0.0;
+
+    return ticks;
+}
+
+// Cells -------------------------------------------------------------------------------------------
+
+Vector2 get_character_pos(Character player) {
+    return (Vector2) {
+        player.rect.x + (player.rect.width / 2),
+        // The feet are closer to the bottom of the sprite than the middle. So only chop off a
+        // quarter of the sprite, not half like a first impression may elicit.
+        player.rect.y + player.rect.height - (player.rect.height / 4),
+    };
+}
+
+Rectangle get_character_cell_rect(Character player) {
+    return (Rectangle) {
+        get_character_pos(player).x - (float)((int)get_character_pos(player).x % (int)(MAP_CELL_SIZE * MAP_SCALE)),
+        get_character_pos(player).y - (float)((int)get_character_pos(player).y % (int)(MAP_CELL_SIZE * MAP_SCALE)),
+        MAP_CELL_SIZE * MAP_SCALE,
+        MAP_CELL_SIZE * MAP_SCALE,
+    };
+}
+
+Rectangle get_cell_rect_character_is_facing(Character player) {
+    Rectangle result = get_character_cell_rect(player);
+
+    switch (player.dir) {
+        case UP: {
+            result.y -= (MAP_CELL_SIZE * MAP_SCALE);
+            break;
+        }
+        case DOWN: {
+            result.y += (MAP_CELL_SIZE * MAP_SCALE);
+            break;
+        }
+        case LEFT: {
+            result.x -= (MAP_CELL_SIZE * MAP_SCALE);
+            break;
+        }
+        case RIGHT: {
+            result.x += (MAP_CELL_SIZE * MAP_SCALE);
+            break;
+        }
+    }
+
+    return result;
+}
+
+Cell get_cell_player_is_facing(Character player) {
+    const Rectangle facing_cell_rect = get_cell_rect_character_is_facing(player);
+    const Cell result = {
+        .x = (int)facing_cell_rect.x / (int)(MAP_CELL_SIZE * MAP_SCALE),
+        .y = (int)facing_cell_rect.y / (int)(MAP_CELL_SIZE * MAP_SCALE),
+    };
+    return result;
+}
+
+int get_cell_id_player_is_facing(const World *world, Character player) {
+    const Rectangle facing_cell_rect = get_cell_rect_character_is_facing(player);
+    if (facing_cell_rect.x < 0 || facing_cell_rect.y < 0) return -1;
+
+    const Cell facing_cell = get_cell_player_is_facing(player);
+    if (!is_cell_in_area(facing_cell, (Cell) { 0, 0 }, world->cols, world->rows)) return -1;
+
+    return cell_to_cell_id(world, facing_cell);
+}
+
+bool is_cell_in_area(Cell needle, Cell haystack, int cols, int rows) {
+    if (cols == 0 || rows == 0) return false;
+    if (needle.x < haystack.x || needle.y < haystack.y) return false;
+    if (needle.x >= haystack.x + cols) return false;
+    if (needle.y >= haystack.y + rows) return false;
+
+    return true;
+}
+
+Cell cell_id_to_cell(const World *world, const int cell_id) {
+    return world->cells[cell_id];
+}
+
+int cell_to_cell_id(const World *world, const Cell cell) {
+    return cell.x + (cell.y * world->cols);
+}
+
+bool player_is_facing_farmable_cell(const World *world, Character player) {
+    return tile_mask_test_id(&world->farmable, get_cell_id_player_is_facing(world, player));
+}
+
+void world_refresh_active_cell(World *world, int cell_id) {
+    tile_mask_set(&world->dirty_chunks, (cell_id % world->cols) / WORLD_CHUNK_CELLS, (cell_id / world->cols) / WORLD_CHUNK_CELLS);
+
+    const bool is_active = crop_is_planted(&world->crops, cell_id);
+    const int slot = world->active_cell_slots[cell_id];
+
+    if (is_active && slot < 0) {
+        world->active_cell_slots[cell_id] = world->active_cell_count;
+        world->active_cells[world->active_cell_count++] = cell_id;
+    } else if (!is_active && slot >= 0) {
+        // Swap the last active cell into the hole so the list stays dense.
+        const int last_id = world->active_cells[--world->active_cell_count];
+        world->active_cells[slot] = last_id;
+        world->active_cell_slots[last_id] = slot;
+        world->active_cell_slots[cell_id] = -1;
+    }
+}
+
+// Like get_cell_player_is_facing(), but also right for the cells past the top and left of the map,
+// which go negative.
+static Cell world_cell_player_is_facing(Character player) {
+    const float cell_size = MAP_CELL_SIZE * MAP_SCALE;
+    const Vector2 feet = get_character_pos(player);
+    Cell cell = { (int)floorf(feet.x / cell_size), (int)floorf(feet.y / cell_size) };
+    switch (player.dir) {
+        case UP:    cell.y--; break;
+        case DOWN:  cell.y++; break;
+        case LEFT:  cell.x--; break;
+        case RIGHT: cell.x++; break;
+    }
+    return cell;
+}
+
+// Off the map the tool digs up grass into dirt, the edges around it follow along.
+static void world_till_off_map(World *world, Character player) {
+    const Cell cell = world_cell_player_is_facing(player);
+    if (!(pages_cell_flags(&world->pages, cell.x, cell.y) & TMX_TILE_TILLABLE)) return;
+    pages_set_terrain(&world->pages, cell.x, cell.y, TERRAIN_DIRT, true);
+}
+
+// World -------------------------------------------------------------------------------------------
+
+static uint8_t map_cell_tile_flags(const TmxMap *map, int cell_id) {
+    // Whatever is drawn on top decides, grass painted over water is walkable.
+    for (size_t l = map->layers.count; l > 0; l--) {
+        const uint16_t gid = map->layers.items[l - 1].gids[cell_id];
+        if (gid != 0) return tmx_tile_flags(map, gid);
+    }
+    return 0;
+}
+
+static void world_init_tile_masks(World *world, const TmxMap *map) {
+    tile_mask_init(&world->solid, world->cols, world->rows);
+    tile_mask_init(&world->water, world->cols, world->rows);
+    tile_mask_init(&world->farmable, world->cols, world->rows);
+    tile_mask_init(&world->tillable, world->cols, world->rows);
+
+    for (int y = 0; y < world->rows; y++) {
+        for (int x = 0; x < world->cols; x++) {
+            const uint8_t flags = map_cell_tile_flags(map, x + y * world->cols);
+            if (flags & TMX_TILE_SOLID)    tile_mask_set(&world->solid, x, y);
+            if (flags & TMX_TILE_WATER)    tile_mask_set(&world->water, x, y);
+            if (flags & TMX_TILE_FARMABLE) tile_mask_set(&world->farmable, x, y);
+            if (flags & TMX_TILE_TILLABLE) tile_mask_set(&world->tillable, x, y);
+        }
+    }
+}
+
+// Needs the tile masks.
+static void world_init_collision(World *world, const TmxMap *map) {
+    const float cell_size = MAP_CELL_SIZE * MAP_SCALE;
+    collision_world_init(&world->collision, world->cols, world->rows, cell_size);
+
+    const int collision_group = tmx_find_object_group(map, MAP_COLLISION_GROUP);
+    for (size_t i = 0; i < map->objects.count; i++) {
+        const TmxObject object = map->objects.items[i];
+        if ((int)object.group != collision_group) continue;
+
+        collision_world_add(&world->collision, (Rectangle) {
+            .x = object.x * MAP_SCALE,
+            .y = object.y * MAP_SCALE,
+            .width = object.width * MAP_SCALE,
+            .height = object.height * MAP_SCALE,
+        });
+    }
+
+    // Solid tiles, merged into one rect per horizontal run so a lake isn't hundreds of rects.
+    for (int y = 0; y < world->rows; y++) {
+        int x = 0;
+        while (x < world->cols) {
+            if (!tile_mask_test(&world->solid, x, y)) {
+                x++;
+                continue;
+            }
+
+            const int run_start = x;
+            while (x < world->cols && tile_mask_test(&world->solid, x, y)) x++;
+
+            collision_world_add(&world->collision, (Rectangle) {
+                .x = run_start * cell_size,
+                .y = y * cell_size,
+                .width = (x - run_start) * cell_size,
+                .height = cell_size,
+            });
+        }
+    }
+
+    collision_world_build(&world->collision);
+}
+
+static uint32_t sim_xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Timers ------------------------------------------------------------------------------------------
+
+// How long the next stage takes is decided by how wet the soil is when the stage starts.
+static void on_crop_grow(void *ctx, uint32_t cell_id, uint64_t now) {
+    World *world = ctx;
+    world->grow_timers[cell_id] = 0;
+    if (crop_grow(&world->crops, cell_id)) {
+        const uint32_t ticks = crop_stage_ticks(moisture_get(&world->moisture, cell_id));
+        world->grow_timers[cell_id] = timer_schedule(&world->timers, now + ticks, on_crop_grow, world, cell_id);
+    }
+    world_refresh_active_cell(world, cell_id);
+}
+
+void world_restore_crop(World *world, int cell_id, uint32_t planted_at, uint8_t stage, uint64_t grow_due) {
+    timer_cancel(&world->timers, world->grow_timers[cell_id]);
+    world->grow_timers[cell_id] = 0;
+
+    world->crops.planted_at[cell_id] = planted_at;
+    world->crops.stage[cell_id] = planted_at != 0 ? stage : CROP_STAGE_NONE;
+    if (planted_at != 0 && grow_due != 0) {
+        world->grow_timers[cell_id] = timer_schedule(&world->timers, grow_due, on_crop_grow, world, cell_id);
+    }
+    world_refresh_active_cell(world, cell_id);
+}
+
+static void on_wheat_float_over(void *ctx, uint32_t data, uint64_t now) {
+    (void)data;
+    (void)now;
+    World *world = ctx;
+    world->wheat_float_timer = 0;
+    world->player.wheat_harvested_at = 0;
+}
+
+static void on_scythe_swing_over(void *ctx, uint32_t data, uint64_t now) {
+    (void)data;
+    (void)now;
+    World *world = ctx;
+    world->scythe_swing_timer = 0;
+    world->player.swung_scythe_at = 0;
+}
+
+static uint16_t world_find_clip(const AnimLibrary *clips, const char *name) {
+    const uint16_t clip = anim_find_clip(clips, name);
+    if (clip == ANIM_CLIP_NONE) TraceLog(LOG_FATAL, "animation clip %s is missing from %s", name, ANIM_CLIPS_PATH);
+    return clip;
+}
+
+static void world_init_player_clips(World *world) {
+    static const char *directions[] = { [UP] = "up", [DOWN] = "down", [LEFT] = "left", [RIGHT] = "right" };
+
+    PlayerClips *clips = &world->player_clips;
+    for (int dir = 0; dir < 4; dir++) {
+        clips->idle[dir] = world_find_clip(world->clips, TextFormat("player_idle_%s", directions[dir]));
+        clips->walk[dir] = world_find_clip(world->clips, TextFormat("player_walk_%s", directions[dir]));
+        clips->run[dir] = world_find_clip(world->clips, TextFormat("player_run_%s", directions[dir]));
+        clips->scythe_swing[dir] = dir == UP ? ANIM_CLIP_NONE : world_find_clip(world->clips, TextFormat("scythe_swing_%s", directions[dir]));
+    }
+
+    anim_restart(&world->player_anim, clips->idle[world->player.dir]);
+    anim_restart(&world->tool_anim, ANIM_CLIP_NONE);
+}
+
+void world_init(World *world, const TmxMap *map, const AnimLibrary *clips, JobSystem *jobs) {
+    assert(map->tilewidth == MAP_CELL_SIZE && map->tileheight == MAP_CELL_SIZE);
+
+    memset(world, 0, sizeof(*world));
+
+    world->jobs = jobs;
+    world->game_state = (GameState) {
+        .debug_mode = false,
+        .paused = false,
+    };
+
+    world->map = map;
+    world->clips = clips;
+    world->cols = map->width;
+    world->rows = map->height;
+    world->width = world->cols * MAP_CELL_SIZE * MAP_SCALE;
+    world->height = world->rows * MAP_CELL_SIZE * MAP_SCALE;
+
+    const int cell_count = world->cols * world->rows;
+    world->cells = malloc(cell_count * sizeof(Cell));
+    world->active_cells = malloc(cell_count * sizeof(int));
+    world->active_cell_slots = malloc(cell_count * sizeof(int));
+    world->grow_timers = calloc(cell_count, sizeof(TimerId));
+    assert(world->cells != NULL && world->active_cells != NULL && world->active_cell_slots != NULL && "Buy more RAM lol");
+    assert(world->grow_timers != NULL && "Buy more RAM lol");
+
+    for (int i = 0; i < cell_count; i++) {
+        world->cells[i] = (Cell) {
+            .x = (i % world->cols) * MAP_CELL_SIZE * MAP_SCALE,
+            .y = (i / world->cols) * MAP_CELL_SIZE * MAP_SCALE,
+        };
+        world->active_cell_slots[i] = -1;
+    }
+    world->active_cell_count = 0;
+
+    world->crops = crop_store_create(cell_count);
+    moisture_field_init(&world->moisture, world->cols, world->rows, SOIL_DIFFUSION, SOIL_EVAPORATION);
+    tile_mask_init(&world->dirty_chunks,
+        (world->cols + WORLD_CHUNK_CELLS - 1) / WORLD_CHUNK_CELLS,
+        (world->rows + WORLD_CHUNK_CELLS - 1) / WORLD_CHUNK_CELLS);
+    timer_wheel_init(&world->timers, world->tick);
+
+    world_init_tile_masks(world, map);
+    world_init_collision(world, map);
+    pages_init(&world->pages, map, WORLD_SEED);
+
+    world->player = (Character) {
+        .rect = (Rectangle) {
+            .x = world->width * 0.5f,
+            .y = world->height * 0.5f,
+            .width = PLAYER_WIDTH,
+            .height = PLAYER_HEIGHT,
+        },
+        .wheat_harvested_at = 0,
+    };
+
+    world_init_player_clips(world);
+
+    animals_init(&world->animals, &world->timers, clips, (Rectangle) { 0, 0, world->width, world->height }, 0x2545F491);
+    world->rng = 0x9E3779B9;
+    animal_spawn(&world->animals, ANIMAL_CHICKEN, (Vector2) { world->width * 0.25f, world->height * 0.25f });
+    world_spawn_animals(world, ANIMAL_COW, WORLD_INIT_COWS);
+
+    Item seeds = {
+        .id = ITEM_ID_SEEDS,
+        .name = "Seeds",
+        .sprite_sheet_pos = (Vector2) { 0.0f, 0.0f },
+    };
+    Item watering_can = {
+        .id = ITEM_ID_WATERING_CAN,
+        .name = "Watering Can",
+        .sprite_sheet_pos = (Vector2) { 0.0f, 0.0f },
+    };
+    Item scythe = {
+        .id = ITEM_ID_SCYTHE,
+        .name = "Scythe",
+        .sprite_sheet_pos = (Vector2) { 32.0f, 0.0f },
+    };
+
+    world->inventory = (Inventory) {
+        .items = { seeds, watering_can, scythe },
+        .selected_idx = 0,
+    };
+}
+
+int world_spawn_animals(World *world, AnimalKind kind, int count) {
+    const Vector2 size = animal_collider_size(kind);
+    const float cell_size = MAP_CELL_SIZE * MAP_SCALE;
+
+    // Random cells until one has room, giving up after a while on a map that's full.
+    int spawned = 0;
+    for (int attempt = 0; attempt < count * 16 && spawned < count; attempt++) {
+        const Rectangle rect = {
+            .x = (sim_xorshift32(&world->rng) % world->cols) * cell_size,
+            .y = (sim_xorshift32(&world->rng) % world->rows) * cell_size,
+            .width = size.x,
+            .height = size.y,
+        };
+        if (rect.x + rect.width > world->width || rect.y + rect.height > world->height) continue;
+        if (collision_world_overlaps(&world->collision, rect)) continue;
+
+        animal_spawn(&world->animals, kind, (Vector2) { rect.x, rect.y });
+        spawned++;
+    }
+    return spawned;
+}
+
+void world_update(World *world, Input input) {
+    Character *player = &world->player;
+    Inventory *inventory = &world->inventory;
+    CropStore *crops = &world->crops;
+
+    { // Stuff that should be done regardless of pause state.
+        if (input.pressed & INPUT_TOGGLE_DEBUG) {
+            world->game_state.debug_mode = !world->game_state.debug_mode;
+        }
+
+        if (input.pressed & INPUT_TOGGLE_PAUSE) {
+            world->game_state.paused = !world->game_state.paused;
+        }
+    }
+
+    // The rest of the update should not happen if the game is paused.
+    if (world->game_state.paused) return;
+
+    world->tick++;
+    world->time = world->tick * SIM_DT;
+
+    PROFILE_BEGIN(PROFILE_ZONE_TIMERS);
+    timer_wheel_advance(&world->timers, world->tick);
+    PROFILE_END(PROFILE_ZONE_TIMERS);
+    moisture_step(&world->moisture, world->jobs);
+
+    { // Terrain
+        // Only kicks off loading and evicting, anything the player runs into before it's loaded
+        // gets loaded right when the collision below asks for it.
+        const float cell_size = MAP_CELL_SIZE * MAP_SCALE;
+        const Vector2 feet = get_character_pos(*player);
+        pages_stream(&world->pages, (int)floorf(feet.x / cell_size), (int)floorf(feet.y / cell_size));
+    }
+
+    Vector2 pos_diff_normalized = { 0 };
+    { // Movement
+        Vector2 pos_diff = { 0 };
+        if (input.down & INPUT_LEFT)  pos_diff.x--;
+        if (input.down & INPUT_RIGHT) pos_diff.x++;
+        if (input.down & INPUT_UP)    pos_diff.y--;
+        if (input.down & INPUT_DOWN)  pos_diff.y++;
+
+        pos_diff_normalized = Vector2Normalize(pos_diff);
+    }
+
+    const bool is_idle = Vector2Length(pos_diff_normalized) == 0.0f;
+    const bool is_running = !is_idle && (input.down & INPUT_RUN);
+    const float speed = is_running ? PLAYER_RUNNING_SPEED : PLAYER_WALKING_SPEED;
+
+    { // Collision
+        const float cell_size = MAP_CELL_SIZE * MAP_SCALE;
+        CollisionMover mover = { .rect = player->rect, .delta = Vector2Scale(pos_diff_normalized, speed * SIM_DT) };
+        // Everything the player could reach this tick, in either direction.
+        const Rectangle reach = {
+            mover.rect.x - fabsf(mover.delta.x),
+            mover.rect.y - fabsf(mover.delta.y),
+            mover.rect.width + 2.0f * fabsf(mover.delta.x),
+            mover.rect.height + 2.0f * fabsf(mover.delta.y),
+        };
+        Rectangle page_solids[WORLD_PAGE_SOLIDS_CAP];
+        const int page_solid_count = pages_solid_rects(&world->pages, reach, cell_size, page_solids, WORLD_PAGE_SOLIDS_CAP);
+        collision_world_move_among(&world->collision, page_solids, page_solid_count, &mover, 1);
+        player->rect = mover.rect;
+
+        animals_update(&world->animals, &world->collision, world->jobs, SIM_DT);
+    }
+
+    { // Items
+        if (input.pressed & INPUT_SLOT_1) inventory->selected_idx = 0;
+        if (input.pressed & INPUT_SLOT_2) inventory->selected_idx = 1;
+        if (input.pressed & INPUT_SLOT_3) inventory->selected_idx = 2;
+        if (input.pressed & INPUT_SLOT_4) inventory->selected_idx = 3;
+        if (input.pressed & INPUT_SLOT_5) inventory->selected_idx = 4;
+
+        if (input.pressed & INPUT_USE) {
+            switch (inventory->items[inventory->selected_idx].id) {
+                case ITEM_ID_SEEDS: {
+                    const int id = get_cell_id_player_is_facing(world, *player);
+                    if (!player_is_facing_farmable_cell(world, *player)) break;
+                    if (crop_is_planted(crops, id)) break;
+
+                    crop_plant(crops, id, (uint32_t)world->tick);
+                    const uint32_t ticks = crop_stage_ticks(moisture_get(&world->moisture, id));
+                    world->grow_timers[id] = timer_schedule(&world->timers, world->tick + ticks, on_crop_grow, world, id);
+                    world_refresh_active_cell(world, id);
+                    break;
+                }
+                case ITEM_ID_WATERING_CAN: {
+                    // TODO: animation
+
+                    const int id = get_cell_id_player_is_facing(world, *player);
+                    if (!player_is_facing_farmable_cell(world, *player)) break;
+
+                    moisture_add(&world->moisture, id, SOIL_WATERING_AMOUNT);
+                    world_refresh_active_cell(world, id);
+                    break;
+                }
+                case ITEM_ID_SCYTHE: {
+                    // Play animation every time.
+                    player->swung_scythe_at = world->time;
+                    anim_restart(&world->tool_anim, world->player_clips.scythe_swing[player->dir]);
+                    timer_cancel(&world->timers, world->scythe_swing_timer);
+                    world->scythe_swing_timer = timer_schedule(&world->timers, world->tick + SCYTHE_SWING_TICKS, on_scythe_swing_over, world, 0);
+
+                    const int id = get_cell_id_player_is_facing(world, *player);
+                    if (id < 0) {
+                        world_till_off_map(world, *player);
+                        break;
+                    }
+                    if (!crop_is_planted(crops, id)) break;
+
+                    if (crop_is_full_grown(crops, id)) {
+                        player->wheat_harvested_at = world->time;
+                        timer_cancel(&world->timers, world->wheat_float_timer);
+                        world->wheat_float_timer = timer_schedule(&world->timers, world->tick + WHEAT_FLOAT_TICKS, on_wheat_float_over, world, 0);
+
+                        timer_cancel(&world->timers, world->grow_timers[id]);
+                        world->grow_timers[id] = 0;
+                        crop_clear(crops, id);
+                        world_refresh_active_cell(world, id);
+                    }
+
+                    break;
+                }
+                default: {
+                    TraceLog(LOG_ERROR, "tried to use a non-existent item");
+                    break;
+                }
+            }
+        }
+    }
+
+    { // Animation
+        if (input.down & INPUT_UP) {
+            player->dir = UP;
+        } else if ((input.down & INPUT_DOWN) || ((input.down & INPUT_LEFT) && (input.down & INPUT_RIGHT))) {
+            player->dir = DOWN;
+        } else if (input.down & INPUT_LEFT) {
+            player->dir = LEFT;
+        } else if (input.down & INPUT_RIGHT) {
+            player->dir = RIGHT;
+        }
+
+        const PlayerClips *clips = &world->player_clips;
+        if (is_idle) {
+            anim_play(&world->player_anim, clips->idle[player->dir]);
+        } else if (is_running) {
+            anim_play(&world->player_anim, clips->run[player->dir]);
+        } else {
+            anim_play(&world->player_anim, clips->walk[player->dir]);
+        }
+        anim_advance(world->clips, &world->player_anim, 1);
+        anim_advance(world->clips, &world->tool_anim, 1);
+    }
+}
+
+// Hash --------------------------------------------------------------------------------------------
+
+static uint64_t world_hash_bytes(uint64_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t world_hash(const World *world) {
+    uint64_t hash = 14695981039346656037ull;
+    const int cell_count = world->cols * world->rows;
+
+    const uint32_t state[] = {
+        world->game_state.paused, world->rng, world->animals.rng,
+        world->player.dir, (uint32_t)world->inventory.selected_idx,
+        world->player_anim.clip, world->player_anim.time, world->tool_anim.clip, world->tool_anim.time,
+    };
+    hash = world_hash_bytes(hash, &world->tick, sizeof(world->tick));
+    hash = world_hash_bytes(hash, state, sizeof(state));
+    hash = world_hash_bytes(hash, &world->player.rect, sizeof(world->player.rect));
+
+    hash = world_hash_bytes(hash, world->crops.planted_at, cell_count * sizeof(*world->crops.planted_at));
+    hash = world_hash_bytes(hash, world->crops.stage, cell_count * sizeof(*world->crops.stage));
+    hash = world_hash_bytes(hash, world->moisture.cells, cell_count * sizeof(*world->moisture.cells));
+    for (int i = 0; i < cell_count; i++) {
+        const uint64_t due = timer_due(&world->timers, world->grow_timers[i]);
+        hash = world_hash_bytes(hash, &due, sizeof(due));
+    }
+
+    // Dense order, which is spawn order with despawns swapped in, so it's deterministic too.
+    const ComponentStore *transforms = &world->animals.transforms;
+    hash = world_hash_bytes(hash, transforms->data, transforms->count * transforms->size);
+    const ComponentStore *wanderers = &world->animals.wanderers;
+    for (size_t i = 0; i < wanderers->count; i++) {
+        const WanderComponent *wander = &((const WanderComponent *)wanderers->data)[i];
+        const uint64_t due = timer_due(&world->timers, wander->timer);
+        hash = world_hash_bytes(hash, &due, sizeof(due));
+        hash = world_hash_bytes(hash, &wander->rng, sizeof(wander->rng));
+    }
+
+    // Off the map, only what got changed, generated pages come out the same anyway.
+    const Page **changed = malloc((world->pages.spilled.count + PAGE_POOL_CAPACITY) * sizeof(*changed));
+    assert(changed != NULL && "Buy more RAM lol");
+    const size_t changed_count = pages_changed(&world->pages, changed);
+    for (size_t i = 0; i < changed_count; i++) {
+        const int32_t coords[] = { changed[i]->x, changed[i]->y };
+        hash = world_hash_bytes(hash, coords, sizeof(coords));
+        hash = world_hash_bytes(hash, changed[i]->gids, sizeof(changed[i]->gids));
+    }
+    free(changed);
+
+    return hash;
+}
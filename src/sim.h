@@ -0,0 +1,231 @@
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <raylib.h>
+
+#include "anim.h"
+#include "animals.h"
+#include "collision.h"
+#include "crops.h"
+#include "jobs.h"
+#include "moisture.h"
+#include "pages.h"
+#include "tilemask.h"
+#include "timers.h"
+#include "tmx.h"
+
+// Everything in here is the game simulation: it never touches the window, the GPU or the audio
+// device, so it can be stepped headless (see `--headless` in main.c).
+
+#define MAP_PATH "resources/tilesets/map2.tmx"
+// Baked from MAP_PATH by `./nob map`.
+#define MAP_BLOB_PATH "resources/tilesets/map2.bin"
+#define MAP_SCALE 3.0f
+#define MAP_CELL_SIZE 16.0f
+// Object group in the map whose rectangles the player can't walk through.
+#define MAP_COLLISION_GROUP "collision"
+
+// The simulation always advances in steps of exactly SIM_DT, no matter how fast we render.
+#define SIM_TICKS_PER_SECOND 144
+#define SIM_DT (1.0 / SIM_TICKS_PER_SECOND)
+// If a frame took forever (debugger, window drag) don't try to catch up on all of it at once,
+// otherwise the catch-up frame is slow too and we never recover.
+#define SIM_MAX_TICKS_PER_FRAME 8
+
+#define PLAYER_WIDTH 64.0f
+#define PLAYER_HEIGHT 64.0f
+#define PLAYER_WALKING_SPEED 300.0f
+#define PLAYER_RUNNING_SPEED 500.0f
+
+// Soil moisture, see moisture.h. A watering can soaks the cell it's used on, from there it seeps
+// into the neighbours and evaporates with a half-life of about 20 seconds. A single watered cell
+// stays wet enough to speed crops up for about half a minute.
+#define SOIL_WATERING_AMOUNT 1.0f
+#define SOIL_DIFFUSION 0.0001f
+#define SOIL_EVAPORATION 0.00024f
+// How long the harvested wheat floats above the player, and how long a scythe swing lasts.
+#define WHEAT_FLOAT_TICKS SIM_TICKS_PER_SECOND
+#define SCYTHE_SWING_TICKS (SIM_TICKS_PER_SECOND / 2)
+
+// The world is cut into squares of this many cells for saving, only the squares that changed get
+// written again (see save.h).
+#define WORLD_CHUNK_CELLS 32
+// What the terrain past the edge of the map is generated from, see pages.h.
+#define WORLD_SEED 0x5EEDF00Du
+// Most solid cells of streamed terrain the player gets checked against in a tick.
+#define WORLD_PAGE_SOLIDS_CAP 64
+
+#define INVENTORY_CAPACITY 5
+
+#define ITEM_ID_SEEDS 0
+#define ITEM_ID_WATERING_CAN 1
+#define ITEM_ID_SCYTHE 2
+
+typedef struct GameState {
+    bool debug_mode;
+    bool paused;
+} GameState;
+
+typedef struct Cell {
+    int x; // col
+    int y; // row
+} Cell;
+
+typedef struct Item {
+    int id;
+    char name[256];
+    Vector2 sprite_sheet_pos;
+} Item;
+
+typedef struct Inventory {
+    Item items[INVENTORY_CAPACITY];
+    int selected_idx;
+} Inventory;
+
+typedef enum {
+    UP = 0,
+    DOWN,
+    LEFT,
+    RIGHT
+} Direction;
+
+// Clip ids of the player animations, indexed by Direction. Swinging up has no clip, that one is
+// ANIM_CLIP_NONE.
+typedef struct PlayerClips {
+    uint16_t idle[4];
+    uint16_t walk[4];
+    uint16_t run[4];
+    uint16_t scythe_swing[4];
+} PlayerClips;
+
+typedef struct Character {
+    Rectangle rect;
+    Direction dir;
+    double wheat_harvested_at;
+    double swung_scythe_at;
+} Character;
+
+// One tick worth of player intent. The windowed build fills this from the keyboard, headless runs
+// feed it from wherever they like. `down` is held buttons, `pressed` is buttons that went down
+// since the last tick.
+typedef enum {
+    INPUT_LEFT         = 1 << 0,
+    INPUT_RIGHT        = 1 << 1,
+    INPUT_UP           = 1 << 2,
+    INPUT_DOWN         = 1 << 3,
+    INPUT_RUN          = 1 << 4,
+    INPUT_USE          = 1 << 5,
+    INPUT_TOGGLE_DEBUG = 1 << 6,
+    INPUT_TOGGLE_PAUSE = 1 << 7,
+    INPUT_SLOT_1       = 1 << 8,
+    INPUT_SLOT_2       = 1 << 9,
+    INPUT_SLOT_3       = 1 << 10,
+    INPUT_SLOT_4       = 1 << 11,
+    INPUT_SLOT_5       = 1 << 12,
+} InputButton;
+
+typedef struct Input {
+    uint16_t down;
+    uint16_t pressed;
+} Input;
+
+typedef struct World {
+    GameState game_state;
+
+    // Simulated time. Only ever advances by SIM_DT inside world_update(), never read from a wall
+    // clock, so two runs fed the same input end up in the same state.
+    uint64_t tick;
+    double time;
+
+    // The map the world was made from, sizes below come from it. A cell id is `x + y * cols`.
+    const TmxMap *map;
+    int cols, rows;
+    float width, height;
+
+    Cell *cells;
+    // Tile properties of every cell, taken from the top-most tile drawn on it (see TmxTileFlag).
+    TileMask solid, water, farmable, tillable;
+    // Indexed by cell id, same as `cells`.
+    CropStore crops;
+    MoistureField moisture;
+    // Every gameplay timer lives in here, on ticks. Per cell, the pending stage transition of the
+    // crop, 0 when there is none.
+    TimerWheel timers;
+    TimerId *grow_timers;
+    // Sparse set of the cells that have something planted on them, so the renderer only has to
+    // visit those. `active_cell_slots[id]` is the index into `active_cells`, or -1.
+    int *active_cells;
+    int active_cell_count;
+    int *active_cell_slots;
+    // One bit per WORLD_CHUNK_CELLS square, set when something in it changed since the last save.
+    TileMask dirty_chunks;
+
+    Character player;
+    // What the player and the tool in their hand are playing, out of `clips`.
+    const AnimLibrary *clips;
+    PlayerClips player_clips;
+    AnimCursor player_anim, tool_anim;
+    // Reset `wheat_harvested_at` and `swung_scythe_at` of the player once the animation is over.
+    TimerId wheat_float_timer, scythe_swing_timer;
+    // Chickens, cows and whatever else roams the map on its own.
+    Animals animals;
+    // State of the xorshift that picks where animals spawn.
+    uint32_t rng;
+
+    Inventory inventory;
+    // Every object of the collision group plus the solid tiles, in world coordinates, bucketed
+    // by cell.
+    CollisionWorld collision;
+    // Everything past the edge of the map, streamed in around the player. Only the player goes
+    // out there, animals and crops stay on the map.
+    WorldPages pages;
+
+    // Threads the systems spread their chunks over, NULL to run it all on the one calling
+    // world_update(). A tick comes out the same either way.
+    JobSystem *jobs;
+} World;
+
+// Drives world_update() at SIM_DT from whatever clock the caller injects: GetTime() when we have a
+// window, sim_monotonic_seconds() otherwise.
+typedef struct FixedStep {
+    double (*now)(void);
+    double previous;
+    double accumulator;
+} FixedStep;
+
+// The timers point back at the world, so it must not move after this. `clips` and `jobs` have to
+// outlive the world.
+void world_init(World *world, const TmxMap *map, const AnimLibrary *clips, JobSystem *jobs);
+void world_update(World *world, Input input);
+// Drops up to `count` animals of `kind` on random free spots of the map, returns how many it found
+// room for.
+int world_spawn_animals(World *world, AnimalKind kind, int count);
+
+FixedStep fixed_step_create(double (*now)(void));
+// Returns how many ticks the caller owes the simulation since the last call.
+int fixed_step_begin_frame(FixedStep *step);
+
+double sim_monotonic_seconds(void);
+
+Vector2 get_character_pos(Character player);
+Rectangle get_character_cell_rect(Character player);
+Rectangle get_cell_rect_character_is_facing(Character player);
+Cell get_cell_player_is_facing(Character player);
+// -1 when the player is facing off the edge of the map.
+int get_cell_id_player_is_facing(const World *world, Character player);
+bool is_cell_in_area(Cell needle, Cell haystack, int cols, int rows);
+Cell cell_id_to_cell(const World *world, const int cell_id);
+int cell_to_cell_id(const World *world, const Cell cell);
+bool player_is_facing_farmable_cell(const World *world, Character player);
+// Call after changing anything about a cell so it enters or leaves the active set and gets saved.
+void world_refresh_active_cell(World *world, int cell_id);
+// Puts a crop back the way it was saved, `grow_due` being the tick of its next stage or 0.
+void world_restore_crop(World *world, int cell_id, uint32_t planted_at, uint8_t stage, uint64_t grow_due);
+// FNV-1a over everything input and time can change: the clock, the player, every crop, the soil,
+// every animal and the terrain changed past the map (see pages_changed()). Two worlds that hash the
+// same play out the same from there on.
+uint64_t world_hash(const World *world);
+
+#endif // SIM_H_
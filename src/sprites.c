@@ -0,0 +1,157 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <raylib.h>
+#include <rlgl.h>
+
+#include "nob.h"
+#include "sprites.h"
+
+#define ATLAS_GEN_IMPLEMENTATION
+#include "atlas_gen.h"
+
+#define SPRITE_KEY_LAYER_SHIFT 48
+#define SPRITE_KEY_TEXTURE_SHIFT 32
+#define SPRITE_KEY_TEXTURE_MASK 0xFFFF
+
+bool sprite_batch_load(SpriteBatch *batch) {
+    memset(batch, 0, sizeof(*batch));
+
+    for (int p = 0; p < ATLAS_PAGE_COUNT; p++) {
+        batch->pages[p] = LoadTexture(atlas_page_paths[p]);
+        if (batch->pages[p].id == 0) {
+            TraceLog(LOG_ERROR, "could not load atlas page %s, rerun `./nob atlas`", atlas_page_paths[p]);
+            sprite_batch_unload(batch);
+            return false;
+        }
+    }
+
+    // Plain raylib shape drawing (debug outlines and such) goes through the atlas too, that way it
+    // doesn't switch textures in the middle of a batch either.
+    const AtlasRegion *white = atlas_region(ATLAS_WHITE);
+    SetShapesTexture(batch->pages[white->page], white->rect);
+
+    return true;
+}
+
+void sprite_batch_unload(SpriteBatch *batch) {
+    for (int p = 0; p < ATLAS_PAGE_COUNT; p++) {
+        if (batch->pages[p].id != 0) UnloadTexture(batch->pages[p]);
+    }
+    nob_da_free(batch->sprites);
+    memset(batch, 0, sizeof(*batch));
+}
+
+const AtlasRegion *atlas_region(AtlasSheet sheet) {
+    assert(sheet >= 0 && sheet < ATLAS_SHEET_COUNT);
+    return &atlas_regions[sheet];
+}
+
+void sprite_batch_begin_frame(SpriteBatch *batch) {
+    batch->sprites.count = 0;
+    batch->draw_calls = 0;
+}
+
+void sprite_batch_draw_texture(SpriteBatch *batch, SpriteLayer layer, Texture2D texture, Rectangle src, Rectangle dst, Vector2 origin, Color tint) {
+    assert(texture.id <= SPRITE_KEY_TEXTURE_MASK);
+    const Sprite sprite = {
+        .key = ((uint64_t)layer << SPRITE_KEY_LAYER_SHIFT) | ((uint64_t)texture.id << SPRITE_KEY_TEXTURE_SHIFT) | batch->sprites.count,
+        .texture = texture,
+        .src = src,
+        .dst = dst,
+        .origin = origin,
+        .tint = tint,
+    };
+    nob_da_append(&batch->sprites, sprite);
+}
+
+void sprite_batch_draw(SpriteBatch *batch, SpriteLayer layer, AtlasSheet sheet, Rectangle src, Rectangle dst, Vector2 origin, Color tint) {
+    const AtlasRegion *region = atlas_region(sheet);
+    src.x += region->rect.x;
+    src.y += region->rect.y;
+    sprite_batch_draw_texture(batch, layer, batch->pages[region->page], src, dst, origin, tint);
+}
+
+void sprite_batch_rect(SpriteBatch *batch, SpriteLayer layer, Rectangle dst, Color tint) {
+    const AtlasRegion *white = atlas_region(ATLAS_WHITE);
+    sprite_batch_draw_texture(batch, layer, batch->pages[white->page], white->rect, dst, (Vector2) { 0 }, tint);
+}
+
+static int sprite_compare(const void *a, const void *b) {
+    const uint64_t ka = ((const Sprite *)a)->key;
+    const uint64_t kb = ((const Sprite *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+void sprite_batch_flush(SpriteBatch *batch) {
+    if (batch->sprites.count == 0) return;
+
+    // Whatever raylib had queued before us goes out first so it stays underneath.
+    rlDrawRenderBatchActive();
+
+    qsort(batch->sprites.items, batch->sprites.count, sizeof(Sprite), sprite_compare);
+
+    size_t run_start = 0;
+    while (run_start < batch->sprites.count) {
+        const unsigned int texture_id = batch->sprites.items[run_start].texture.id;
+
+        // rlgl keeps appending quads to the same draw as long as the texture stays the same, so a
+        // run of sprites on one texture becomes a single draw call.
+        size_t i = run_start;
+        for (; i < batch->sprites.count; i++) {
+            const Sprite *sprite = &batch->sprites.items[i];
+            if (sprite->texture.id != texture_id) break;
+            DrawTexturePro(sprite->texture, sprite->src, sprite->dst, sprite->origin, 0.0f, sprite->tint);
+        }
+        rlDrawRenderBatchActive();
+        batch->draw_calls++;
+
+        run_start = i;
+    }
+
+    batch->sprites.count = 0;
+}
+
+// Drops `.` and `dir/..` segments, "a/b/../c.png" becomes "a/c.png".
+static void atlas_normalize_path(char *dst, size_t cap, const char *path) {
+    const char *segments[64];
+    size_t lens[64];
+    int count = 0;
+
+    while (*path != '\0') {
+        const char *slash = strchr(path, '/');
+        const size_t len = slash ? (size_t)(slash - path) : strlen(path);
+
+        if (len == 2 && path[0] == '.' && path[1] == '.' && count > 0) {
+            count--;
+        } else if (len > 0 && !(len == 1 && path[0] == '.') && count < (int)NOB_ARRAY_LEN(segments)) {
+            segments[count] = path;
+            lens[count] = len;
+            count++;
+        }
+
+        path += len;
+        if (*path == '/') path++;
+    }
+
+    size_t n = 0;
+    dst[0] = '\0';
+    for (int i = 0; i < count && n + lens[i] + 1 < cap; i++) {
+        if (i > 0) dst[n++] = '/';
+        memcpy(dst + n, segments[i], lens[i]);
+        n += lens[i];
+        dst[n] = '\0';
+    }
+}
+
+int atlas_find_source(const char *path) {
+    char wanted[512], source[512];
+    atlas_normalize_path(wanted, sizeof(wanted), path);
+
+    for (int i = 0; i < ATLAS_SHEET_COUNT; i++) {
+        if (atlas_regions[i].source == NULL) continue;
+        atlas_normalize_path(source, sizeof(source), atlas_regions[i].source);
+        if (strcmp(wanted, source) == 0) return i;
+    }
+    return -1;
+}
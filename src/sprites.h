@@ -0,0 +1,68 @@
+#ifndef SPRITES_H_
+#define SPRITES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <raylib.h>
+
+// Every sprite sheet lives in a texture atlas packed at build time by `./nob atlas`, so a frame
+// can be drawn with one texture bind per atlas page instead of one per sheet. Sprites are queued
+// into a SpriteBatch, sorted by layer and texture on flush, and submitted as one run per texture.
+
+typedef struct AtlasRegion {
+    int page;
+    // Where the sheet sits on its page, in pixels.
+    Rectangle rect;
+    // The png it was packed from, NULL for the white block.
+    const char *source;
+} AtlasRegion;
+
+#include "atlas_gen.h"
+
+// Drawn back to front, in this order. Within a layer and texture sprites keep the order they were
+// queued in, but a layer draws one texture after the other, so sprites that overlap and come from
+// different textures (another atlas page, a render target) have to go on separate layers.
+typedef enum {
+    SPRITE_LAYER_MAP,
+    SPRITE_LAYER_GROUND,
+    SPRITE_LAYER_CHARACTERS,
+    SPRITE_LAYER_UI,
+    SPRITE_LAYER_COUNT,
+} SpriteLayer;
+
+typedef struct Sprite {
+    // Layer, texture and queue order packed together, sorting by it sorts by all three.
+    uint64_t key;
+    Texture2D texture;
+    Rectangle src, dst;
+    Vector2 origin;
+    Color tint;
+} Sprite;
+
+typedef struct SpriteBatch {
+    Texture2D pages[ATLAS_PAGE_COUNT];
+    struct { Sprite *items; size_t count, capacity; } sprites;
+    // Draw calls submitted since sprite_batch_begin_frame().
+    int draw_calls;
+} SpriteBatch;
+
+bool sprite_batch_load(SpriteBatch *batch);
+void sprite_batch_unload(SpriteBatch *batch);
+
+void sprite_batch_begin_frame(SpriteBatch *batch);
+// `src` is in pixels of the original sheet, the atlas offset is added here.
+void sprite_batch_draw(SpriteBatch *batch, SpriteLayer layer, AtlasSheet sheet, Rectangle src, Rectangle dst, Vector2 origin, Color tint);
+// For textures that aren't part of the atlas, like render targets. Each one costs its own draw call.
+void sprite_batch_draw_texture(SpriteBatch *batch, SpriteLayer layer, Texture2D texture, Rectangle src, Rectangle dst, Vector2 origin, Color tint);
+// A solid rectangle, drawn with the white block of the atlas so it doesn't break the batch.
+void sprite_batch_rect(SpriteBatch *batch, SpriteLayer layer, Rectangle dst, Color tint);
+// Draws everything queued so far and empties the queue.
+void sprite_batch_flush(SpriteBatch *batch);
+
+const AtlasRegion *atlas_region(AtlasSheet sheet);
+// The sheet that was packed from the png at `path`, or -1. `path` may contain `..` segments, like
+// the image paths of Tiled tilesets do.
+int atlas_find_source(const char *path);
+
+#endif // SPRITES_H_
@@ -0,0 +1,326 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "autotile.h"
+#include "terrain.h"
+
+// Periods are in cells and halve with every octave, amplitudes too.
+#define TERRAIN_HEIGHT_PERIOD 64
+#define TERRAIN_HEIGHT_OCTAVES 4
+#define TERRAIN_DIRT_PERIOD 16
+#define TERRAIN_DIRT_OCTAVES 3
+// Smallest period any octave gets down to.
+#define TERRAIN_MIN_PERIOD 4
+
+// Noise comes out in [0, 1), bunched up around the middle.
+#define TERRAIN_WATER_LEVEL 0.42f
+#define TERRAIN_HILLS_LEVEL 0.6f
+#define TERRAIN_DIRT_LEVEL 0.64f
+
+// How far out from the map land gets raised, and by how much right at its edge.
+#define TERRAIN_SHORE_CELLS 16
+#define TERRAIN_SHORE_RISE 0.3f
+
+// Generation goes a block of cells at a time, so the noise of a whole block can be worked out at
+// once with its buffers on the stack. Kinds are worked out for a ring of cells around the block
+// too, the edges need to know what's next to them.
+#define TERRAIN_BLOCK_CELLS 64
+#define TERRAIN_APRON_CELLS (TERRAIN_BLOCK_CELLS + 2)
+#define TERRAIN_LATTICE_CAP ((TERRAIN_APRON_CELLS - 1) / TERRAIN_MIN_PERIOD + 3)
+
+static_assert(TERRAIN_HEIGHT_PERIOD >> (TERRAIN_HEIGHT_OCTAVES - 1) >= TERRAIN_MIN_PERIOD, "height noise gets too fine");
+static_assert(TERRAIN_DIRT_PERIOD >> (TERRAIN_DIRT_OCTAVES - 1) >= TERRAIN_MIN_PERIOD, "dirt noise gets too fine");
+
+// Of the tileset and of the map layer of every kind.
+static const char *terrain_names[TERRAIN_KIND_COUNT] = {
+    [TERRAIN_WATER] = "water",
+    [TERRAIN_GRASS] = "grass",
+    [TERRAIN_HILLS] = "hills",
+    [TERRAIN_DIRT] = "dirt",
+};
+
+// Every field gets its own seed off the world's, so they don't all have their bumps in the same
+// places.
+#define TERRAIN_HEIGHT_SALT 0x68E31DA4u
+#define TERRAIN_DIRT_SALT 0xB5297A4Du
+#define TERRAIN_TILE_SALT 0x1B56C4E9u
+#define TERRAIN_OCTAVE_SALT 0x632BE5ABu
+
+static uint32_t terrain_hash(uint32_t seed, int x, int y) {
+    uint32_t h = seed;
+    h += (uint32_t)x * 0x9E3779B1u;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h += (uint32_t)y * 0xC2B2AE35u;
+    h ^= h >> 13;
+    h *= 0x27D4EB2Fu;
+    h ^= h >> 16;
+    return h;
+}
+
+// Noise -------------------------------------------------------------------------------------------
+
+// Rounding towards minus infinity, so the lattice doesn't get a seam at 0.
+static int terrain_floor_div(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static float terrain_lattice(uint32_t seed, int x, int y) {
+    return (float)(terrain_hash(seed, x, y) >> 8) * (1.0f / 16777216.0f);
+}
+
+static float terrain_smooth(float t) {
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// Value noise: random values on the corners of a grid `period` cells wide, smoothly blended in
+// between. Adds `amplitude` times the noise to every cell of the block. The corners the block
+// touches get hashed once up front instead of four times a cell.
+static void terrain_value_noise(uint32_t seed, int x, int y, int width, int height, int period, float amplitude, float *out) {
+    const int gx = terrain_floor_div(x, period);
+    const int gy = terrain_floor_div(y, period);
+    const int lattice_width = terrain_floor_div(x + width - 1, period) - gx + 2;
+    const int lattice_height = terrain_floor_div(y + height - 1, period) - gy + 2;
+
+    float lattice[TERRAIN_LATTICE_CAP * TERRAIN_LATTICE_CAP];
+    for (int j = 0; j < lattice_height; j++) {
+        for (int i = 0; i < lattice_width; i++) lattice[i + j * lattice_width] = terrain_lattice(seed, gx + i, gy + j);
+    }
+
+    int column[TERRAIN_APRON_CELLS];
+    float tx[TERRAIN_APRON_CELLS];
+    for (int col = 0; col < width; col++) {
+        const int cell = x + col - gx * period;
+        column[col] = cell / period;
+        tx[col] = terrain_smooth((float)(cell % period) / period);
+    }
+
+    for (int row = 0; row < height; row++) {
+        const int cell = y + row - gy * period;
+        const float *top = &lattice[cell / period * lattice_width];
+        const float *bottom = top + lattice_width;
+        const float ty = terrain_smooth((float)(cell % period) / period);
+        for (int col = 0; col < width; col++) {
+            const int i = column[col];
+            const float upper = top[i] + (top[i + 1] - top[i]) * tx[col];
+            const float lower = bottom[i] + (bottom[i + 1] - bottom[i]) * tx[col];
+            out[col + row * width] += amplitude * (upper + (lower - upper) * ty);
+        }
+    }
+}
+
+// A few octaves of value noise, every one half as wide and half as strong as the one before.
+static void terrain_fbm(uint32_t seed, int x, int y, int width, int height, int period, int octaves, float *out) {
+    memset(out, 0, (size_t)width * height * sizeof(float));
+    float total = 0.0f, amplitude = 1.0f;
+    for (int octave = 0; octave < octaves; octave++) {
+        terrain_value_noise(seed + octave * TERRAIN_OCTAVE_SALT, x, y, width, height, period, amplitude, out);
+        total += amplitude;
+        amplitude *= 0.5f;
+        period /= 2;
+    }
+    for (int i = 0; i < width * height; i++) out[i] /= total;
+}
+
+// What a cell is, given its height and dirt noise.
+static TerrainKind terrain_kind_at(const Terrain *terrain, int x, int y, float height, float dirt) {
+    const int dx = x < 0 ? -x : x >= terrain->map_width ? x - terrain->map_width + 1 : 0;
+    const int dy = y < 0 ? -y : y >= terrain->map_height ? y - terrain->map_height + 1 : 0;
+    const int distance = dx > dy ? dx : dy;
+    if (distance < TERRAIN_SHORE_CELLS) {
+        height += TERRAIN_SHORE_RISE * (float)(TERRAIN_SHORE_CELLS - distance) / TERRAIN_SHORE_CELLS;
+    }
+
+    if (height < TERRAIN_WATER_LEVEL) return TERRAIN_WATER;
+    if (height > TERRAIN_HILLS_LEVEL) return TERRAIN_HILLS;
+    return dirt > TERRAIN_DIRT_LEVEL ? TERRAIN_DIRT : TERRAIN_GRASS;
+}
+
+// Alias tables ------------------------------------------------------------------------------------
+
+// Vose's method: columns that are short of the average weight get topped up from the ones over it,
+// one column at a time, until every column is exactly the average.
+static void terrain_alias_build(TerrainAlias *table, const float *weights) {
+    const int n = table->count;
+    float total = 0.0f;
+    for (int i = 0; i < n; i++) total += weights[i];
+
+    float scaled[TERRAIN_ALIAS_CAP];
+    int small[TERRAIN_ALIAS_CAP], large[TERRAIN_ALIAS_CAP];
+    int small_count = 0, large_count = 0;
+    for (int i = 0; i < n; i++) {
+        scaled[i] = weights[i] * n / total;
+        if (scaled[i] < 1.0f) {
+            small[small_count++] = i;
+        } else {
+            large[large_count++] = i;
+        }
+    }
+
+    while (small_count > 0 && large_count > 0) {
+        const int s = small[--small_count];
+        const int l = large[--large_count];
+        table->keep[s] = (uint32_t)(scaled[s] * 65536.0f + 0.5f);
+        table->alias[s] = l;
+        scaled[l] -= 1.0f - scaled[s];
+        if (scaled[l] < 1.0f) {
+            small[small_count++] = l;
+        } else {
+            large[large_count++] = l;
+        }
+    }
+    // Whatever is left is within rounding of the average.
+    while (small_count > 0) {
+        const int i = small[--small_count];
+        table->keep[i] = 65536;
+        table->alias[i] = i;
+    }
+    while (large_count > 0) {
+        const int i = large[--large_count];
+        table->keep[i] = 65536;
+        table->alias[i] = i;
+    }
+}
+
+static uint16_t terrain_alias_draw(const TerrainAlias *table, uint32_t random) {
+    const uint32_t column = ((random & 0xFFFF) * (uint32_t)table->count) >> 16;
+    return table->gids[(random >> 16) < table->keep[column] ? column : table->alias[column]];
+}
+
+// The whole tile and its variants, the edge pieces are for the edges (see autotile.h). Loose tiles
+// below the edges are variants if the tileset gives them a weight. A tileset without edges is all
+// whole tiles, with a weight of 1 unless it says otherwise like Tiled does.
+static void terrain_tiles_init(TerrainTiles *tiles, const TmxMap *map, const TmxTileset *tileset) {
+    memset(tiles, 0, sizeof(*tiles));
+    if (tileset == NULL || tileset->columns == 0) return;
+
+    tiles->firstgid = tileset->firstgid;
+    tiles->edges = tileset->columns == AUTOTILE_COLUMNS && tileset->tilecount >= AUTOTILE_ROWS * AUTOTILE_COLUMNS;
+
+    TerrainAlias *table = &tiles->whole;
+    float weights[TERRAIN_ALIAS_CAP];
+    for (uint32_t id = 0; id < tileset->tilecount && table->count < TERRAIN_ALIAS_CAP; id++) {
+        float weight = tmx_tile_probability(map, tileset->firstgid + id);
+        if (tiles->edges && id != AUTOTILE_WHOLE) {
+            // Loose tiles nobody gave a weight are most likely decorations of some sort.
+            if (id < AUTOTILE_ROWS * AUTOTILE_COLUMNS || weight < 0.0f) continue;
+        }
+        if (weight < 0.0f) weight = 1.0f;
+        if (weight == 0.0f) continue;
+
+        table->gids[table->count] = tileset->firstgid + id;
+        weights[table->count] = weight;
+        table->count++;
+    }
+    terrain_alias_build(table, weights);
+}
+
+// Terrain -----------------------------------------------------------------------------------------
+
+void terrain_init(Terrain *terrain, const TmxMap *map, uint32_t seed) {
+    memset(terrain, 0, sizeof(*terrain));
+    terrain->seed = seed;
+    terrain->map_width = map->width;
+    terrain->map_height = map->height;
+    autotile_init(&terrain->autotile);
+
+    for (int kind = 0; kind < TERRAIN_KIND_COUNT; kind++) {
+        const TmxTileset *found = NULL;
+        for (size_t i = 0; i < map->tilesets.count; i++) {
+            if (strcmp(map->tilesets.items[i].name, terrain_names[kind]) == 0) found = &map->tilesets.items[i];
+        }
+        terrain_tiles_init(&terrain->tiles[kind], map, found);
+
+        const TmxLayer *layer = tmx_find_layer(map, terrain_names[kind]);
+        terrain->map_layers[kind] = layer != NULL ? layer->gids : NULL;
+    }
+}
+
+bool terrain_is_on_map(const Terrain *terrain, int x, int y) {
+    return x >= 0 && x < terrain->map_width && y >= 0 && y < terrain->map_height;
+}
+
+bool terrain_map_has(const Terrain *terrain, TerrainKind kind, int x, int y) {
+    const uint16_t *gids = terrain->map_layers[kind];
+    return gids != NULL && gids[x + y * terrain->map_width] != 0;
+}
+
+uint16_t terrain_tile(const Terrain *terrain, TerrainKind kind, int x, int y, uint8_t mask) {
+    const TerrainTiles *tiles = &terrain->tiles[kind];
+    if (tiles->edges) {
+        const uint8_t tile = autotile_pick(&terrain->autotile, mask);
+        if (tile != AUTOTILE_WHOLE) return tiles->firstgid + tile;
+    }
+    if (tiles->whole.count == 0) return 0;
+    return terrain_alias_draw(&tiles->whole, terrain_hash(terrain->seed ^ (TERRAIN_TILE_SALT + kind), x, y));
+}
+
+static void terrain_generate_block(const Terrain *terrain, int x, int y, int width, int height, uint16_t *const gids[TERRAIN_KIND_COUNT], int stride) {
+    // Everything here is for the block and the ring around it, one bit per kind that's on a cell.
+    const int apron_width = width + 2;
+    const int apron_height = height + 2;
+    float heights[TERRAIN_APRON_CELLS * TERRAIN_APRON_CELLS];
+    float dirt[TERRAIN_APRON_CELLS * TERRAIN_APRON_CELLS];
+    uint8_t kinds[TERRAIN_APRON_CELLS * TERRAIN_APRON_CELLS];
+    terrain_fbm(terrain->seed ^ TERRAIN_HEIGHT_SALT, x - 1, y - 1, apron_width, apron_height, TERRAIN_HEIGHT_PERIOD, TERRAIN_HEIGHT_OCTAVES, heights);
+    terrain_fbm(terrain->seed ^ TERRAIN_DIRT_SALT, x - 1, y - 1, apron_width, apron_height, TERRAIN_DIRT_PERIOD, TERRAIN_DIRT_OCTAVES, dirt);
+
+    for (int row = 0; row < apron_height; row++) {
+        const int cy = y - 1 + row;
+        for (int col = 0; col < apron_width; col++) {
+            const int cx = x - 1 + col;
+            const int i = col + row * apron_width;
+            uint8_t bits = 0;
+            if (terrain_is_on_map(terrain, cx, cy)) {
+                for (int kind = 0; kind < TERRAIN_KIND_COUNT; kind++) {
+                    if (terrain_map_has(terrain, kind, cx, cy)) bits |= 1 << kind;
+                }
+            } else {
+                // Water under everything, like on the map, and the rest on top of grass.
+                const TerrainKind kind = terrain_kind_at(terrain, cx, cy, heights[i], dirt[i]);
+                bits = 1 << TERRAIN_WATER;
+                if (kind != TERRAIN_WATER) bits |= 1 << TERRAIN_GRASS | 1 << kind;
+            }
+            kinds[i] = bits;
+        }
+    }
+
+    for (int row = 0; row < height; row++) {
+        const int cy = y + row;
+        for (int col = 0; col < width; col++) {
+            const int cx = x + col;
+            if (terrain_is_on_map(terrain, cx, cy)) continue;
+
+            const uint8_t *around = &kinds[(col + 1) + (row + 1) * apron_width];
+            for (int kind = 0; kind < TERRAIN_KIND_COUNT; kind++) {
+                if (!(*around & 1 << kind)) continue;
+
+                uint8_t mask = 0;
+                for (int bit = 0; bit < 8; bit++) {
+                    const uint8_t neighbour = around[autotile_offsets[bit][0] + autotile_offsets[bit][1] * apron_width];
+                    if (neighbour & 1 << kind) mask |= 1 << bit;
+                }
+                gids[kind][col + row * stride] = terrain_tile(terrain, kind, cx, cy, mask);
+            }
+        }
+    }
+}
+
+void terrain_generate(const Terrain *terrain, int x, int y, int width, int height, uint16_t *const gids[TERRAIN_KIND_COUNT]) {
+    for (int kind = 0; kind < TERRAIN_KIND_COUNT; kind++) memset(gids[kind], 0, (size_t)width * height * sizeof(uint16_t));
+
+    for (int by = 0; by < height; by += TERRAIN_BLOCK_CELLS) {
+        for (int bx = 0; bx < width; bx += TERRAIN_BLOCK_CELLS) {
+            uint16_t *const block[TERRAIN_KIND_COUNT] = {
+                gids[TERRAIN_WATER] + bx + by * width,
+                gids[TERRAIN_GRASS] + bx + by * width,
+                gids[TERRAIN_HILLS] + bx + by * width,
+                gids[TERRAIN_DIRT] + bx + by * width,
+            };
+            const int block_width = width - bx < TERRAIN_BLOCK_CELLS ? width - bx : TERRAIN_BLOCK_CELLS;
+            const int block_height = height - by < TERRAIN_BLOCK_CELLS ? height - by : TERRAIN_BLOCK_CELLS;
+            terrain_generate_block(terrain, x + bx, y + by, block_width, block_height, block, width);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef TERRAIN_H_
+#define TERRAIN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "autotile.h"
+#include "tmx.h"
+
+// Procedural terrain for the world past the map (see pages.h), in the map's own tilesets.
+//
+// Two fields of value noise, a few octaves each, decide what a cell is: the height one puts water
+// in the low parts, grass over the rest and hills on top of the high parts, the other one throws
+// patches of dirt on the grass. Land gets raised a bit close to the map, so walking off it doesn't
+// end in the sea right away. Which tile of its tileset a cell gets is then drawn by the `probability`
+// the tileset gives every tile, from an alias table so a draw costs the same no matter how many
+// tiles there are to pick from.
+//
+// Everything about a cell comes from hashing the seed with its coordinates and those of its
+// neighbours, nothing carries over from one cell to the next. Any chunk comes out the same whether
+// it's generated first or last, on whatever thread, and chunks next to each other line up.
+//
+// Where a kind stops, the cell gets the edge or corner piece for what's around it instead (see
+// autotile.h). The map counts for that too, so terrain runs into it without a seam.
+
+// What a cell can be, in the order of the map's terrain layers.
+typedef enum {
+    TERRAIN_WATER = 0,
+    TERRAIN_GRASS,
+    TERRAIN_HILLS,
+    TERRAIN_DIRT,
+    TERRAIN_KIND_COUNT,
+} TerrainKind;
+
+// More than any tileset has tiles to fill with.
+#define TERRAIN_ALIAS_CAP 32
+
+// Walker/Vose alias table: a draw picks a column uniformly and then either keeps it or goes with
+// the column's alias.
+typedef struct TerrainAlias {
+    uint16_t gids[TERRAIN_ALIAS_CAP];
+    // Out of 65536, the chance to keep the column.
+    uint32_t keep[TERRAIN_ALIAS_CAP];
+    uint8_t alias[TERRAIN_ALIAS_CAP];
+    int count;
+} TerrainAlias;
+
+typedef struct TerrainTiles {
+    // 0 if the map has no tileset for the kind, the kind never gets drawn then.
+    uint16_t firstgid;
+    // Has the edge rows autotile.h expects.
+    bool edges;
+    // The whole tile and its variants.
+    TerrainAlias whole;
+} TerrainTiles;
+
+typedef struct Terrain {
+    uint32_t seed;
+    // Cells of the hand-painted map, generation leaves them empty.
+    int map_width, map_height;
+    // The map's layer of every kind, NULL where it has none.
+    const uint16_t *map_layers[TERRAIN_KIND_COUNT];
+    TerrainTiles tiles[TERRAIN_KIND_COUNT];
+    Autotile autotile;
+} Terrain;
+
+// Finds the tilesets and map layers of every kind by name and builds their tables. Keeps pointing
+// into the map.
+void terrain_init(Terrain *terrain, const TmxMap *map, uint32_t seed);
+
+bool terrain_is_on_map(const Terrain *terrain, int x, int y);
+// Whether the map has `kind` on a cell of it.
+bool terrain_map_has(const Terrain *terrain, TerrainKind kind, int x, int y);
+// Gid for a cell of `kind`, given which of its neighbours have it too as a mask of AutotileNeighbour
+// bits. Whole cells get the variant the generator gives them.
+uint16_t terrain_tile(const Terrain *terrain, TerrainKind kind, int x, int y, uint8_t mask);
+
+// Generates cells [x, x + width) by [y, y + height) of the world into one row major array of
+// width * height gids per kind, 0 for nothing. Water goes under everything like on the map, the
+// other kinds are on top of grass.
+void terrain_generate(const Terrain *terrain, int x, int y, int width, int height, uint16_t *const gids[TERRAIN_KIND_COUNT]);
+
+#endif // TERRAIN_H_
@@ -0,0 +1,181 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <raylib.h>
+
+#include "tilechunks.h"
+
+bool tile_chunks_init(TileChunks *chunks, const TmxMap *map) {
+    memset(chunks, 0, sizeof(*chunks));
+    chunks->map = map;
+    chunks->cols = (map->width + TILE_CHUNK_CELLS - 1) / TILE_CHUNK_CELLS;
+    chunks->rows = (map->height + TILE_CHUNK_CELLS - 1) / TILE_CHUNK_CELLS;
+
+    chunks->tileset_sheets = malloc((map->tilesets.count ? map->tilesets.count : 1) * sizeof(int));
+    chunks->items = calloc((size_t)chunks->cols * chunks->rows, sizeof(TileChunk));
+    assert(chunks->tileset_sheets != NULL && chunks->items != NULL && "Buy more RAM lol");
+
+    for (size_t i = 0; i < map->tilesets.count; i++) {
+        const TmxTileset *tileset = &map->tilesets.items[i];
+        chunks->tileset_sheets[i] = atlas_find_source(tileset->image);
+        if (chunks->tileset_sheets[i] < 0) {
+            TraceLog(LOG_WARNING, "tileset %s (%s) is not in the atlas, its tiles won't be drawn", tileset->name, tileset->image);
+        }
+    }
+
+    for (int i = 0; i < chunks->cols * chunks->rows; i++) {
+        TileChunk *chunk = &chunks->items[i];
+        chunk->target = LoadRenderTexture(TILE_CHUNK_CELLS * map->tilewidth, TILE_CHUNK_CELLS * map->tileheight);
+        if (chunk->target.id == 0) {
+            TraceLog(LOG_ERROR, "could not create the render texture for tile chunk %d", i);
+            tile_chunks_free(chunks);
+            return false;
+        }
+        chunk->dirty = true;
+    }
+
+    return true;
+}
+
+void tile_chunks_free(TileChunks *chunks) {
+    if (chunks->items != NULL) {
+        for (int i = 0; i < chunks->cols * chunks->rows; i++) {
+            if (chunks->items[i].target.id != 0) UnloadRenderTexture(chunks->items[i].target);
+        }
+    }
+    free(chunks->items);
+    free(chunks->tileset_sheets);
+    memset(chunks, 0, sizeof(*chunks));
+}
+
+// Queues the tile `gid` stands for into SPRITE_LAYER_MAP with its top left corner at `pos`, every
+// pixel of it `scale` wide, if its tileset is in the atlas.
+static void tile_chunks_queue_gid(const TileChunks *chunks, SpriteBatch *batch, uint16_t gid, Vector2 pos, float scale) {
+    const TmxMap *map = chunks->map;
+    const TmxTileset *tileset = tmx_tileset_for_gid(map, gid);
+    if (tileset == NULL || tileset->columns == 0) return;
+    const int sheet = chunks->tileset_sheets[tileset - map->tilesets.items];
+    if (sheet < 0) return;
+
+    const uint32_t local = gid - tileset->firstgid;
+    sprite_batch_draw(
+        batch,
+        SPRITE_LAYER_MAP,
+        sheet,
+        (Rectangle) {
+            (local % tileset->columns) * tileset->tilewidth,
+            (local / tileset->columns) * tileset->tileheight,
+            tileset->tilewidth,
+            tileset->tileheight,
+        },
+        (Rectangle) { pos.x, pos.y, tileset->tilewidth * scale, tileset->tileheight * scale },
+        (Vector2) { 0 },
+        WHITE
+    );
+}
+
+static void tile_chunk_render(const TileChunks *chunks, SpriteBatch *batch, int cx, int cy) {
+    const TmxMap *map = chunks->map;
+    const int x0 = cx * TILE_CHUNK_CELLS;
+    const int y0 = cy * TILE_CHUNK_CELLS;
+    const int x1 = x0 + TILE_CHUNK_CELLS < map->width ? x0 + TILE_CHUNK_CELLS : map->width;
+    const int y1 = y0 + TILE_CHUNK_CELLS < map->height ? y0 + TILE_CHUNK_CELLS : map->height;
+
+    // Layers in map order, the batch keeps the queue order within a layer.
+    for (size_t l = 0; l < map->layers.count; l++) {
+        const uint16_t *gids = map->layers.items[l].gids;
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                const uint16_t gid = gids[x + y * map->width];
+                if (gid == 0) continue;
+
+                tile_chunks_queue_gid(chunks, batch, gid, (Vector2) { (x - x0) * map->tilewidth, (y - y0) * map->tileheight }, 1.0f);
+            }
+        }
+    }
+}
+
+int tile_chunks_update(TileChunks *chunks, SpriteBatch *batch) {
+    int rendered = 0;
+    for (int cy = 0; cy < chunks->rows; cy++) {
+        for (int cx = 0; cx < chunks->cols; cx++) {
+            TileChunk *chunk = &chunks->items[cy * chunks->cols + cx];
+            if (!chunk->dirty) continue;
+
+            BeginTextureMode(chunk->target);
+            ClearBackground(BLANK);
+            tile_chunk_render(chunks, batch, cx, cy);
+            sprite_batch_flush(batch);
+            EndTextureMode();
+
+            chunk->dirty = false;
+            rendered++;
+        }
+    }
+    return rendered;
+}
+
+int tile_chunks_draw(const TileChunks *chunks, SpriteBatch *batch, Rectangle visible, float scale) {
+    const float chunk_width = TILE_CHUNK_CELLS * chunks->map->tilewidth * scale;
+    const float chunk_height = TILE_CHUNK_CELLS * chunks->map->tileheight * scale;
+
+    int cx0 = (int)floorf(visible.x / chunk_width);
+    int cy0 = (int)floorf(visible.y / chunk_height);
+    int cx1 = (int)ceilf((visible.x + visible.width) / chunk_width);
+    int cy1 = (int)ceilf((visible.y + visible.height) / chunk_height);
+    if (cx0 < 0) cx0 = 0;
+    if (cy0 < 0) cy0 = 0;
+    if (cx1 > chunks->cols) cx1 = chunks->cols;
+    if (cy1 > chunks->rows) cy1 = chunks->rows;
+
+    int drawn = 0;
+    for (int cy = cy0; cy < cy1; cy++) {
+        for (int cx = cx0; cx < cx1; cx++) {
+            const Texture2D texture = chunks->items[cy * chunks->cols + cx].target.texture;
+            sprite_batch_draw_texture(
+                batch,
+                SPRITE_LAYER_MAP,
+                texture,
+                // Render textures come out upside down.
+                (Rectangle) { 0.0f, 0.0f, texture.width, -texture.height },
+                (Rectangle) { cx * chunk_width, cy * chunk_height, chunk_width, chunk_height },
+                (Vector2) { 0 },
+                WHITE
+            );
+            drawn++;
+        }
+    }
+    return drawn;
+}
+
+int tile_chunks_draw_pages(const TileChunks *chunks, SpriteBatch *batch, const WorldPages *pages, Rectangle visible, float scale) {
+    const float cell_width = chunks->map->tilewidth * scale;
+    const float cell_height = chunks->map->tileheight * scale;
+    const int x0 = (int)floorf(visible.x / cell_width);
+    const int y0 = (int)floorf(visible.y / cell_height);
+    const int x1 = (int)ceilf((visible.x + visible.width) / cell_width);
+    const int y1 = (int)ceilf((visible.y + visible.height) / cell_height);
+
+    int drawn = 0;
+    for (int y = y0; y < y1; y++) {
+        const Page *page = NULL;
+        for (int x = x0; x < x1; x++) {
+            const int page_x = page_of_cell(x);
+            const int page_y = page_of_cell(y);
+            if (page == NULL || page->x != page_x || page->y != page_y) page = pages_peek(pages, page_x, page_y);
+            // Not streamed in yet, the player is nowhere near it.
+            if (page == NULL) continue;
+
+            const int i = (x - page_x * PAGE_CELLS) + (y - page_y * PAGE_CELLS) * PAGE_CELLS;
+            for (int l = 0; l < PAGE_LAYERS; l++) {
+                const uint16_t gid = page->gids[l][i];
+                if (gid == 0) continue;
+
+                tile_chunks_queue_gid(chunks, batch, gid, (Vector2) { x * cell_width, y * cell_height }, scale);
+                drawn++;
+            }
+        }
+    }
+    return drawn;
+}
@@ -0,0 +1,49 @@
+#ifndef TILECHUNKS_H_
+#define TILECHUNKS_H_
+
+#include <stdbool.h>
+#include <raylib.h>
+
+#include "pages.h"
+#include "sprites.h"
+#include "tmx.h"
+
+// The tile layers of the map, cut into TILE_CHUNK_CELLS sized squares that are each rendered into
+// their own RenderTexture2D once and then drawn as a single quad. The map never changes while the
+// game runs, and only chunks on screen get drawn, so the per frame cost depends on the size of the
+// screen and not on the size of the map.
+//
+// The streamed terrain around the map (see pages.h) comes and goes as the player walks, so that
+// one is queued tile by tile every frame instead, off the same tilesets.
+
+#define TILE_CHUNK_CELLS 16
+
+typedef struct TileChunk {
+    RenderTexture2D target;
+    // Not rendered yet.
+    bool dirty;
+} TileChunk;
+
+typedef struct TileChunks {
+    const TmxMap *map;
+    // In chunks.
+    int cols, rows;
+    TileChunk *items;
+    // AtlasSheet of every tileset of the map, or -1 if the tileset image isn't in the atlas.
+    int *tileset_sheets;
+} TileChunks;
+
+bool tile_chunks_init(TileChunks *chunks, const TmxMap *map);
+void tile_chunks_free(TileChunks *chunks);
+
+// Renders the chunks that aren't rendered yet through `batch`, returns how many there were. Call
+// outside of BeginDrawing() and with nothing queued in the batch.
+int tile_chunks_update(TileChunks *chunks, SpriteBatch *batch);
+// Queues the chunks overlapping `visible` (world coordinates) into SPRITE_LAYER_MAP, with every
+// map pixel `scale` world units wide. Returns how many it queued.
+int tile_chunks_draw(const TileChunks *chunks, SpriteBatch *batch, Rectangle visible, float scale);
+// Queues the tiles of the pages overlapping `visible` that are streamed in, same layer and scale as
+// tile_chunks_draw(). Returns how many tiles it queued.
+int tile_chunks_draw_pages(const TileChunks *chunks, SpriteBatch *batch, const WorldPages *pages, Rectangle visible, float scale);
+
+#endif // TILECHUNKS_H_
@@ -0,0 +1,87 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "tilemask.h"
+
+void tile_mask_init(TileMask *mask, int cols, int rows) {
+    assert(cols > 0 && rows > 0);
+    mask->cols = cols;
+    mask->rows = rows;
+    mask->words_per_row = (cols + 63) / 64;
+    mask->bits = calloc((size_t)mask->words_per_row * rows, sizeof(uint64_t));
+    assert(mask->bits != NULL && "Buy more RAM lol");
+}
+
+void tile_mask_free(TileMask *mask) {
+    free(mask->bits);
+    memset(mask, 0, sizeof(*mask));
+}
+
+#ifdef _MSC_VER
+static int tile_mask_popcount(uint64_t bits) { return (int)__popcnt64(bits); }
+// `bits` can't be 0.
+static int tile_mask_ctz(uint64_t bits) {
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+}
+#else
+static int tile_mask_popcount(uint64_t bits) { return __builtin_popcountll(bits); }
+// `bits` can't be 0.
+static int tile_mask_ctz(uint64_t bits) { return __builtin_ctzll(bits); }
+#endif
+
+static bool tile_mask_clamp_rect(const TileMask *mask, int *x0, int *y0, int *x1, int *y1) {
+    if (*x0 < 0) *x0 = 0;
+    if (*y0 < 0) *y0 = 0;
+    if (*x1 > mask->cols) *x1 = mask->cols;
+    if (*y1 > mask->rows) *y1 = mask->rows;
+    return *x0 < *x1 && *y0 < *y1;
+}
+
+// Bits [x0, x1) of word `w` in a row, everything else masked off.
+static uint64_t tile_mask_span(int w, int x0, int x1) {
+    const int lo = w * 64;
+    uint64_t bits = ~(uint64_t)0;
+    if (x0 > lo) bits &= ~(uint64_t)0 << (x0 - lo);
+    if (x1 < lo + 64) bits &= ~(uint64_t)0 >> (lo + 64 - x1);
+    return bits;
+}
+
+int tile_mask_count_rect(const TileMask *mask, int x0, int y0, int x1, int y1) {
+    if (!tile_mask_clamp_rect(mask, &x0, &y0, &x1, &y1)) return 0;
+
+    int count = 0;
+    for (int y = y0; y < y1; y++) {
+        const uint64_t *row = &mask->bits[y * mask->words_per_row];
+        for (int w = x0 >> 6; w <= (x1 - 1) >> 6; w++) {
+            count += tile_mask_popcount(row[w] & tile_mask_span(w, x0, x1));
+        }
+    }
+    return count;
+}
+
+int tile_mask_query_rect(const TileMask *mask, int x0, int y0, int x1, int y1, int *out, int cap) {
+    if (!tile_mask_clamp_rect(mask, &x0, &y0, &x1, &y1)) return 0;
+
+    int found = 0;
+    for (int y = y0; y < y1; y++) {
+        const uint64_t *row = &mask->bits[y * mask->words_per_row];
+        for (int w = x0 >> 6; w <= (x1 - 1) >> 6; w++) {
+            // Pop set bits off the bottom of the word until it's empty.
+            uint64_t bits = row[w] & tile_mask_span(w, x0, x1);
+            while (bits != 0) {
+                if (found == cap) return found;
+                const int x = w * 64 + tile_mask_ctz(bits);
+                out[found++] = x + y * mask->cols;
+                bits &= bits - 1;
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,47 @@
+#ifndef TILEMASK_H_
+#define TILEMASK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// One bit per cell of the map, for per-tile properties like "farmable" or "solid". Rows are padded
+// to whole 64 bit words so rect queries can go a word (64 cells) at a time instead of per cell.
+
+typedef struct TileMask {
+    int cols, rows;
+    int words_per_row;
+    uint64_t *bits;
+} TileMask;
+
+void tile_mask_init(TileMask *mask, int cols, int rows);
+void tile_mask_free(TileMask *mask);
+
+// Rect queries take cells [x0, x1) x [y0, y1) and clamp them to the mask.
+int tile_mask_count_rect(const TileMask *mask, int x0, int y0, int x1, int y1);
+// Writes the cell ids (`x + y * cols`) of up to `cap` set cells in the rect into `out`, in row
+// major order, and returns how many it wrote.
+int tile_mask_query_rect(const TileMask *mask, int x0, int y0, int x1, int y1, int *out, int cap);
+
+static inline uint64_t *tile_mask_word(const TileMask *mask, int x, int y) {
+    return &mask->bits[y * mask->words_per_row + (x >> 6)];
+}
+
+static inline bool tile_mask_test(const TileMask *mask, int x, int y) {
+    if (x < 0 || y < 0 || x >= mask->cols || y >= mask->rows) return false;
+    return (*tile_mask_word(mask, x, y) >> (x & 63)) & 1;
+}
+
+static inline bool tile_mask_test_id(const TileMask *mask, int cell_id) {
+    if (cell_id < 0) return false;
+    return tile_mask_test(mask, cell_id % mask->cols, cell_id / mask->cols);
+}
+
+static inline void tile_mask_set(TileMask *mask, int x, int y) {
+    *tile_mask_word(mask, x, y) |= (uint64_t)1 << (x & 63);
+}
+
+static inline void tile_mask_clear(TileMask *mask, int x, int y) {
+    *tile_mask_word(mask, x, y) &= ~((uint64_t)1 << (x & 63));
+}
+
+#endif // TILEMASK_H_
@@ -0,0 +1,184 @@
+#include <assert.h>
+#include <string.h>
+
+#include "nob.h"
+#include "timers.h"
+
+#define TIMER_LIST_OVERFLOW (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+#define TIMER_LIST_EXPIRING (TIMER_LIST_OVERFLOW + 1)
+#define TIMER_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+void timer_wheel_init(TimerWheel *wheel, uint64_t now) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now = now;
+    wheel->free_list = -1;
+    for (size_t i = 0; i < NOB_ARRAY_LEN(wheel->heads); i++) {
+        wheel->heads[i] = -1;
+        wheel->tails[i] = -1;
+    }
+}
+
+void timer_wheel_free(TimerWheel *wheel) {
+    nob_da_free(wheel->pool);
+    memset(wheel, 0, sizeof(*wheel));
+}
+
+static void timer_list_push(TimerWheel *wheel, int list, int index) {
+    Timer *timer = &wheel->pool.items[index];
+    timer->list = list;
+    timer->next = -1;
+    timer->prev = wheel->tails[list];
+    if (timer->prev >= 0) {
+        wheel->pool.items[timer->prev].next = index;
+    } else {
+        wheel->heads[list] = index;
+    }
+    wheel->tails[list] = index;
+}
+
+static void timer_list_remove(TimerWheel *wheel, int index) {
+    Timer *timer = &wheel->pool.items[index];
+    if (timer->prev >= 0) {
+        wheel->pool.items[timer->prev].next = timer->next;
+    } else {
+        wheel->heads[timer->list] = timer->next;
+    }
+    if (timer->next >= 0) {
+        wheel->pool.items[timer->next].prev = timer->prev;
+    } else {
+        wheel->tails[timer->list] = timer->prev;
+    }
+    timer->prev = timer->next = -1;
+    timer->list = -1;
+}
+
+// The list a timer due at `due` belongs in, seen from `wheel->now`. Has to be called with
+// `due >= wheel->now`, cascading within the tick being processed lands right in its slot.
+static int timer_list_for(const TimerWheel *wheel, uint64_t due) {
+    assert(due >= wheel->now);
+    const uint64_t delta = due - wheel->now;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        const int shift = level * TIMER_WHEEL_BITS;
+        if (delta < (uint64_t)TIMER_WHEEL_SLOTS << shift) {
+            return level * TIMER_WHEEL_SLOTS + (int)((due >> shift) & TIMER_SLOT_MASK);
+        }
+    }
+    return TIMER_LIST_OVERFLOW;
+}
+
+static void timer_release(TimerWheel *wheel, int index) {
+    Timer *timer = &wheel->pool.items[index];
+    timer->generation++;
+    // Generation 0 would make the id of pool entry 0 look like "no timer".
+    if (timer->generation == 0) timer->generation = 1;
+    timer->callback = NULL;
+    timer->list = -1;
+    timer->next = wheel->free_list;
+    wheel->free_list = index;
+    wheel->pending--;
+}
+
+TimerId timer_schedule(TimerWheel *wheel, uint64_t due, TimerCallback callback, void *ctx, uint32_t data) {
+    assert(callback != NULL);
+    // Anything already due goes in the very next slot.
+    if (due <= wheel->now) due = wheel->now + 1;
+
+    int index = wheel->free_list;
+    if (index >= 0) {
+        wheel->free_list = wheel->pool.items[index].next;
+    } else {
+        const Timer fresh = { .generation = 1, .list = -1 };
+        nob_da_append(&wheel->pool, fresh);
+        index = (int)wheel->pool.count - 1;
+    }
+
+    Timer *timer = &wheel->pool.items[index];
+    timer->due = due;
+    timer->callback = callback;
+    timer->ctx = ctx;
+    timer->data = data;
+    timer_list_push(wheel, timer_list_for(wheel, due), index);
+    wheel->pending++;
+
+    return ((TimerId)timer->generation << 32) | (uint32_t)index;
+}
+
+static int timer_index(const TimerWheel *wheel, TimerId id) {
+    const uint32_t index = (uint32_t)id;
+    const uint32_t generation = (uint32_t)(id >> 32);
+    if (id == 0 || index >= wheel->pool.count) return -1;
+
+    const Timer *timer = &wheel->pool.items[index];
+    if (timer->generation != generation || timer->list < 0) return -1;
+    return (int)index;
+}
+
+bool timer_is_pending(const TimerWheel *wheel, TimerId id) {
+    return timer_index(wheel, id) >= 0;
+}
+
+uint64_t timer_due(const TimerWheel *wheel, TimerId id) {
+    const int index = timer_index(wheel, id);
+    return index >= 0 ? wheel->pool.items[index].due : 0;
+}
+
+bool timer_cancel(TimerWheel *wheel, TimerId id) {
+    const int index = timer_index(wheel, id);
+    if (index < 0) return false;
+
+    timer_list_remove(wheel, index);
+    timer_release(wheel, index);
+    return true;
+}
+
+// Moves every timer of `list` to wherever it belongs now that time moved on.
+static void timer_cascade(TimerWheel *wheel, int list) {
+    int index = wheel->heads[list];
+    while (index >= 0) {
+        const int next = wheel->pool.items[index].next;
+        timer_list_remove(wheel, index);
+        timer_list_push(wheel, timer_list_for(wheel, wheel->pool.items[index].due), index);
+        index = next;
+    }
+}
+
+int timer_wheel_advance(TimerWheel *wheel, uint64_t now) {
+    int fired = 0;
+
+    while (wheel->now < now) {
+        const uint64_t tick = ++wheel->now;
+
+        // Level 0 wrapped around, bring the next stretch of level 1 down, and so on up the levels.
+        for (int level = 1; level <= TIMER_WHEEL_LEVELS; level++) {
+            const int shift = level * TIMER_WHEEL_BITS;
+            if ((tick & (((uint64_t)1 << shift) - 1)) != 0) break;
+
+            if (level == TIMER_WHEEL_LEVELS) {
+                timer_cascade(wheel, TIMER_LIST_OVERFLOW);
+            } else {
+                timer_cascade(wheel, level * TIMER_WHEEL_SLOTS + (int)((tick >> shift) & TIMER_SLOT_MASK));
+            }
+        }
+
+        // Move the slot over to the expiring list first so callbacks scheduling into this tick
+        // (or cancelling something that's about to fire) don't trip over the iteration.
+        const int slot = (int)(tick & TIMER_SLOT_MASK);
+        int index = wheel->heads[slot];
+        while (index >= 0) {
+            const int next = wheel->pool.items[index].next;
+            timer_list_remove(wheel, index);
+            timer_list_push(wheel, TIMER_LIST_EXPIRING, index);
+            index = next;
+        }
+
+        while ((index = wheel->heads[TIMER_LIST_EXPIRING]) >= 0) {
+            const Timer timer = wheel->pool.items[index];
+            timer_list_remove(wheel, index);
+            timer_release(wheel, index);
+            timer.callback(timer.ctx, timer.data, tick);
+            fired++;
+        }
+    }
+
+    return fired;
+}
@@ -0,0 +1,68 @@
+#ifndef TIMERS_H_
+#define TIMERS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Hierarchical timer wheel on simulation ticks. Timers live in slots of TIMER_WHEEL_LEVELS wheels
+// of TIMER_WHEEL_SLOTS each: level 0 has one slot per tick for the next 64 ticks, level 1 one slot
+// per 64 ticks for the next 64^2 and so on, anything further out waits in an overflow list. Every
+// tick only the current level 0 slot is looked at, and the slots of the higher levels get spread
+// down a level whenever the one below wraps around. So a tick costs as much as the timers expiring
+// in it (plus the occasional cascade), no matter how many are pending.
+//
+// Timers are kept in a pool and linked by index, a TimerId stays valid (and safe to cancel) after
+// the timer fired or got cancelled, it just stops matching anything.
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+// `ctx` and `data` are whatever was passed to timer_schedule(), `now` is the tick it fired on.
+typedef void (*TimerCallback)(void *ctx, uint32_t data, uint64_t now);
+
+// Pool index in the low 32 bits, generation in the high ones. 0 is never a valid timer.
+typedef uint64_t TimerId;
+
+typedef struct Timer {
+    uint64_t due;
+    TimerCallback callback;
+    void *ctx;
+    uint32_t data;
+    // Bumped every time the pool entry gets reused.
+    uint32_t generation;
+    // Neighbours in whatever list the timer is in, -1 at the ends.
+    int prev, next;
+    // Which list that is, -1 when the entry is free.
+    int list;
+} Timer;
+
+typedef struct TimerWheel {
+    uint64_t now;
+    struct { Timer *items; size_t count, capacity; } pool;
+    int free_list;
+    // The slots of every level, then the overflow list, then the list of timers expiring right
+    // now. -1 is empty.
+    int heads[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS + 2];
+    int tails[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS + 2];
+    size_t pending;
+} TimerWheel;
+
+void timer_wheel_init(TimerWheel *wheel, uint64_t now);
+void timer_wheel_free(TimerWheel *wheel);
+
+// Fires on the first timer_wheel_advance() that reaches `due`. Due times that already passed fire
+// on the next tick.
+TimerId timer_schedule(TimerWheel *wheel, uint64_t due, TimerCallback callback, void *ctx, uint32_t data);
+// Returns whether the timer was still pending. Fine to call with 0 or a stale id.
+bool timer_cancel(TimerWheel *wheel, TimerId id);
+bool timer_is_pending(const TimerWheel *wheel, TimerId id);
+// Tick the timer is going to fire on, 0 if it isn't pending.
+uint64_t timer_due(const TimerWheel *wheel, TimerId id);
+
+// Steps the wheel one tick at a time up to `now`, running the callbacks of everything that comes
+// due on the way. Callbacks may schedule and cancel timers. Returns how many fired.
+int timer_wheel_advance(TimerWheel *wheel, uint64_t now);
+
+#endif // TIMERS_H_
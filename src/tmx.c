@@ -0,0 +1,356 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <expat.h>
+
+#include "nob.h"
+#include "tmx.h"
+
+#define TMX_READ_CHUNK 4096
+
+typedef struct TmxParser {
+    XML_Parser xml;
+    const char *path;
+    // Directory of `path`, with the trailing slash. Tileset and image sources are relative to it.
+    char dir[TMX_PATH_CAP];
+    TmxMap *map;
+    bool ok;
+    // Parsing a .tsx on behalf of the map, only the tileset itself is of interest.
+    bool tsx;
+
+    // Set while inside the <data> of a layer, characters get collected into `csv`.
+    bool in_data;
+    Nob_String_Builder csv;
+    // Set while inside an <objectgroup>.
+    int group;
+    // Set while inside a <tileset>, either inline in the map or the root of a .tsx.
+    TmxTileset *tileset;
+    // Gid of the <tile> we are inside of, 0 outside of one.
+    uint32_t tile_gid;
+} TmxParser;
+
+static const struct {
+    const char *name;
+    TmxTileFlag flag;
+} tmx_tile_properties[] = {
+    { "solid", TMX_TILE_SOLID },
+    { "water", TMX_TILE_WATER },
+    { "farmable", TMX_TILE_FARMABLE },
+    { "tillable", TMX_TILE_TILLABLE },
+};
+
+static bool tmx_parse_file(TmxParser *parser, const char *path);
+
+static void tmx_error(TmxParser *parser, const char *message, const char *detail) {
+    fprintf(stderr, "%s:%lu: ERROR: %s%s\n",
+        parser->path,
+        (unsigned long)XML_GetCurrentLineNumber(parser->xml),
+        message,
+        detail ? detail : "");
+    parser->ok = false;
+    XML_StopParser(parser->xml, XML_FALSE);
+}
+
+static const char *tmx_attr(const char **attr, const char *name) {
+    for (int i = 0; attr[i] != NULL; i += 2) {
+        if (strcmp(attr[i], name) == 0) return attr[i + 1];
+    }
+    return NULL;
+}
+
+static float tmx_attr_float(const char **attr, const char *name) {
+    const char *value = tmx_attr(attr, name);
+    return value ? strtof(value, NULL) : 0.0f;
+}
+
+static uint32_t tmx_attr_uint(const char **attr, const char *name) {
+    const char *value = tmx_attr(attr, name);
+    return value ? (uint32_t)strtoul(value, NULL, 10) : 0;
+}
+
+static void tmx_copy_name(char *dst, const char *src) {
+    snprintf(dst, TMX_NAME_CAP, "%s", src ? src : "");
+}
+
+static void tmx_dirname(char *dst, const char *path) {
+    const char *slash = strrchr(path, '/');
+    const size_t len = slash ? (size_t)(slash - path + 1) : 0;
+    snprintf(dst, TMX_PATH_CAP, "%.*s", (int)len, path);
+}
+
+static void tmx_tile_property(TmxParser *parser, const char **attr) {
+    const char *name = tmx_attr(attr, "name");
+    const char *type = tmx_attr(attr, "type");
+    const char *value = tmx_attr(attr, "value");
+    if (name == NULL || type == NULL || strcmp(type, "bool") != 0) return;
+    if (value == NULL || strcmp(value, "true") != 0) return;
+
+    for (size_t i = 0; i < NOB_ARRAY_LEN(tmx_tile_properties); i++) {
+        if (strcmp(tmx_tile_properties[i].name, name) != 0) continue;
+
+        TmxMap *map = parser->map;
+        while (map->tile_flags.count <= parser->tile_gid) nob_da_append(&map->tile_flags, 0);
+        map->tile_flags.items[parser->tile_gid] |= tmx_tile_properties[i].flag;
+        return;
+    }
+}
+
+static void tmx_layer_finish(TmxParser *parser) {
+    TmxMap *map = parser->map;
+    TmxLayer *layer = &map->layers.items[map->layers.count - 1];
+    const size_t cells = (size_t)map->width * map->height;
+
+    nob_sb_append_null(&parser->csv);
+    const char *cursor = parser->csv.items;
+    for (size_t i = 0; i < cells; i++) {
+        char *end = NULL;
+        const unsigned long gid = strtoul(cursor, &end, 10) & TMX_GID_MASK;
+        if (end == cursor) {
+            tmx_error(parser, "layer data is shorter than the map in layer ", layer->name);
+            return;
+        }
+        if (gid > UINT16_MAX) {
+            tmx_error(parser, "gid does not fit in 16 bits in layer ", layer->name);
+            return;
+        }
+        layer->gids[i] = (uint16_t)gid;
+
+        cursor = end;
+        while (*cursor == ',' || *cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t') {
+            cursor++;
+        }
+    }
+}
+
+static void XMLCALL tmx_start(void *data, const char *el, const char **attr) {
+    TmxParser *parser = data;
+    TmxMap *map = parser->map;
+
+    if (strcmp(el, "map") == 0) {
+        const char *orientation = tmx_attr(attr, "orientation");
+        if (orientation && strcmp(orientation, "orthogonal") != 0) {
+            tmx_error(parser, "only orthogonal maps are supported, got ", orientation);
+            return;
+        }
+        if (tmx_attr_uint(attr, "infinite") != 0) {
+            tmx_error(parser, "infinite maps are not supported", NULL);
+            return;
+        }
+        map->width = tmx_attr_uint(attr, "width");
+        map->height = tmx_attr_uint(attr, "height");
+        map->tilewidth = tmx_attr_uint(attr, "tilewidth");
+        map->tileheight = tmx_attr_uint(attr, "tileheight");
+    } else if (strcmp(el, "tileset") == 0) {
+        const char *source = tmx_attr(attr, "source");
+
+        // The root of a .tsx, the entry in the map was already appended.
+        if (parser->tileset != NULL) {
+            TmxTileset *tileset = parser->tileset;
+            tmx_copy_name(tileset->name, tmx_attr(attr, "name"));
+            tileset->tilewidth = tmx_attr_uint(attr, "tilewidth");
+            tileset->tileheight = tmx_attr_uint(attr, "tileheight");
+            tileset->tilecount = tmx_attr_uint(attr, "tilecount");
+            tileset->columns = tmx_attr_uint(attr, "columns");
+            return;
+        }
+
+        TmxTileset tileset = { .firstgid = tmx_attr_uint(attr, "firstgid") };
+        nob_da_append(&map->tilesets, tileset);
+        parser->tileset = &map->tilesets.items[map->tilesets.count - 1];
+
+        if (source == NULL) {
+            // Inline tileset, same attributes as the root of a .tsx.
+            tmx_start(data, el, attr);
+        } else {
+            char tsx_path[TMX_PATH_CAP];
+            snprintf(tsx_path, sizeof(tsx_path), "%s%s", parser->dir, source);
+
+            TmxParser tsx = {
+                .path = tsx_path,
+                .map = map,
+                .ok = true,
+                .tsx = true,
+                .group = -1,
+                .tileset = parser->tileset,
+            };
+            if (!tmx_parse_file(&tsx, tsx_path)) {
+                tmx_error(parser, "could not load tileset ", tsx_path);
+                return;
+            }
+        }
+    } else if (strcmp(el, "image") == 0 && parser->tileset != NULL) {
+        snprintf(parser->tileset->image, TMX_PATH_CAP, "%s%s", parser->dir, tmx_attr(attr, "source"));
+        parser->tileset->image_width = tmx_attr_uint(attr, "width");
+        parser->tileset->image_height = tmx_attr_uint(attr, "height");
+    } else if (strcmp(el, "tile") == 0 && parser->tileset != NULL) {
+        parser->tile_gid = parser->tileset->firstgid + tmx_attr_uint(attr, "id");
+        if (tmx_attr(attr, "probability") != NULL) {
+            TmxMap *map = parser->map;
+            while (map->tile_probabilities.count <= parser->tile_gid) nob_da_append(&map->tile_probabilities, -1.0f);
+            map->tile_probabilities.items[parser->tile_gid] = tmx_attr_float(attr, "probability");
+        }
+    } else if (strcmp(el, "property") == 0 && parser->tile_gid != 0) {
+        tmx_tile_property(parser, attr);
+    } else if (parser->tsx) {
+        // Per tile collision shapes and such, nothing we use yet.
+        return;
+    } else if (strcmp(el, "layer") == 0) {
+        if (tmx_attr_uint(attr, "width") != (uint32_t)map->width || tmx_attr_uint(attr, "height") != (uint32_t)map->height) {
+            tmx_error(parser, "layers have to be the size of the map: ", tmx_attr(attr, "name"));
+            return;
+        }
+        TmxLayer layer = { .gids = calloc((size_t)map->width * map->height, sizeof(uint16_t)) };
+        assert(layer.gids != NULL && "Buy more RAM lol");
+        tmx_copy_name(layer.name, tmx_attr(attr, "name"));
+        nob_da_append(&map->layers, layer);
+    } else if (strcmp(el, "data") == 0) {
+        const char *encoding = tmx_attr(attr, "encoding");
+        if (encoding == NULL || strcmp(encoding, "csv") != 0) {
+            tmx_error(parser, "only csv layer data is supported, got ", encoding ? encoding : "xml");
+            return;
+        }
+        parser->in_data = true;
+        parser->csv.count = 0;
+    } else if (strcmp(el, "objectgroup") == 0) {
+        TmxObjectGroup group = { 0 };
+        tmx_copy_name(group.name, tmx_attr(attr, "name"));
+        nob_da_append(&map->object_groups, group);
+        parser->group = map->object_groups.count - 1;
+    } else if (strcmp(el, "object") == 0 && parser->group >= 0) {
+        const TmxObject object = {
+            .id = tmx_attr_uint(attr, "id"),
+            .group = parser->group,
+            .x = tmx_attr_float(attr, "x"),
+            .y = tmx_attr_float(attr, "y"),
+            .width = tmx_attr_float(attr, "width"),
+            .height = tmx_attr_float(attr, "height"),
+        };
+        nob_da_append(&map->objects, object);
+    }
+}
+
+static void XMLCALL tmx_end(void *data, const char *el) {
+    TmxParser *parser = data;
+
+    if (strcmp(el, "data") == 0 && parser->in_data) {
+        parser->in_data = false;
+        tmx_layer_finish(parser);
+    } else if (strcmp(el, "objectgroup") == 0) {
+        parser->group = -1;
+    } else if (strcmp(el, "tileset") == 0) {
+        parser->tileset = NULL;
+    } else if (strcmp(el, "tile") == 0) {
+        parser->tile_gid = 0;
+    }
+}
+
+static void XMLCALL tmx_characters(void *data, const char *s, int len) {
+    TmxParser *parser = data;
+    if (parser->in_data) nob_sb_append_buf(&parser->csv, s, len);
+}
+
+static bool tmx_parse_file(TmxParser *parser, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    tmx_dirname(parser->dir, path);
+    parser->xml = XML_ParserCreate(NULL);
+    XML_SetElementHandler(parser->xml, tmx_start, tmx_end);
+    XML_SetCharacterDataHandler(parser->xml, tmx_characters);
+    XML_SetUserData(parser->xml, parser);
+
+    // Stream the file through expat instead of reading all of it up front.
+    char buf[TMX_READ_CHUNK];
+    bool done = false;
+    while (parser->ok && !done) {
+        const size_t n = fread(buf, 1, sizeof(buf), f);
+        done = n < sizeof(buf);
+        if (XML_Parse(parser->xml, buf, (int)n, done) == XML_STATUS_ERROR) {
+            // tmx_error() stops the parser, which shows up here as an error too.
+            if (parser->ok) {
+                fprintf(stderr, "%s:%lu: ERROR: %s\n", path,
+                    (unsigned long)XML_GetCurrentLineNumber(parser->xml),
+                    XML_ErrorString(XML_GetErrorCode(parser->xml)));
+                parser->ok = false;
+            }
+        }
+    }
+
+    XML_ParserFree(parser->xml);
+    nob_sb_free(parser->csv);
+    fclose(f);
+    return parser->ok;
+}
+
+bool tmx_load(const char *path, TmxMap *map) {
+    memset(map, 0, sizeof(*map));
+
+    TmxParser parser = {
+        .path = path,
+        .map = map,
+        .ok = true,
+        .group = -1,
+    };
+
+    if (!tmx_parse_file(&parser, path)) {
+        tmx_free(map);
+        return false;
+    }
+
+    return true;
+}
+
+void tmx_free(TmxMap *map) {
+    for (size_t i = 0; i < map->layers.count; i++) {
+        free(map->layers.items[i].gids);
+    }
+    nob_da_free(map->layers);
+    nob_da_free(map->object_groups);
+    nob_da_free(map->objects);
+    nob_da_free(map->tilesets);
+    nob_da_free(map->tile_flags);
+    nob_da_free(map->tile_probabilities);
+    memset(map, 0, sizeof(*map));
+}
+
+const TmxLayer *tmx_find_layer(const TmxMap *map, const char *name) {
+    for (size_t i = 0; i < map->layers.count; i++) {
+        if (strcmp(map->layers.items[i].name, name) == 0) return &map->layers.items[i];
+    }
+    return NULL;
+}
+
+int tmx_find_object_group(const TmxMap *map, const char *name) {
+    for (size_t i = 0; i < map->object_groups.count; i++) {
+        if (strcmp(map->object_groups.items[i].name, name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+const TmxTileset *tmx_tileset_for_gid(const TmxMap *map, uint32_t gid) {
+    gid &= TMX_GID_MASK;
+    if (gid == 0) return NULL;
+
+    // The tileset a gid belongs to is the last one whose firstgid is not past it.
+    for (size_t i = map->tilesets.count; i > 0; i--) {
+        const TmxTileset *tileset = &map->tilesets.items[i - 1];
+        if (tileset->firstgid <= gid) {
+            return gid < tileset->firstgid + tileset->tilecount ? tileset : NULL;
+        }
+    }
+    return NULL;
+}
+
+uint8_t tmx_tile_flags(const TmxMap *map, uint32_t gid) {
+    gid &= TMX_GID_MASK;
+    return gid < map->tile_flags.count ? map->tile_flags.items[gid] : 0;
+}
+
+float tmx_tile_probability(const TmxMap *map, uint32_t gid) {
+    gid &= TMX_GID_MASK;
+    return gid < map->tile_probabilities.count ? map->tile_probabilities.items[gid] : -1.0f;
+}
@@ -0,0 +1,84 @@
+#ifndef TMX_H_
+#define TMX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Loader for the Tiled maps in resources/tilesets/. Supports what we actually use: orthogonal maps,
+// CSV encoded tile layers, object groups made of rectangles and external (.tsx) or inline tilesets.
+
+#define TMX_NAME_CAP 32
+#define TMX_PATH_CAP 256
+
+// The top bits of a gid in Tiled are flip flags, we don't do flipping so they are masked off.
+#define TMX_GID_MASK 0x1FFFFFFFu
+
+// Boolean tile properties we know about, set per tile in the tilesets (`<property name="farmable"
+// type="bool" value="true"/>`). Anything else in <properties> is ignored.
+typedef enum {
+    TMX_TILE_SOLID    = 1 << 0,
+    TMX_TILE_WATER    = 1 << 1,
+    TMX_TILE_FARMABLE = 1 << 2,
+    TMX_TILE_TILLABLE = 1 << 3,
+} TmxTileFlag;
+
+typedef struct TmxLayer {
+    char name[TMX_NAME_CAP];
+    // width * height gids, row major, 0 means no tile.
+    uint16_t *gids;
+} TmxLayer;
+
+typedef struct TmxObject {
+    uint32_t id;
+    // Index into TmxMap.object_groups.
+    uint32_t group;
+    // In map pixels, not scaled by MAP_SCALE.
+    float x, y, width, height;
+} TmxObject;
+
+typedef struct TmxObjectGroup {
+    char name[TMX_NAME_CAP];
+} TmxObjectGroup;
+
+typedef struct TmxTileset {
+    uint32_t firstgid;
+    uint32_t tilecount;
+    uint32_t columns;
+    uint32_t tilewidth, tileheight;
+    uint32_t image_width, image_height;
+    char name[TMX_NAME_CAP];
+    // Relative to the working directory, ready to hand to LoadTexture().
+    char image[TMX_PATH_CAP];
+} TmxTileset;
+
+typedef struct TmxMap {
+    int width, height;
+    int tilewidth, tileheight;
+
+    struct { TmxLayer *items; size_t count, capacity; } layers;
+    struct { TmxObjectGroup *items; size_t count, capacity; } object_groups;
+    struct { TmxObject *items; size_t count, capacity; } objects;
+    // Sorted by firstgid, the way Tiled writes them.
+    struct { TmxTileset *items; size_t count, capacity; } tilesets;
+    // TmxTileFlag bits, indexed by gid. Only as long as the highest gid that has any.
+    struct { uint8_t *items; size_t count, capacity; } tile_flags;
+    // The `probability` of every tile, indexed by gid, negative where the tileset doesn't give one.
+    // Only as long as the highest gid that has one.
+    struct { float *items; size_t count, capacity; } tile_probabilities;
+} TmxMap;
+
+bool tmx_load(const char *path, TmxMap *map);
+void tmx_free(TmxMap *map);
+
+const TmxLayer *tmx_find_layer(const TmxMap *map, const char *name);
+int tmx_find_object_group(const TmxMap *map, const char *name);
+// NULL for gid 0 or gids that no tileset claims.
+const TmxTileset *tmx_tileset_for_gid(const TmxMap *map, uint32_t gid);
+// TmxTileFlag bits of a gid, 0 for gid 0.
+uint8_t tmx_tile_flags(const TmxMap *map, uint32_t gid);
+// How likely Tiled is to pick the tile when it fills an area with random tiles, relative to the
+// others. Negative when the tileset doesn't say, Tiled goes with 1 then.
+float tmx_tile_probability(const TmxMap *map, uint32_t gid);
+
+#endif // TMX_H_